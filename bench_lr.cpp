@@ -0,0 +1,504 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/* Microbenchmarks for the HE and plaintext kernels used by lr_nag.
+ *
+ * Every kernel is timed in isolation: one warm-up call followed by a number of timed repetitions,
+ * summarized as mean / stddev / min / median / max. The sweep covers ring dimensions, OpenMP
+ * thread counts and (optionally) the composite-scaling variants. Results are written as JSON,
+ * one result object per line, and can be compared against a previously saved baseline.
+ */
+
+#include "openfhe.h"
+#include <algorithm>
+#include <getopt.h>
+#include <iostream>
+#include <sstream>
+#include "data_io.h"
+#include "lr_train_funcs.h"
+#include "lr_types.h"
+#include "shard_engine.h"
+#include "utils.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+std::string BENCH_X_FILE_DEF = "train_data/X_norm_1024.csv";
+std::string BENCH_Y_FILE_DEF = "train_data/y_1024.csv";
+std::string BENCH_OUT_FILE_DEF = "../results/bench_lr.json";
+usint BENCH_REPS_DEF(5);
+double BENCH_TOLERANCE_DEF(0.10);
+std::vector<uint32_t> LOGISTIC_DEGREES = {59, 119, 128};
+int CHEBYSHEV_RANGE_START = -16;
+int CHEBYSHEV_RANGE_END = 16;
+
+struct BenchConfig {
+  uint32_t ringDim;
+  int threads;
+  std::string scaling;  // "fixed", "cs32" or "cs64"
+};
+
+struct BenchResult {
+  std::string kernel;
+  BenchConfig config;
+  usint reps;
+  double meanMs;
+  double stddevMs;
+  double minMs;
+  double medianMs;
+  double maxMs;
+};
+
+std::vector<std::string> SplitList(const std::string &list) {
+  std::vector<std::string> out;
+  std::stringstream ss(list);
+  std::string tok;
+  while (getline(ss, tok, ',')) {
+    if (!tok.empty()) out.push_back(tok);
+  }
+  return out;
+}
+
+template<typename F>
+BenchResult TimeKernel(const std::string &kernel, const BenchConfig &config, usint reps, F kernelFn) {
+  kernelFn();  // warm-up: first calls populate NTT tables and key caches
+  std::vector<double> times;
+  for (usint r = 0; r < reps; r++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    kernelFn();
+    auto end = std::chrono::high_resolution_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+
+  BenchResult result{kernel, config, reps, 0, 0, 0, 0, 0};
+  double sum = 0;
+  for (auto t : times) sum += t;
+  result.meanMs = sum / reps;
+  double var = 0;
+  for (auto t : times) var += (t - result.meanMs) * (t - result.meanMs);
+  result.stddevMs = (reps > 1) ? std::sqrt(var / (reps - 1)) : 0.0;
+  std::sort(times.begin(), times.end());
+  result.minMs = times.front();
+  result.maxMs = times.back();
+  result.medianMs = (reps % 2) ? times[reps / 2] : 0.5 * (times[reps / 2 - 1] + times[reps / 2]);
+
+  std::cout << "\t" << kernel << ": mean " << result.meanMs << " ms, stddev " << result.stddevMs
+            << " ms, min " << result.minMs << " ms, median " << result.medianMs << " ms" << std::endl;
+  return result;
+}
+
+std::string ResultKey(const BenchResult &r) {
+  return r.kernel + "|" + std::to_string(r.config.ringDim) + "|" + std::to_string(r.config.threads) + "|" +
+      r.config.scaling;
+}
+
+void WriteJson(const std::string &filename, const std::vector<BenchResult> &results) {
+  std::ofstream ofs(filename, std::ofstream::out | std::ofstream::trunc);
+  if (!ofs.is_open()) {
+    std::cerr << "Could not open file to write benchmark results to " << filename << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  ofs.precision(dbl::max_digits10);
+  ofs << "{" << std::endl;
+  ofs << "  \"nativeint\": " << NATIVEINT << "," << std::endl;
+  ofs << "  \"results\": [" << std::endl;
+  for (size_t i = 0; i < results.size(); i++) {
+    auto &r = results[i];
+    ofs << "    {\"kernel\": \"" << r.kernel << "\", \"ringDim\": " << r.config.ringDim
+        << ", \"threads\": " << r.config.threads << ", \"scaling\": \"" << r.config.scaling
+        << "\", \"reps\": " << r.reps << ", \"mean_ms\": " << r.meanMs << ", \"stddev_ms\": " << r.stddevMs
+        << ", \"min_ms\": " << r.minMs << ", \"median_ms\": " << r.medianMs << ", \"max_ms\": " << r.maxMs << "}"
+        << ((i + 1 < results.size()) ? "," : "") << std::endl;
+  }
+  ofs << "  ]" << std::endl;
+  ofs << "}" << std::endl;
+}
+
+std::map<std::string, BenchResult> ReadBaseline(const std::string &filename) {
+  std::ifstream ifs(filename);
+  if (!ifs.is_open()) {
+    std::cerr << "Could not open baseline file " << filename << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::map<std::string, BenchResult> baseline;
+  std::string line;
+  while (getline(ifs, line)) {
+    if (line.find("\"kernel\"") == std::string::npos) continue;
+    BenchResult r;
+    r.kernel = JsonField(line, "kernel");
+    r.config.ringDim = std::stoul(JsonField(line, "ringDim"));
+    r.config.threads = std::stoi(JsonField(line, "threads"));
+    r.config.scaling = JsonField(line, "scaling");
+    r.reps = std::stoul(JsonField(line, "reps"));
+    r.meanMs = std::stod(JsonField(line, "mean_ms"));
+    r.stddevMs = std::stod(JsonField(line, "stddev_ms"));
+    r.minMs = std::stod(JsonField(line, "min_ms"));
+    r.medianMs = std::stod(JsonField(line, "median_ms"));
+    r.maxMs = std::stod(JsonField(line, "max_ms"));
+    baseline[ResultKey(r)] = r;
+  }
+  return baseline;
+}
+
+// Compares medians against the baseline. Returns the number of kernels slower than tolerance.
+int CompareToBaseline(const std::vector<BenchResult> &results, const std::string &baselineFile, double tolerance) {
+  auto baseline = ReadBaseline(baselineFile);
+  int numRegressions = 0;
+  std::cout << "Comparison against baseline " << baselineFile << " (median, tolerance " << tolerance * 100
+            << "%)" << std::endl;
+  for (auto &r : results) {
+    auto found = baseline.find(ResultKey(r));
+    if (found == baseline.end()) {
+      std::cout << "\t" << ResultKey(r) << ": not in baseline" << std::endl;
+      continue;
+    }
+    double ratio = r.medianMs / found->second.medianMs;
+    std::string verdict = "ok";
+    if (ratio > 1.0 + tolerance) {
+      verdict = "REGRESSION";
+      numRegressions++;
+    } else if (ratio < 1.0 - tolerance) {
+      verdict = "improved";
+    }
+    std::cout << "\t" << ResultKey(r) << ": " << found->second.medianMs << " ms -> " << r.medianMs << " ms ("
+              << ratio << "x) " << verdict << std::endl;
+  }
+  return numRegressions;
+}
+
+CC GenBenchContext(const BenchConfig &config, uint32_t &multDepth, std::vector<uint32_t> &levelBudget) {
+  CryptoParams parameters;
+#if NATIVEINT == 128
+  uint32_t firstModSize = 89;
+  uint32_t dcrtBits = 78;
+#else
+  uint32_t firstModSize = 60;
+  uint32_t dcrtBits = 59;
+#endif
+  lbcrypto::ScalingTechnique rsTech = lbcrypto::FIXEDAUTO;
+  uint32_t registerWordSize = 32;
+  if (config.scaling != "fixed") {
+    rsTech = lbcrypto::COMPOSITESCALINGAUTO;
+    registerWordSize = (config.scaling == "cs64") ? 64 : 32;
+  }
+
+  // Same bootstrapping configuration as lr_nag, sized for the deepest logistic degree we time
+  lbcrypto::SecretKeyDist skDist = lbcrypto::UNIFORM_TERNARY;
+  levelBudget = {2, 2};
+  uint32_t levelsBeforeBootstrap = 15;
+  uint32_t approxBootstrapDepth = 8;
+  multDepth = levelsBeforeBootstrap + lbcrypto::FHECKKSRNS::GetBootstrapDepth(
+      approxBootstrapDepth, levelBudget, skDist
+  );
+
+  parameters.SetSecretKeyDist(skDist);
+  parameters.SetMultiplicativeDepth(multDepth);
+  parameters.SetScalingModSize(dcrtBits);
+  parameters.SetFirstModSize(firstModSize);
+  parameters.SetBatchSize(config.ringDim / 2);
+  parameters.SetSecurityLevel(lbcrypto::HEStd_NotSet);
+  parameters.SetRingDim(config.ringDim);
+  parameters.SetScalingTechnique(rsTech);
+  parameters.SetKeySwitchTechnique(lbcrypto::HYBRID);
+  parameters.SetRegisterWordSize(registerWordSize);
+
+  CC cc = GenCryptoContext(parameters);
+  cc->Enable(lbcrypto::PKE);
+  cc->Enable(lbcrypto::KEYSWITCH);
+  cc->Enable(lbcrypto::LEVELEDSHE);
+  cc->Enable(lbcrypto::ADVANCEDSHE);
+  cc->Enable(lbcrypto::FHE);
+  return cc;
+}
+
+/* Times the full gradient over the data split into max(shardWorkers) shards, once per entry of
+ * shardWorkers, with the configured OpenMP threads split between the shard workers.
+ */
+void RunShardedGradient(const BenchConfig &config, usint reps, CC &cc, const KeyPair &keys, Mat &X, Mat &y,
+                        usint rowSize, usint numSlots, const MatKeys &evalSumRowKeys, const MatKeys &evalSumColKeys,
+                        const std::vector<usint> &shardWorkers, std::vector<BenchResult> &results) {
+  usint numShards = *std::max_element(shardWorkers.begin(), shardWorkers.end());
+  usint rowsPerShard = (X.size() + numShards - 1) / numShards;
+  Mat NegXt = InitializeLogReg(X, y, 0.1 / y.size());
+  auto shards = EncryptShards(cc, X, NegXt, y, rowSize, numSlots, rowsPerShard, keys);
+  Mat beta(X[0].size(), Vec(1, 0.01));
+  CT ctTheta = collateOneDMats2CtVRC(cc, beta, beta, rowSize, numSlots, keys);
+
+  for (auto workers : shardWorkers) {
+    auto execConfig = SplitThreads(shards.size(), workers, config.threads);
+    ShardedGradientEngine engine(cc, shards, rowSize, evalSumRowKeys, evalSumColKeys, keys, execConfig);
+    CT ctGradient;
+    std::string kernel = "ShardedGradient_s" + std::to_string(shards.size()) + "_w" +
+        std::to_string(execConfig.shardWorkers);
+    results.push_back(TimeKernel(kernel, config, reps, [&]() {
+      engine.CalculateGradient(ctTheta, ctGradient, CHEBYSHEV_RANGE_START, CHEBYSHEV_RANGE_END, LOGISTIC_DEGREES[0]);
+    }));
+  }
+#ifdef _OPENMP
+  omp_set_num_threads(config.threads);
+#endif
+}
+
+// Speedup of every sharded gradient result over the one with the fewest threads and a single worker
+void PrintShardSpeedups(std::ostream &os, const std::vector<BenchResult> &results) {
+  std::map<std::string, const BenchResult *> reference;  // per ring dimension and scaling
+  for (auto &r : results) {
+    if (r.kernel.rfind("ShardedGradient_", 0) != 0 || r.kernel.substr(r.kernel.size() - 3) != "_w1") continue;
+    auto group = std::to_string(r.config.ringDim) + "|" + r.config.scaling;
+    auto found = reference.find(group);
+    if (found == reference.end() || r.config.threads < found->second->config.threads) reference[group] = &r;
+  }
+  if (reference.empty()) return;
+  os << "Sharded gradient speedups (median, relative to 1 worker at the lowest thread count)" << std::endl;
+  for (auto &r : results) {
+    if (r.kernel.rfind("ShardedGradient_", 0) != 0) continue;
+    auto found = reference.find(std::to_string(r.config.ringDim) + "|" + r.config.scaling);
+    if (found == reference.end()) continue;
+    os << "\t" << ResultKey(r) << ": " << found->second->medianMs / r.medianMs << "x" << std::endl;
+  }
+}
+
+void RunConfig(const BenchConfig &config, usint reps, const Mat &fullX, const Mat &fullY,
+               const std::vector<usint> &shardWorkers, std::vector<BenchResult> &results) {
+#ifdef _OPENMP
+  omp_set_num_threads(config.threads);
+#endif
+  std::cout << "Ring dimension " << config.ringDim << ", threads " << config.threads << ", scaling "
+            << config.scaling << std::endl;
+
+  uint32_t multDepth;
+  std::vector<uint32_t> levelBudget;
+  CC cc = GenBenchContext(config, multDepth, levelBudget);
+  KeyPair keys = cc->KeyGen();
+  cc->EvalMultKeyGen(keys.secretKey);
+  cc->EvalSumKeyGen(keys.secretKey);
+
+  usint numSlots = cc->GetEncodingParams()->GetBatchSize();
+  auto dims = ComputePaddedDimensions(fullX.size(), fullX[0].size(), numSlots);
+  usint colSize = dims.first;
+  usint rowSize = dims.second;
+
+  // keep only the rows that fit into one ciphertext at this ring dimension
+  usint numRows = std::min(usint(fullX.size()), colSize);
+  Mat X(fullX.begin(), fullX.begin() + numRows);
+  Mat y(fullY.begin(), fullY.begin() + numRows);
+  Mat beta(X[0].size(), Vec(1, 0.01));
+
+  int signedRowSize = (int) rowSize;
+  cc->EvalRotateKeyGen(keys.secretKey, {-signedRowSize, signedRowSize});
+  MatKeys evalSumRowKeys = cc->EvalSumRowsKeyGen(keys.secretKey, nullptr, rowSize);
+  MatKeys evalSumColKeys = cc->EvalSumColsKeyGen(keys.secretKey);
+
+  auto numSlotsBoot = NextPow2(X[0].size()) * 8;
+  cc->EvalBootstrapSetup(levelBudget, {0, 0}, numSlotsBoot);
+  cc->EvalBootstrapKeyGen(keys.secretKey, numSlotsBoot);
+
+  // Encoding helpers from utils.cpp (encode + encrypt)
+  results.push_back(TimeKernel("Mat2CtMRM", config, reps, [&]() {
+    Mat2CtMRM(cc, X, rowSize, numSlots, keys);
+  }));
+  results.push_back(TimeKernel("OneDMat2CtVCC", config, reps, [&]() {
+    OneDMat2CtVCC(cc, y, rowSize, numSlots, keys);
+  }));
+  results.push_back(TimeKernel("collateOneDMats2CtVRC", config, reps, [&]() {
+    collateOneDMats2CtVRC(cc, beta, beta, rowSize, numSlots, keys);
+  }));
+
+  CT ctX = Mat2CtMRM(cc, X, rowSize, numSlots, keys);
+  CT ctY = OneDMat2CtVCC(cc, y, rowSize, numSlots, keys);
+  CT ctTheta = collateOneDMats2CtVRC(cc, beta, beta, rowSize, numSlots, keys);
+  CT ctOut;
+
+  results.push_back(TimeKernel("MatrixVectorProductRow", config, reps, [&]() {
+    MatrixVectorProductRow(cc, keys, evalSumColKeys, ctX, ctTheta, rowSize, ctOut);
+  }));
+  results.push_back(TimeKernel("MatrixVectorProductCol", config, reps, [&]() {
+    MatrixVectorProductCol(cc, evalSumRowKeys, ctX, ctY, rowSize, ctOut);
+  }));
+
+  // Single operations, for the packing planner's cost model (lr_nag -P)
+  PT ptOnes = cc->MakeCKKSPackedPlaintext(Vec(numSlots, 1.0));
+  results.push_back(TimeKernel("EvalRotate", config, reps, [&]() {
+    cc->EvalRotate(ctX, signedRowSize);
+  }));
+  results.push_back(TimeKernel("EvalMult", config, reps, [&]() {
+    cc->EvalMult(ctX, ctTheta);
+  }));
+  results.push_back(TimeKernel("EvalMultPlain", config, reps, [&]() {
+    cc->EvalMult(ctX, ptOnes);
+  }));
+  results.push_back(TimeKernel("EvalAdd", config, reps, [&]() {
+    cc->EvalAdd(ctX, ctTheta);
+  }));
+
+  CT ctLogits;
+  MatrixVectorProductRow(cc, keys, evalSumColKeys, ctX, ctTheta, rowSize, ctLogits);
+  for (auto degree : LOGISTIC_DEGREES) {
+    results.push_back(TimeKernel("EvalLogistic_" + std::to_string(degree), config, reps, [&]() {
+      // cached coefficients + EvalChebyshevSeries, exactly what training runs
+      TracedEvalLogistic(cc, ctLogits, CHEBYSHEV_RANGE_START, CHEBYSHEV_RANGE_END, degree);
+    }));
+  }
+
+  // Bootstrap a sparsely packed ciphertext that has exhausted its levels, as in the training loop
+  Vec weights(numSlotsBoot, 0.01);
+  PT ptWeights = cc->MakeCKKSPackedPlaintext(weights, 1, multDepth - 1, nullptr, numSlotsBoot);
+  CT ctWeights = cc->Encrypt(keys.publicKey, ptWeights);
+  results.push_back(TimeKernel("EvalBootstrap_" + std::to_string(numSlotsBoot), config, reps, [&]() {
+    cc->EvalBootstrap(ctWeights);
+  }));
+#if NATIVEINT == 64
+  results.push_back(TimeKernel("EvalBootstrap2_" + std::to_string(numSlotsBoot), config, reps, [&]() {
+    cc->EvalBootstrap(ctWeights, 2, 17);
+  }));
+#endif
+
+  results.push_back(TimeKernel("ReEncrypt", config, reps, [&]() {
+    CT ctCopy = ctTheta;
+    ReEncrypt(cc, ctCopy, keys);
+  }));
+
+  results.push_back(TimeKernel("ComputeLoss", config, reps, [&]() {
+    ComputeLoss(beta, X, y);
+  }));
+
+  if (!shardWorkers.empty()) {
+    RunShardedGradient(config, reps, cc, keys, X, y, rowSize, numSlots, evalSumRowKeys, evalSumColKeys,
+                       shardWorkers, results);
+  }
+
+  cc->ClearEvalMultKeys();
+  cc->ClearEvalAutomorphismKeys();
+  lbcrypto::CryptoContextFactory::ReleaseAllContexts();
+}
+
+int main(int argc, char *argv[]) {
+  std::string ringDims = "65536";
+  std::string threadList;
+  bool sweepCS = false;
+  usint reps = BENCH_REPS_DEF;
+  std::string xFile = BENCH_X_FILE_DEF;
+  std::string yFile = BENCH_Y_FILE_DEF;
+  std::string outFile = BENCH_OUT_FILE_DEF;
+  std::string baselineFile;
+  double tolerance = BENCH_TOLERANCE_DEF;
+  std::string shardWorkerList;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "d:t:cn:x:y:o:B:T:s:h")) != -1) {
+    switch (opt) {
+      case 'd':ringDims = optarg;
+        break;
+      case 't':threadList = optarg;
+        break;
+      case 'c':sweepCS = true;
+        break;
+      case 'n':reps = atoi(optarg);
+        break;
+      case 'x':xFile = optarg;
+        break;
+      case 'y':yFile = optarg;
+        break;
+      case 'o':outFile = optarg;
+        break;
+      case 'B':baselineFile = optarg;
+        break;
+      case 'T':tolerance = atof(optarg);
+        break;
+      case 's':shardWorkerList = optarg;
+        break;
+      case 'h':
+      default: /* '?' */
+        std::cerr << "Usage: " << std::endl
+                  << "arguments:" << std::endl
+                  << "  -d <comma separated ring dimensions> [65536]" << std::endl
+                  << "  -t <comma separated OpenMP thread counts> [max threads]" << std::endl
+                  << "  -c also sweep composite scaling (32 and 64-bit register words) [false]" << std::endl
+                  << "  -n <timed repetitions per kernel> [" << BENCH_REPS_DEF << "]" << std::endl
+                  << "  -x <X file name> [" << BENCH_X_FILE_DEF << "]" << std::endl
+                  << "  -y <y file name> [" << BENCH_Y_FILE_DEF << "]" << std::endl
+                  << "  -o <JSON output file> [" << BENCH_OUT_FILE_DEF << "]" << std::endl
+                  << "  -B <baseline JSON file to compare against> []" << std::endl
+                  << "  -T <relative regression tolerance> [" << BENCH_TOLERANCE_DEF << "]" << std::endl
+                  << "  -s <comma separated shard worker counts; the data is split into the largest> []"
+                  << std::endl
+                  << "  -h prints this message" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+  }
+  if (reps == 0) reps = 1;
+
+  if (threadList.empty()) {
+#ifdef _OPENMP
+    threadList = std::to_string(omp_get_max_threads());
+#else
+    threadList = "1";
+#endif
+  }
+  std::vector<usint> shardWorkers;
+  for (auto &workers : SplitList(shardWorkerList)) {
+    shardWorkers.push_back(std::max(1, std::stoi(workers)));
+  }
+  std::vector<std::string> scalings = {"fixed"};
+  if (sweepCS) {
+    scalings.push_back("cs32");
+    scalings.push_back("cs64");
+  }
+
+  Mat X, y;
+  std::vector<std::string> featureNames, labelNames;
+  LoadDataFile(xFile, X, featureNames, -1, false);
+  LoadDataFile(yFile, y, labelNames, -1, false);
+
+  std::vector<BenchResult> results;
+  for (auto &ringDim : SplitList(ringDims)) {
+    for (auto &threads : SplitList(threadList)) {
+      for (auto &scaling : scalings) {
+        BenchConfig config{uint32_t(std::stoul(ringDim)), std::stoi(threads), scaling};
+        RunConfig(config, reps, X, y, shardWorkers, results);
+      }
+    }
+  }
+
+  WriteJson(outFile, results);
+  std::cout << "Wrote " << results.size() << " results to " << outFile << std::endl;
+  PrintShardSpeedups(std::cout, results);
+
+  if (!baselineFile.empty()) {
+    int numRegressions = CompareToBaseline(results, baselineFile, tolerance);
+    if (numRegressions > 0) {
+      std::cout << numRegressions << " kernel(s) regressed beyond tolerance" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "bootstrap_schedule.h"
+#include <cmath>
+#include <iostream>
+
+BootstrapPrecisionSchedule::BootstrapPrecisionSchedule(int precision, double switchFraction, double tolerance)
+    : precision(precision), switchFraction(switchFraction), tolerance(tolerance) {
+  if (Enabled() && switchFraction <= 0) Switch(0, "configured");
+}
+
+uint32_t BootstrapPrecisionSchedule::Iterations(usint iteration, usint numIters) {
+  if (!Enabled()) return 1;
+  if (!switched && iteration >= switchFraction * numIters) Switch(iteration, "iteration count");
+  return switched ? 2 : 1;
+}
+
+void BootstrapPrecisionSchedule::ObserveLoss(usint iteration, double loss) {
+  if (haveLoss && iteration > lastLossIteration && lastLoss != 0 && tolerance > 0 && !switched && Enabled()) {
+    // relative change per iteration, so sparse measurements (-l) compare like dense ones
+    double change = (loss - lastLoss) / (std::abs(lastLoss) * (iteration - lastLossIteration));
+    if (change > tolerance) {
+      Switch(iteration, "loss increased");
+    } else if (std::abs(change) < tolerance) {
+      Switch(iteration, "converging");
+    }
+  }
+  haveLoss = true;
+  lastLossIteration = iteration;
+  lastLoss = loss;
+}
+
+void BootstrapPrecisionSchedule::Record(uint32_t iterations, double ms) {
+  if (iterations > 1) {
+    numDouble++;
+    doubleMs += ms;
+  } else {
+    numSingle++;
+    singleMs += ms;
+  }
+}
+
+void BootstrapPrecisionSchedule::Switch(usint iteration, const char *reason) {
+  switched = true;
+  switchIteration = iteration;
+  switchReason = reason;
+  if (iteration > 0) {
+    std::cout << "\tSwitching to double bootstrapping at " << precision << " bits (" << reason << ")" << std::endl;
+  }
+}
+
+void BootstrapPrecisionSchedule::Report(std::ostream &os) const {
+  os << "Bootstraps: " << numSingle << " single (" << singleMs / 1000.0 << " s), " << numDouble << " double ("
+     << doubleMs / 1000.0 << " s)";
+  if (switched) {
+    os << ", double from iteration " << switchIteration << " (" << switchReason << ")";
+  }
+  os << std::endl;
+}
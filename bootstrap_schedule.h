@@ -0,0 +1,87 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__BOOTSTRAP_SCHEDULE_H_
+#define DPRIVE_ML__BOOTSTRAP_SCHEDULE_H_
+
+#include <ostream>
+#include "lr_types.h"
+
+////////// Single vs. double bootstrapping per refresh (64-bit builds) ///////////////////////////////
+
+/* Double bootstrapping (EvalBootstrap(ct, 2, precision)) costs about two bootstraps. Its extra precision only
+ * matters once the NAG steps get as small as the single-bootstrap error, i.e. near convergence. The
+ * schedule starts with single bootstraps and latches to double ones, for the rest of the run, at the first of:
+ *  - the iteration switchFraction * numIters, so the last stretch of a run is always refreshed precisely;
+ *  - a measured loss that changed by less than tolerance (relative, per iteration) since the previous
+ *    measurement: the weights have almost stopped moving;
+ *  - a measured loss that rose by more than tolerance per iteration: the bootstrapping error is pushing
+ *    the weights around more than the gradient.
+ * The losses come from whatever the trainer already decrypts (encrypted loss, monitoring); without them only
+ * the iteration count applies.
+ */
+class BootstrapPrecisionSchedule {
+ public:
+  // precision <= 0 never double-bootstraps; switchFraction 0 double-bootstraps from the start (the plain -e)
+  BootstrapPrecisionSchedule(int precision, double switchFraction, double tolerance);
+
+  bool Enabled() const { return precision > 0; }
+  int Precision() const { return precision; }
+
+  // EvalBootstrap iterations (1 or 2) for a refresh before this iteration
+  uint32_t Iterations(usint iteration, usint numIters);
+
+  void ObserveLoss(usint iteration, double loss);
+
+  // bootstrapping time, for the report
+  void Record(uint32_t iterations, double ms);
+
+  void Report(std::ostream &os) const;
+
+ private:
+  void Switch(usint iteration, const char *reason);
+
+  int precision;
+  double switchFraction;
+  double tolerance;
+  bool switched = false;
+  usint switchIteration = 0;
+  const char *switchReason = "";
+  bool haveLoss = false;
+  usint lastLossIteration = 0;
+  double lastLoss = 0;
+  usint numSingle = 0;
+  usint numDouble = 0;
+  double singleMs = 0;
+  double doubleMs = 0;
+};
+
+#endif //DPRIVE_ML__BOOTSTRAP_SCHEDULE_H_
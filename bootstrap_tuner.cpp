@@ -0,0 +1,276 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "bootstrap_tuner.h"
+#include <algorithm>
+#include <iomanip>
+#include <random>
+
+std::string BootstrapTuneKey::Canonical() const {
+  std::stringstream ss;
+  ss << "ring=" << ringDim << ";dcrt=" << dcrtBits << ";first=" << firstModSize
+     << ";levels=" << levelsBeforeBootstrap << ";features=" << numFeaturesEnc << ";sec=" << int(securityLevel)
+     << ";rs=" << int(scalingTechnique) << ";word=" << registerWordSize << ";native=" << NATIVEINT;
+  return ss.str();
+}
+
+std::string BootstrapTuneKey::Hash() const {
+  // FNV-1a, so that cache files stay valid across compilers (unlike std::hash)
+  uint64_t hash = 1469598103934665603ULL;
+  for (auto c : Canonical()) {
+    hash ^= uint8_t(c);
+    hash *= 1099511628211ULL;
+  }
+  std::stringstream ss;
+  ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return ss.str();
+}
+
+void PrintBootstrapConfig(std::ostream &os, const BootstrapConfig &config) {
+  os << "levelBudget {" << config.levelBudget[0] << ", " << config.levelBudget[1] << "}, bsgsDim {"
+     << config.bsgsDim[0] << ", " << config.bsgsDim[1] << "}, approx depth " << config.approxBootstrapDepth
+     << ", skDist " << config.skDist << ", slots " << config.numSlotsBoot;
+}
+
+bool LookupTunedBootstrap(const std::string &cacheFile, const BootstrapTuneKey &key, BootstrapTuneResult &result) {
+  std::ifstream ifs(cacheFile);
+  if (!ifs.is_open()) return false;
+
+  bool found = false;
+  std::string line;
+  while (getline(ifs, line)) {
+    std::stringstream ss(line);
+    std::string hash;
+    std::string canonical;
+    ss >> hash >> canonical;
+    if (hash != key.Hash() || canonical != key.Canonical()) continue;
+
+    BootstrapTuneResult entry;
+    entry.config.levelBudget.resize(2);
+    entry.config.bsgsDim.resize(2);
+    int skDist;
+    ss >> entry.config.levelBudget[0] >> entry.config.levelBudget[1]
+       >> entry.config.bsgsDim[0] >> entry.config.bsgsDim[1]
+       >> entry.config.approxBootstrapDepth >> skDist >> entry.config.numSlotsBoot
+       >> entry.multDepth >> entry.timeMs >> entry.precisionBits;
+    if (ss.fail()) continue;
+    entry.config.skDist = lbcrypto::SecretKeyDist(skDist);
+    result = entry;
+    found = true;
+  }
+  return found;
+}
+
+void StoreTunedBootstrap(const std::string &cacheFile, const BootstrapTuneKey &key, const BootstrapTuneResult &result) {
+  std::ofstream ofs(cacheFile, std::ofstream::out | std::ofstream::app);
+  if (!ofs.is_open()) {
+    std::cerr << "Could not open bootstrap tuning cache " << cacheFile << std::endl;
+    return;
+  }
+  auto &c = result.config;
+  ofs << key.Hash() << " " << key.Canonical() << " "
+      << c.levelBudget[0] << " " << c.levelBudget[1] << " " << c.bsgsDim[0] << " " << c.bsgsDim[1] << " "
+      << c.approxBootstrapDepth << " " << int(c.skDist) << " " << c.numSlotsBoot << " "
+      << result.multDepth << " " << result.timeMs << " " << result.precisionBits << std::endl;
+}
+
+static CC GenTuneContext(const BootstrapTuneKey &key, const BootstrapConfig &config, uint32_t &multDepth) {
+  multDepth = key.levelsBeforeBootstrap + lbcrypto::FHECKKSRNS::GetBootstrapDepth(
+      config.approxBootstrapDepth, config.levelBudget, config.skDist
+  );
+  CryptoParams parameters;
+  parameters.SetSecretKeyDist(config.skDist);
+  parameters.SetMultiplicativeDepth(multDepth);
+  parameters.SetScalingModSize(key.dcrtBits);
+  parameters.SetFirstModSize(key.firstModSize);
+  parameters.SetBatchSize(key.ringDim / 2);
+  parameters.SetSecurityLevel(key.securityLevel);
+  parameters.SetRingDim(key.ringDim);
+  parameters.SetScalingTechnique(key.scalingTechnique);
+  parameters.SetKeySwitchTechnique(lbcrypto::HYBRID);
+  parameters.SetRegisterWordSize(key.registerWordSize);
+
+  CC cc = GenCryptoContext(parameters);
+  cc->Enable(lbcrypto::PKE);
+  cc->Enable(lbcrypto::KEYSWITCH);
+  cc->Enable(lbcrypto::LEVELEDSHE);
+  cc->Enable(lbcrypto::ADVANCEDSHE);
+  cc->Enable(lbcrypto::FHE);
+  return cc;
+}
+
+// Times EvalBootstrap on a ciphertext packed like ctWeights (theta/phi blocks of numFeaturesEnc repeating)
+// and measures the precision of the result
+static BootstrapTuneResult MeasureCandidate(
+    CC &cc, const KeyPair &keys, const BootstrapTuneKey &key, const BootstrapConfig &config,
+    uint32_t multDepth, usint reps) {
+  cc->EvalBootstrapSetup(config.levelBudget, config.bsgsDim, config.numSlotsBoot);
+  cc->EvalBootstrapKeyGen(keys.secretKey, config.numSlotsBoot);
+
+  usint numSlots = cc->GetEncodingParams()->GetBatchSize();
+  usint period = 2 * key.numFeaturesEnc;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  Vec block(period);
+  for (auto &v : block) v = dist(gen);
+  Vec weights(numSlots);
+  for (usint i = 0; i < numSlots; i++) weights[i] = block[i % period];
+
+  PT ptWeights = cc->MakeCKKSPackedPlaintext(weights, 1, multDepth - 1);
+  CT ctWeights = cc->Encrypt(keys.publicKey, ptWeights);
+  ctWeights->SetSlots(config.numSlotsBoot);
+
+  CT ctBoot = cc->EvalBootstrap(ctWeights);  // warm-up
+  std::vector<double> times;
+  for (usint r = 0; r < reps; r++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    ctBoot = cc->EvalBootstrap(ctWeights);
+    auto end = std::chrono::high_resolution_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  std::sort(times.begin(), times.end());
+
+  PT ptBoot;
+  cc->Decrypt(keys.secretKey, ctBoot, &ptBoot);
+  auto values = ptBoot->GetRealPackedValue();
+  double maxErr = 0;
+  for (usint i = 0; i < values.size(); i++) {
+    maxErr = std::max(maxErr, std::abs(values[i] - block[i % period]));
+  }
+
+  BootstrapTuneResult result;
+  result.config = config;
+  result.multDepth = multDepth;
+  result.timeMs = times[times.size() / 2];
+  result.precisionBits = (maxErr > 0) ? -std::log2(maxErr) : 64.0;
+  return result;
+}
+
+BootstrapTuneResult AutotuneBootstrap(
+    const BootstrapTuneKey &key,
+    const BootstrapConfig &baseline,
+    bool allowSparseSecret,
+    usint reps,
+    double maxPrecisionLossBits) {
+
+  std::vector<lbcrypto::SecretKeyDist> skDists = {lbcrypto::UNIFORM_TERNARY};
+  if (allowSparseSecret) {
+    skDists.push_back(lbcrypto::SPARSE_TERNARY);
+#ifdef LR_WITH_SPARSE_ENCAPSULATED
+    skDists.push_back(lbcrypto::SPARSE_ENCAPSULATED);
+#endif
+  }
+  std::vector<std::vector<uint32_t>> levelBudgets = {{1, 1}, {2, 1}, {2, 2}, {3, 2}, {3, 3}};
+  std::vector<std::vector<uint32_t>> bsgsDims = {{0, 0}, {4, 4}, {8, 8}};
+  // theta and phi blocks repeat every 2 * numFeaturesEnc slots, so that is the smallest sparse slot count
+  std::vector<uint32_t> slotCounts = {key.numFeaturesEnc * 2, key.numFeaturesEnc * 4, key.numFeaturesEnc * 8};
+
+  std::vector<BootstrapTuneResult> measured;
+  BootstrapTuneResult baselineResult{};
+  bool haveBaseline = false;
+
+  std::cout << "*********************************************" << std::endl;
+  std::cout << "Autotuning bootstrapping for " << key.Canonical() << std::endl;
+  for (auto skDist : skDists) {
+    for (auto &levelBudget : levelBudgets) {
+      BootstrapConfig contextConfig{levelBudget, {0, 0}, baseline.approxBootstrapDepth, skDist, 0};
+      uint32_t multDepth;
+      try {
+        CC cc = GenTuneContext(key, contextConfig, multDepth);
+        KeyPair keys = cc->KeyGen();
+        cc->EvalMultKeyGen(keys.secretKey);
+
+        for (auto &bsgsDim : bsgsDims) {
+          for (auto numSlotsBoot : slotCounts) {
+            if (std::max(bsgsDim[0], bsgsDim[1]) > numSlotsBoot) continue;
+            BootstrapConfig config{levelBudget, bsgsDim, baseline.approxBootstrapDepth, skDist, numSlotsBoot};
+            std::cout << "\t";
+            PrintBootstrapConfig(std::cout, config);
+            try {
+              auto result = MeasureCandidate(cc, keys, key, config, multDepth, reps);
+              std::cout << ": " << result.timeMs << " ms, " << result.precisionBits << " bits, multDepth "
+                        << result.multDepth << std::endl;
+              measured.push_back(result);
+              if (config.levelBudget == baseline.levelBudget && config.bsgsDim == baseline.bsgsDim &&
+                  config.skDist == baseline.skDist && config.numSlotsBoot == baseline.numSlotsBoot) {
+                baselineResult = result;
+                haveBaseline = true;
+              }
+            } catch (std::exception &e) {
+              std::cout << ": skipped (" << e.what() << ")" << std::endl;
+            }
+          }
+        }
+        cc->ClearEvalMultKeys();
+        cc->ClearEvalAutomorphismKeys();
+        lbcrypto::CryptoContextFactory::ReleaseAllContexts();
+      } catch (std::exception &e) {
+        std::cout << "\tskDist " << skDist << " with level budget {" << levelBudget[0] << ", " << levelBudget[1]
+                  << "} skipped (" << e.what() << ")" << std::endl;
+      }
+    }
+  }
+
+  if (measured.empty()) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: no bootstrapping candidate could be evaluated"));
+  }
+
+  // Precision floor: the baseline's precision minus the allowed loss, or the best precision seen
+  double bestPrecision = 0;
+  for (auto &r : measured) bestPrecision = std::max(bestPrecision, r.precisionBits);
+  double precisionFloor = (haveBaseline ? baselineResult.precisionBits : bestPrecision) - maxPrecisionLossBits;
+
+  const BootstrapTuneResult *winner = nullptr;
+  for (auto &r : measured) {
+    if (r.precisionBits < precisionFloor) continue;
+    // ties in time go to the shallower context, which makes every other operation cheaper too
+    if (!winner || r.timeMs < winner->timeMs ||
+        (r.timeMs == winner->timeMs && r.multDepth < winner->multDepth)) {
+      winner = &r;
+    }
+  }
+  if (!winner) winner = haveBaseline ? &baselineResult : &measured.front();
+
+  std::cout << "Selected bootstrapping configuration: ";
+  PrintBootstrapConfig(std::cout, winner->config);
+  std::cout << " (" << winner->timeMs << " ms, " << winner->precisionBits << " bits, precision floor "
+            << precisionFloor << " bits)" << std::endl;
+  if (IsSparseSecret(winner->config.skDist)) {
+    std::cout << "WARNING: the selected secret key distribution is sparser than the HE standard assumes" << std::endl;
+  }
+  return *winner;
+}
+
+bool IsSparseSecret(lbcrypto::SecretKeyDist skDist) {
+  return skDist == lbcrypto::SPARSE_TERNARY || skDist == lbcrypto::SPARSE_ENCAPSULATED;
+}
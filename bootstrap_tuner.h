@@ -0,0 +1,101 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__BOOTSTRAP_TUNER_H_
+#define DPRIVE_ML__BOOTSTRAP_TUNER_H_
+
+#include <string>
+#include <vector>
+#include "openfhe.h"
+#include "lr_types.h"
+
+////////// Bootstrapping configuration autotuning ///////////////////////////////
+
+struct BootstrapConfig {
+  std::vector<uint32_t> levelBudget;
+  std::vector<uint32_t> bsgsDim;
+  uint32_t approxBootstrapDepth;
+  lbcrypto::SecretKeyDist skDist;
+  uint32_t numSlotsBoot;
+};
+
+/* Everything outside the bootstrapping configuration that changes its cost or precision.
+ * Tuned results are cached per hash of these values.
+ */
+struct BootstrapTuneKey {
+  uint32_t ringDim;
+  uint32_t dcrtBits;
+  uint32_t firstModSize;
+  uint32_t levelsBeforeBootstrap;
+  uint32_t numFeaturesEnc;
+  lbcrypto::SecurityLevel securityLevel;
+  lbcrypto::ScalingTechnique scalingTechnique;
+  uint32_t registerWordSize;
+
+  std::string Canonical() const;
+  std::string Hash() const;
+};
+
+struct BootstrapTuneResult {
+  BootstrapConfig config;
+  uint32_t multDepth;
+  double timeMs;         // median EvalBootstrap time
+  double precisionBits;  // -log2 of the max absolute error after bootstrapping
+};
+
+/* Returns true and fills result if cacheFile holds an entry for key (the latest one wins).
+ */
+bool LookupTunedBootstrap(const std::string &cacheFile, const BootstrapTuneKey &key, BootstrapTuneResult &result);
+
+/* Appends the tuned result for key to cacheFile.
+ */
+void StoreTunedBootstrap(const std::string &cacheFile, const BootstrapTuneKey &key, const BootstrapTuneResult &result);
+
+/* Microbenchmarks the candidate level budgets, BSGS dimensions and sparse slot counts on this machine.
+ * Every candidate's precision is measured on a weights-shaped ciphertext; candidates losing more than
+ * maxPrecisionLossBits against the baseline configuration are rejected, and the fastest remaining one is
+ * returned. The secret key is UNIFORM_TERNARY, which the HE-standard parameters assume, unless
+ * allowSparseSecret also admits SPARSE_TERNARY: it is faster but a weaker secret distribution.
+ */
+BootstrapTuneResult AutotuneBootstrap(
+    const BootstrapTuneKey &key,
+    const BootstrapConfig &baseline,
+    bool allowSparseSecret = false,
+    usint reps = 3,
+    double maxPrecisionLossBits = 2.0
+);
+
+// True for secret key distributions sparser than the HE standard assumes
+bool IsSparseSecret(lbcrypto::SecretKeyDist skDist);
+
+void PrintBootstrapConfig(std::ostream &os, const BootstrapConfig &config);
+
+#endif //DPRIVE_ML__BOOTSTRAP_TUNER_H_
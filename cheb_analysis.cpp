@@ -29,106 +29,308 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //==================================================================================
 
+/* Sweeps the Chebyshev approximations of the functions in cheb_cache over lists of ranges and degrees.
+ *
+ * All (function, range, degree) jobs share one context, deep enough for the highest degree. Each job is
+ * encrypted at the level that leaves exactly the depth its degree needs, so low degrees run on few towers.
+ * Jobs run concurrently on a thread pool. Every job evaluates a grid of points strictly inside its range and
+ * compares the decrypted values with the exact function. The max, mean and L2 (root mean square) errors go
+ * into a summary table on stdout and a CSV file, together with the CKKS noise: the largest distance between
+ * the decrypted values and the same polynomial evaluated in plaintext.
+ *
+ * With -P the polynomials are only evaluated in plaintext (cheb_plain), which measures the approximation error
+ * alone, over millions of points, in milliseconds.
+ */
+
 #include "openfhe.h"
-#include "utils.h"
+#include <algorithm>
+#include <fstream>
+#include <getopt.h>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include "cheb_cache.h"
+#include "cheb_plain.h"
+#include "lr_types.h"
+#include "param_planner.h"
+#include "thread_pool.h"
 
-double LOWER_BOUND = -16;
-double UPPER_BOUND = -LOWER_BOUND;
-long double STEP = 0.001;
-uint32_t POLY_DEGREE = 59;
-std::string FILE_NAME =
-    "../py_scripts/sigmoidResults_" + std::to_string((int) UPPER_BOUND) + "_" + std::to_string(POLY_DEGREE) + ".txt";
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
+// Shared with lr_nag and lr_infer, so the analyzed polynomial is the one used in training
+std::string CHEB_TABLE_FILE = "../results/chebyshev_table.txt";
+std::string SWEEP_OUT_FILE_DEF = "../results/cheb_sweep.csv";
+std::string FUNCTIONS_DEF = "sigmoid";
+std::string RANGES_DEF = "8,16,32,64";
+std::string DEGREES_DEF = "13,27,59,119";
+uint32_t RING_DIM_DEF(1 << 16);
+// 0.001 apart over [-16, 16], like the old per-run text dumps
+usint NUM_POINTS_DEF(32000);
 
+struct SweepJob {
+  std::string function;
+  int rangeStart;
+  int rangeEnd;
+  uint32_t degree;
+  uint32_t depth;
+};
 
-// In this example, we evaluate the logistic function 1 / (1 + exp(-x)) on an input of doubles
-int main() {
+struct SweepResult {
+  SweepJob job;
+  ApproxError error;
+  double noiseMaxError;  // max |decrypted - plaintext polynomial|; 0 for plaintext runs
+  double evalMs;
+};
 
-  // The multiplicative depth depends on the polynomial degree.
-  // See the FUNCTION_EVALUATION.md file for a table mapping polynomial degrees to multiplicative depths.
-  //https://github.com/openfheorg/openfhe-development/blob/main/src/pke/examples/FUNCTION_EVALUATION.md
+static std::vector<std::string> SplitList(const std::string &list) {
+  std::vector<std::string> out;
+  std::stringstream ss(list);
+  std::string tok;
+  while (getline(ss, tok, ',')) {
+    if (!tok.empty()) out.push_back(tok);
+  }
+  return out;
+}
 
-  uint32_t multDepth = 0;
+static std::function<double(double)> ExactFunction(const std::string &name) {
+  if (name == "softplus") return Softplus;
+  // "sigmoid" and its least-squares fit "sigmoid_ls"
+  return Sigmoid;
+}
 
-  // NOTE: Please refer to: https://github.com/openfheorg/openfhe-development/blob/main/src/pke/examples/FUNCTION_EVALUATION.md
-  // to select the correct multDepth for your problem.
-  if (multDepth == 0) {
-    std::cerr << "Please set the multiplicative depth based on: https://github.com/openfheorg/openfhe-development/blob/main/src/pke/examples/FUNCTION_EVALUATION.md" << std::endl;
+// One "x,approximation" line per point, the format chebyshev_approx_analysis.ipynb reads
+static void WriteCurve(const std::string &dir, const SweepJob &job, const Vec &x, const Vec &values) {
+  std::string file = dir + "/" + job.function + "Results_" + std::to_string(job.rangeEnd) + "_" +
+      std::to_string(job.degree) + ".txt";
+  std::ofstream ofs(file);
+  if (!ofs.is_open()) {
+    std::cerr << "Curve file " << file << " could not be opened" << std::endl;
     exit(EXIT_FAILURE);
   }
-  std::cout << "Mult Depth set to: " << multDepth << std::endl;
+  for (size_t i = 0; i < x.size(); i++) ofs << std::to_string(x[i]) << "," << std::to_string(values[i]) << '\n';
+}
 
-  std::cout << "--------------------------------- EVAL LOGISTIC FUNCTION ---------------------------------"
-            << std::endl;
+static SweepResult RunPlainJob(const SweepJob &job, usint numPoints, const std::string &curveDir) {
+  auto &coefficients = ChebyshevCache::Get().Coefficients(job.function, job.rangeStart, job.rangeEnd, job.degree);
+  Vec x = ChebyshevGrid(job.rangeStart, job.rangeEnd, numPoints);
+  Vec values;
+  auto start = std::chrono::high_resolution_clock::now();
+  EvalChebyshevPlain(coefficients, job.rangeStart, job.rangeEnd, x, values);
+  auto end = std::chrono::high_resolution_clock::now();
 
-  lbcrypto::CCParams<lbcrypto::CryptoContextCKKSRNS> parameters;
-  // We set a smaller ring dimension to improve performance for this example.
-  // In production environments, the security level should be set to
-  // HEStd_128_classic, HEStd_192_classic, or HEStd_256_classic for 128-bit, 192-bit,
-  // or 256-bit security, respectively.
+  if (!curveDir.empty()) WriteCurve(curveDir, job, x, values);
+  return SweepResult{job, MeasureApproxError(x, values, ExactFunction(job.function)), 0,
+                     std::chrono::duration<double, std::milli>(end - start).count()};
+}
 
-  std::ofstream myFile;
-  myFile.open(FILE_NAME);
-  if (!myFile.is_open()) {
-    std::cerr << "File to store in could not be opened" << std::endl;
-    exit(EXIT_FAILURE);
-  }
+static SweepResult RunJob(CC &cc, const KeyPair &keys, uint32_t multDepth, const SweepJob &job, usint numPoints,
+                          const std::string &curveDir) {
+  Vec x = ChebyshevGrid(job.rangeStart, job.rangeEnd, numPoints);
+  auto &coefficients = ChebyshevCache::Get().Coefficients(job.function, job.rangeStart, job.rangeEnd, job.degree);
+  PT ptInput = cc->MakeCKKSPackedPlaintext(x, 1, multDepth - job.depth);
+  CT ctInput = cc->Encrypt(keys.publicKey, ptInput);
 
-  std::vector<std::double_t> input;
+  auto start = std::chrono::high_resolution_clock::now();
+  CT ctResult = cc->EvalChebyshevSeries(ctInput, coefficients, job.rangeStart, job.rangeEnd);
+  auto end = std::chrono::high_resolution_clock::now();
 
-  for (long double i = LOWER_BOUND + STEP; i < UPPER_BOUND - STEP; i = i + STEP) {
-    input.emplace_back(i);
-  }
+  PT ptResult;
+  cc->Decrypt(keys.secretKey, ctResult, &ptResult);
+  ptResult->SetLength(numPoints);
+  auto values = ptResult->GetRealPackedValue();
+  if (!curveDir.empty()) WriteCurve(curveDir, job, x, values);
+
+  Vec plainValues;
+  EvalChebyshevPlain(coefficients, job.rangeStart, job.rangeEnd, x, plainValues);
+  double noiseMaxError = 0;
+  for (usint i = 0; i < numPoints; i++) noiseMaxError = std::max(noiseMaxError, std::fabs(values[i] - plainValues[i]));
+
+  return SweepResult{job, MeasureApproxError(x, values, ExactFunction(job.function)), noiseMaxError,
+                     std::chrono::duration<double, std::milli>(end - start).count()};
+}
 
-  std::cout << "\tNumber of elements in the input vector: " << input.size() <<
-            "\n\tFully packed batch size: " << NextPow2(input.size()) <<
-            "\n\tRequired Ring Size: " << NextPow2(input.size()) * 2 << std::endl;
+static std::vector<SweepResult> RunEncryptedSweep(const std::vector<SweepJob> &jobs, uint32_t ringDim,
+                                                  uint32_t multDepth, usint numPoints, usint numWorkers,
+                                                  const std::string &curveDir) {
+  std::cout << "Sweeping " << jobs.size() << " approximations in one context of depth " << multDepth
+            << ", ring dimension " << ringDim << ", " << numPoints << " points each" << std::endl;
 
-  uint32_t ringDimension = 1 << 18;
+  CryptoParams parameters;
+  // Not a secure configuration: the sweep only measures approximation and CKKS error
   parameters.SetSecurityLevel(lbcrypto::HEStd_NotSet);
-  parameters.SetRingDim(ringDimension);
-  std::cout << "Batch size: " << ringDimension / 2 << std::endl;
-  parameters.SetBatchSize(ringDimension / 2);
+  parameters.SetRingDim(ringDim);
+  parameters.SetBatchSize(ringDim / 2);
 #if NATIVEINT == 128
   usint scalingModSize = 85;
   usint firstModSize = 89;
 #else
   usint scalingModSize = 59;
-    usint firstModSize   = 60;
+  usint firstModSize = 60;
 #endif
   parameters.SetScalingModSize(scalingModSize);
   parameters.SetFirstModSize(firstModSize);
-
   parameters.SetMultiplicativeDepth(multDepth);
-  lbcrypto::CryptoContext<lbcrypto::DCRTPoly> cc = GenCryptoContext(parameters);
+  CC cc = GenCryptoContext(parameters);
   cc->Enable(lbcrypto::PKE);
   cc->Enable(lbcrypto::KEYSWITCH);
   cc->Enable(lbcrypto::LEVELEDSHE);
   // We need to enable Advanced SHE to use the Chebyshev approximation.
   cc->Enable(lbcrypto::ADVANCEDSHE);
 
-  auto keyPair = cc->KeyGen();
+  auto keys = cc->KeyGen();
   // We need to generate mult keys to run Chebyshev approximations.
-  cc->EvalMultKeyGen(keyPair.secretKey);
-  size_t encodedLength = input.size();
-  std::cout << encodedLength << std::endl;
-  lbcrypto::Plaintext plaintext = cc->MakeCKKSPackedPlaintext(input);
-  auto ciphertext = cc->Encrypt(keyPair.publicKey, plaintext);
+  cc->EvalMultKeyGen(keys.secretKey);
 
-  auto result = cc->EvalLogistic(ciphertext, LOWER_BOUND, UPPER_BOUND, POLY_DEGREE);
+  int totalThreads = 1;
+#ifdef _OPENMP
+  totalThreads = omp_get_max_threads();
+#endif
+  if (numWorkers == 0) numWorkers = std::min(usint(jobs.size()), usint(totalThreads));
+  numWorkers = std::max(usint(1), numWorkers);
+  int innerThreads = std::max(1, totalThreads / int(numWorkers));
+  std::cout << numWorkers << " worker(s) x " << innerThreads << " OpenMP thread(s)" << std::endl;
 
-  lbcrypto::Plaintext plaintextDec;
-  cc->Decrypt(keyPair.secretKey, result, &plaintextDec);
-  plaintextDec->SetLength(encodedLength);
-  auto resp = plaintextDec->GetRealPackedValue();
+  // the most expensive jobs first, so a long one doesn't start last
+  std::vector<size_t> order(jobs.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [&jobs](size_t a, size_t b) { return jobs[a].degree > jobs[b].degree; });
 
-  std::string strToIO;
+  std::vector<SweepResult> results(jobs.size());
+  ThreadPool pool(numWorkers, innerThreads);
+  std::vector<std::future<void>> futures;
+  for (auto i : order) {
+    futures.push_back(pool.Submit([&, i]() {
+      results[i] = RunJob(cc, keys, multDepth, jobs[i], numPoints, curveDir);
+    }));
+  }
+  WaitAll(futures);
+  return results;
+}
+
+static void WriteSummary(const std::vector<SweepResult> &results, usint numPoints, const std::string &outFile) {
+  std::ofstream ofs(outFile);
+  if (!ofs.is_open()) {
+    std::cerr << "Summary file " << outFile << " could not be opened" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  ofs << "function,range_start,range_end,degree,depth,points,max_error,mean_error,l2_error,noise_max_error,eval_ms"
+      << std::endl;
+  ofs.precision(6);
+  std::cout << std::left << std::setw(12) << "function" << std::setw(12) << "range" << std::right << std::setw(8)
+            << "degree" << std::setw(7) << "depth" << std::setw(13) << "max err" << std::setw(13) << "mean err"
+            << std::setw(13) << "L2 err" << std::setw(13) << "CKKS noise" << std::setw(11) << "eval ms" << std::endl;
+  for (auto &result : results) {
+    auto &job = result.job;
+    std::stringstream range;
+    range << "[" << job.rangeStart << ", " << job.rangeEnd << "]";
+    std::cout << std::left << std::setw(12) << job.function << std::setw(12) << range.str() << std::right
+              << std::setw(8) << job.degree << std::setw(7) << job.depth << std::scientific << std::setprecision(3)
+              << std::setw(13) << result.error.maxError << std::setw(13) << result.error.meanError << std::setw(13)
+              << result.error.l2Error << std::setw(13) << result.noiseMaxError << std::fixed << std::setprecision(1)
+              << std::setw(11) << result.evalMs << std::defaultfloat << std::endl;
+    ofs << job.function << "," << job.rangeStart << "," << job.rangeEnd << "," << job.degree << "," << job.depth
+        << "," << numPoints << "," << result.error.maxError << "," << result.error.meanError << ","
+        << result.error.l2Error << "," << result.noiseMaxError << "," << result.evalMs << std::endl;
+  }
+  std::cout << "Summary written to " << outFile << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  std::string functions = FUNCTIONS_DEF;
+  std::string ranges = RANGES_DEF;
+  std::string degrees = DEGREES_DEF;
+  uint32_t ringDim = RING_DIM_DEF;
+  usint numPoints = NUM_POINTS_DEF;
+  usint numWorkers = 0;
+  std::string outFile = SWEEP_OUT_FILE_DEF;
+  std::string chebTableFile = CHEB_TABLE_FILE;
+  bool plainOnly = false;
+  std::string curveDir;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "f:r:g:d:p:W:o:C:PR:h")) != -1) {
+    switch (opt) {
+      case 'f':functions = optarg;
+        break;
+      case 'r':ranges = optarg;
+        break;
+      case 'g':degrees = optarg;
+        break;
+      case 'd':ringDim = atoi(optarg);
+        break;
+      case 'p':numPoints = atoi(optarg);
+        break;
+      case 'W':numWorkers = atoi(optarg);
+        break;
+      case 'o':outFile = optarg;
+        break;
+      case 'C':chebTableFile = optarg;
+        break;
+      case 'P':plainOnly = true;
+        break;
+      case 'R':curveDir = optarg;
+        break;
+      case 'h':
+      default: /* '?' */
+        std::cerr << "Usage: " << std::endl
+                  << "arguments:" << std::endl
+                  << "  -f <comma separated functions: sigmoid, sigmoid_ls, softplus> [" << FUNCTIONS_DEF << "]"
+                  << std::endl
+                  << "  -r <comma separated bounds B; each range is [-B, B]> [" << RANGES_DEF << "]" << std::endl
+                  << "  -g <comma separated degrees> [" << DEGREES_DEF << "]" << std::endl
+                  << "  -d <ring dimension; the grid must fit into ringDim / 2 slots> [" << RING_DIM_DEF << "]"
+                  << std::endl
+                  << "  -p <grid points per range> [" << NUM_POINTS_DEF << "]" << std::endl
+                  << "  -W <jobs evaluated concurrently, 0 = one per core> [0]" << std::endl
+                  << "  -o <summary CSV> [" << SWEEP_OUT_FILE_DEF << "]" << std::endl
+                  << "  -C <Chebyshev coefficient table, empty = keep in memory only> [" << CHEB_TABLE_FILE << "]"
+                  << std::endl
+                  << "  -P evaluate the polynomials in plaintext only (approximation error, no CKKS noise) [false]"
+                  << std::endl
+                  << "  -R <directory to write each job's x,approximation curve to, for the notebooks> [none]"
+                  << std::endl
+                  << "  -h prints this message" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+  }
+  if (numPoints == 0 || (!plainOnly && numPoints > ringDim / 2)) {
+    std::cerr << "The grid (" << numPoints << " points) must fit into " << ringDim / 2 << " slots." << std::endl;
+    exit(EXIT_FAILURE);
+  }
 
-  for (uint32_t i = 0; i < encodedLength; i++) {
-    strToIO = std::to_string(input[i]) + "," + std::to_string(resp[i]) + '\n';
-    myFile << strToIO;
+  std::vector<SweepJob> jobs;
+  uint32_t multDepth = 0;
+  for (auto &function : SplitList(functions)) {
+    for (auto &range : SplitList(ranges)) {
+      for (auto &degree : SplitList(degrees)) {
+        SweepJob job{function, -std::stoi(range), std::stoi(range), uint32_t(std::stoul(degree)), 0};
+        job.depth = ChebyshevDepth(job.degree);
+        multDepth = std::max(multDepth, job.depth);
+        jobs.push_back(job);
+      }
+    }
+  }
+  if (jobs.empty()) {
+    std::cerr << "Nothing to sweep." << std::endl;
+    exit(EXIT_FAILURE);
   }
-  myFile.close();
 
+  // The coefficients are computed (or read from the table) before the jobs start
+  auto &chebCache = ChebyshevCache::Get();
+  if (!chebTableFile.empty()) chebCache.UseTable(chebTableFile);
+  for (auto &job : jobs) chebCache.Coefficients(job.function, job.rangeStart, job.rangeEnd, job.degree);
+
+  std::vector<SweepResult> results(jobs.size());
+  if (plainOnly) {
+    std::cout << "Sweeping " << jobs.size() << " approximations in plaintext, " << numPoints << " points each"
+              << std::endl;
+    // each evaluation is already spread over the OpenMP threads
+    for (size_t i = 0; i < jobs.size(); i++) results[i] = RunPlainJob(jobs[i], numPoints, curveDir);
+  } else {
+    results = RunEncryptedSweep(jobs, ringDim, multDepth, numPoints, numWorkers, curveDir);
+  }
+  WriteSummary(results, numPoints, outFile);
 }
@@ -0,0 +1,207 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "cheb_cache.h"
+#include "cheb_plain.h"
+#include "depth_plan.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+double Sigmoid(double x) {
+  return 1.0 / (1.0 + std::exp(-x));
+}
+
+double Softplus(double x) {
+  // log(1 + e^x) without overflowing for large x
+  return (x > 0) ? x + std::log1p(std::exp(-x)) : std::log1p(std::exp(x));
+}
+
+const char *SigmoidCacheName(SigmoidApprox approx) {
+  switch (approx) {
+    case SIGMOID_LEAST_SQUARES:return "sigmoid_ls";
+    case SIGMOID_LEAST_SQUARES_DATA:return "sigmoid_ls_data";
+    default:return "sigmoid";
+  }
+}
+
+bool UsesPowerSeries(SigmoidApprox approx, double rangeStart, double rangeEnd, uint32_t degree, double logitScale) {
+  return approx != SIGMOID_CHEBYSHEV && PowerSeriesDepthOf(degree) > 0 && rangeStart == -rangeEnd &&
+      rangeEnd > 0 && logitScale == rangeEnd;
+}
+
+std::vector<double> FitSigmoidLeastSquares(double rangeStart, double rangeEnd, uint32_t degree,
+                                           const Vec &logitSamples, double uniformWeight) {
+  const uint32_t gridPoints = 2001;
+  double center = (rangeStart + rangeEnd) / 2;
+  double halfWidth = (rangeEnd - rangeStart) / 2;
+  bool symmetric = (center == 0);
+  if (logitSamples.empty()) uniformWeight = 1.0;
+
+  // fit points mapped to t in [-1, 1], where EvalChebyshevSeries evaluates T_k(t)
+  std::vector<double> points, weights;
+  for (uint32_t i = 0; i < gridPoints; i++) {
+    points.push_back(-1.0 + 2.0 * i / (gridPoints - 1));
+    weights.push_back(uniformWeight / gridPoints);
+  }
+  for (auto z : logitSamples) {
+    double t = std::max(-1.0, std::min(1.0, (z - center) / halfWidth));
+    double w = (1.0 - uniformWeight) / logitSamples.size();
+    if (symmetric) {
+      points.push_back(-t);
+      weights.push_back(w / 2);
+      w /= 2;
+    }
+    points.push_back(t);
+    weights.push_back(w);
+  }
+
+  // basis terms to fit; on a symmetric range the constant is fixed at 1/2 and only odd terms are fitted
+  std::vector<uint32_t> terms;
+  for (uint32_t k = symmetric ? 1 : 0; k <= degree; k += symmetric ? 2 : 1) terms.push_back(k);
+  size_t m = terms.size();
+
+  // normal equations A c = r, with A_jk = sum_i w_i T_j(t_i) T_k(t_i) and r_j = sum_i w_i T_j(t_i) f_i
+  std::vector<std::vector<double>> A(m, std::vector<double>(m + 1, 0.0));
+  std::vector<double> T(degree + 1);
+  for (size_t i = 0; i < points.size(); i++) {
+    double t = points[i];
+    T[0] = 1.0;
+    if (degree > 0) T[1] = t;
+    for (uint32_t k = 2; k <= degree; k++) T[k] = 2 * t * T[k - 1] - T[k - 2];
+    double f = Sigmoid(center + halfWidth * t) - (symmetric ? 0.5 : 0.0);
+    for (size_t j = 0; j < m; j++) {
+      for (size_t k = 0; k < m; k++) A[j][k] += weights[i] * T[terms[j]] * T[terms[k]];
+      A[j][m] += weights[i] * T[terms[j]] * f;
+    }
+  }
+
+  // Gaussian elimination with partial pivoting; A is small (at most degree + 1 unknowns)
+  for (size_t col = 0; col < m; col++) {
+    size_t pivot = col;
+    for (size_t row = col + 1; row < m; row++) {
+      if (std::fabs(A[row][col]) > std::fabs(A[pivot][col])) pivot = row;
+    }
+    if (A[pivot][col] == 0) {
+      OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+          std::to_string(__LINE__) +
+          std::string("Error: singular least-squares system for degree ") + std::to_string(degree));
+    }
+    std::swap(A[col], A[pivot]);
+    for (size_t row = 0; row < m; row++) {
+      if (row == col) continue;
+      double factor = A[row][col] / A[col][col];
+      for (size_t k = col; k <= m; k++) A[row][k] -= factor * A[col][k];
+    }
+  }
+
+  std::vector<double> coefficients(degree + 1, 0.0);
+  for (size_t j = 0; j < m; j++) coefficients[terms[j]] = A[j][m] / A[j][j];
+  // EvalChebyshevSeries adds c_0 / 2
+  if (symmetric) coefficients[0] = 1.0;
+  else coefficients[0] *= 2;
+  return coefficients;
+}
+
+static std::function<double(double)> NamedFunction(const std::string &name) {
+  if (name == "sigmoid") return Sigmoid;
+  if (name == "softplus") return Softplus;
+  OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+      std::to_string(__LINE__) +
+      std::string("Error: no Chebyshev approximation registered for ") + name);
+}
+
+static std::string EntryKey(const std::string &name, double rangeStart, double rangeEnd, uint32_t degree) {
+  std::stringstream ss;
+  ss.precision(17);
+  ss << name << "," << rangeStart << "," << rangeEnd << "," << degree;
+  return ss.str();
+}
+
+ChebyshevCache &ChebyshevCache::Get() {
+  static ChebyshevCache cache;
+  return cache;
+}
+
+void ChebyshevCache::UseTable(const std::string &file) {
+  std::lock_guard<std::mutex> lock(mutex);
+  tableFile = file;
+  std::ifstream is(file);
+  std::string line;
+  // name,rangeStart,rangeEnd,degree,c_0,c_1,...
+  while (getline(is, line)) {
+    std::stringstream ss(line);
+    std::string name, start, end, degree, tok;
+    if (!getline(ss, name, ',') || !getline(ss, start, ',') || !getline(ss, end, ',') || !getline(ss, degree, ',')) {
+      continue;
+    }
+    std::vector<double> coefficients;
+    while (getline(ss, tok, ',')) coefficients.push_back(std::stod(tok));
+    if (coefficients.empty()) continue;
+    entries[EntryKey(name, std::stod(start), std::stod(end), std::stoul(degree))] = coefficients;
+  }
+}
+
+const std::vector<double> &ChebyshevCache::Coefficients(const std::string &name, double rangeStart, double rangeEnd,
+                                                        uint32_t degree) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::string key = EntryKey(name, rangeStart, rangeEnd, degree);
+  auto found = entries.find(key);
+  if (found != entries.end()) return found->second;
+
+  auto &coefficients = entries[key];
+  bool dataFit = (name == SigmoidCacheName(SIGMOID_LEAST_SQUARES_DATA));
+  if (dataFit || name == SigmoidCacheName(SIGMOID_LEAST_SQUARES)) {
+    coefficients = FitSigmoidLeastSquares(rangeStart, rangeEnd, degree, Vec());
+  } else {
+    coefficients = ChebyshevInterpolate(NamedFunction(name), rangeStart, rangeEnd, degree);
+  }
+  if (!dataFit) AppendToTable(key, coefficients);
+  return coefficients;
+}
+
+void ChebyshevCache::Store(const std::string &name, double rangeStart, double rangeEnd, uint32_t degree,
+                           const std::vector<double> &coefficients, bool persist) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::string key = EntryKey(name, rangeStart, rangeEnd, degree);
+  entries[key] = coefficients;
+  if (persist && name != SigmoidCacheName(SIGMOID_LEAST_SQUARES_DATA)) AppendToTable(key, coefficients);
+}
+
+void ChebyshevCache::AppendToTable(const std::string &key, const std::vector<double> &coefficients) {
+  if (tableFile.empty()) return;
+  std::ofstream os(tableFile, std::ios::app);
+  os.precision(17);
+  os << key;
+  for (auto c : coefficients) os << "," << c;
+  os << std::endl;
+}
@@ -0,0 +1,115 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__CHEB_CACHE_H_
+#define DPRIVE_ML__CHEB_CACHE_H_
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "openfhe.h"
+#include "lr_types.h"
+
+////////// Chebyshev coefficients of the functions evaluated homomorphically ///////////////////////////////
+
+// Functions the cache knows by name
+double Sigmoid(double x);
+double Softplus(double x);
+
+// Polynomials that can stand in for the sigmoid (gradient and inference)
+enum SigmoidApprox {
+  SIGMOID_CHEBYSHEV,      // Chebyshev interpolation, cache name "sigmoid"
+  SIGMOID_LEAST_SQUARES,  // least-squares fit (FitSigmoidLeastSquares), cache name "sigmoid_ls"
+  // least-squares fit weighted towards one training set's logits, cache name "sigmoid_ls_data"; never in the table
+  SIGMOID_LEAST_SQUARES_DATA,
+};
+
+const char *SigmoidCacheName(SigmoidApprox approx);
+
+/* Least-squares sigmoids up to POWER_SERIES_MAX_DEGREE (depth_plan.h) on a symmetric range [-B, B] are evaluated
+ * in the power basis when the logits arrive divided by B, i.e. logitScale == B. X is then encrypted divided by B
+ * (EncryptShards), so the mapping to [-1, 1] that costs EvalChebyshevSeries a level is already in the data, and
+ * the degree takes PowerSeriesDepthOf levels. Everything else keeps EvalChebyshevSeries (TracedEvalLogistic).
+ */
+bool UsesPowerSeries(SigmoidApprox approx, double rangeStart, double rangeEnd, uint32_t degree, double logitScale);
+
+/* Weighted least-squares fit of the sigmoid on [rangeStart, rangeEnd] by a polynomial of the given degree,
+ * returned as Chebyshev coefficients for EvalChebyshevSeries (which evaluates degree >= 5 with
+ * Paterson-Stockmeyer), or for the power basis (see UsesPowerSeries). The fit points are a uniform grid
+ * over the range, carrying uniformWeight of the total weight, and the logit samples (clamped to the range),
+ * carrying the rest; without samples the grid carries all of it. On a range symmetric around 0 the samples
+ * are mirrored and only odd terms are fitted, so that p(-x) = 1 - p(x) like the sigmoid itself.
+ * Unlike interpolation, which spreads its error evenly over the whole range, the fit is accurate where the
+ * logits actually are, which is what makes degrees 3 to 15 usable.
+ */
+std::vector<double> FitSigmoidLeastSquares(double rangeStart, double rangeEnd, uint32_t degree,
+                                           const Vec &logitSamples, double uniformWeight = 0.25);
+
+/* Coefficients per (function, range, degree). They are computed once with ChebyshevInterpolate (the same
+ * interpolant as OpenFHE's EvalChebyshevCoefficients), the first time they are asked for, and then kept for
+ * the rest of the process. With a table file, entries are loaded from it and newly computed ones are appended
+ * to it. That way lr_nag, lr_infer, cheb_analysis and bench_lr all evaluate exactly the same polynomials.
+ * Thread-safe; returned references stay valid.
+ */
+class ChebyshevCache {
+ public:
+  static ChebyshevCache &Get();
+
+  // Loads the table (a missing file is fine) and appends new entries to it from now on
+  void UseTable(const std::string &file);
+
+  /* name is one of "sigmoid", "softplus", "sigmoid_ls", "sigmoid_ls_data"; a missing least-squares entry is
+   * fitted on the uniform grid alone. "sigmoid_ls_data" entries depend on a training set, so they are kept in
+   * this process only and never appended to the table.
+   */
+  const std::vector<double> &Coefficients(const std::string &name, double rangeStart, double rangeEnd,
+                                          uint32_t degree);
+
+  /* Replaces an entry, e.g. with a data-dependent fit or a model's polynomial, and with persist appends it to
+   * the table. When the table holds several lines for the same entry, the last one wins. Not for entries
+   * already being evaluated.
+   */
+  void Store(const std::string &name, double rangeStart, double rangeEnd, uint32_t degree,
+             const std::vector<double> &coefficients, bool persist = true);
+
+ private:
+  ChebyshevCache() = default;
+
+  void AppendToTable(const std::string &key, const std::vector<double> &coefficients);
+
+  std::mutex mutex;
+  std::string tableFile;
+  std::map<std::string, std::vector<double>> entries;
+};
+
+#endif //DPRIVE_ML__CHEB_CACHE_H_
@@ -0,0 +1,158 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "cheb_plain.h"
+#include <algorithm>
+#include <cmath>
+
+// points per block of the vectorized evaluation; the block's recurrence state stays in L1
+static const size_t EVAL_BLOCK = 512;
+
+std::vector<double> ChebyshevInterpolate(const std::function<double(double)> &func, double rangeStart, double rangeEnd,
+                                         uint32_t degree) {
+  size_t numCoefficients = degree + 1;
+  double halfWidth = 0.5 * (rangeEnd - rangeStart);
+  double center = 0.5 * (rangeEnd + rangeStart);
+  double piByN = M_PI / numCoefficients;
+
+  std::vector<double> values(numCoefficients);
+  for (size_t j = 0; j < numCoefficients; j++) {
+    values[j] = func(std::cos(piByN * (j + 0.5)) * halfWidth + center);
+  }
+  std::vector<double> coefficients(numCoefficients, 0.0);
+  for (size_t k = 0; k < numCoefficients; k++) {
+    for (size_t j = 0; j < numCoefficients; j++) coefficients[k] += values[j] * std::cos(piByN * k * (j + 0.5));
+    coefficients[k] *= 2.0 / numCoefficients;
+  }
+  return coefficients;
+}
+
+double EvalChebyshevPlain(const std::vector<double> &coefficients, double rangeStart, double rangeEnd, double x) {
+  // an empty series is 0 (and would wrap the unsigned loop below around)
+  if (coefficients.empty()) return 0;
+  double t = (2 * x - rangeStart - rangeEnd) / (rangeEnd - rangeStart);
+  double b1 = 0, b2 = 0;
+  for (size_t k = coefficients.size() - 1; k >= 1; k--) {
+    double b0 = coefficients[k] + 2 * t * b1 - b2;
+    b2 = b1;
+    b1 = b0;
+  }
+  return coefficients[0] / 2 + t * b1 - b2;
+}
+
+void EvalChebyshevPlain(const std::vector<double> &coefficients, double rangeStart, double rangeEnd, const Vec &x,
+                        Vec &out) {
+  if (coefficients.empty()) {
+    out.assign(x.size(), 0.0);
+    return;
+  }
+  out.resize(x.size());
+  size_t numBlocks = (x.size() + EVAL_BLOCK - 1) / EVAL_BLOCK;
+  double scale = 2 / (rangeEnd - rangeStart);
+  double shift = (rangeStart + rangeEnd) / (rangeEnd - rangeStart);
+
+#pragma omp parallel for schedule(static)
+  for (size_t block = 0; block < numBlocks; block++) {
+    size_t first = block * EVAL_BLOCK;
+    size_t n = std::min(EVAL_BLOCK, x.size() - first);
+    double t[EVAL_BLOCK], b1[EVAL_BLOCK], b2[EVAL_BLOCK];
+#pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+      t[i] = x[first + i] * scale - shift;
+      b1[i] = 0;
+      b2[i] = 0;
+    }
+    for (size_t k = coefficients.size() - 1; k >= 1; k--) {
+      double c = coefficients[k];
+#pragma omp simd
+      for (size_t i = 0; i < n; i++) {
+        double b0 = c + 2 * t[i] * b1[i] - b2[i];
+        b2[i] = b1[i];
+        b1[i] = b0;
+      }
+    }
+    double c0 = coefficients[0] / 2;
+#pragma omp simd
+    for (size_t i = 0; i < n; i++) out[first + i] = c0 + t[i] * b1[i] - b2[i];
+  }
+}
+
+std::vector<double> ChebyshevToPowerBasis(const std::vector<double> &coefficients, double rangeStart, double rangeEnd,
+                                          double inputScale) {
+  if (coefficients.empty()) return {};
+  size_t n = coefficients.size();
+  // c_0 / 2 + sum_k c_k T_k(t) in powers of t, with T_k = 2 t T_{k-1} - T_{k-2}
+  std::vector<double> inT(n, 0.0);
+  std::vector<double> tPrev(n, 0.0), tCur(n, 0.0), tNext(n, 0.0);
+  tPrev[0] = 1.0;
+  inT[0] = coefficients[0] / 2;
+  if (n > 1) {
+    tCur[1] = 1.0;
+    inT[1] = coefficients[1];
+  }
+  for (size_t k = 2; k < n; k++) {
+    for (size_t j = 0; j < n; j++) tNext[j] = (j > 0 ? 2 * tCur[j - 1] : 0.0) - tPrev[j];
+    for (size_t j = 0; j <= k; j++) inT[j] += coefficients[k] * tNext[j];
+    std::swap(tPrev, tCur);
+    std::swap(tCur, tNext);
+  }
+
+  // t = alpha u + beta, substituted with Horner's scheme
+  double alpha = 2 * inputScale / (rangeEnd - rangeStart);
+  double beta = -(rangeStart + rangeEnd) / (rangeEnd - rangeStart);
+  std::vector<double> inU(n, 0.0);
+  inU[0] = inT[n - 1];
+  for (size_t k = n - 1; k >= 1; k--) {
+    // inU = inU * (alpha u + beta) + inT[k - 1]
+    for (size_t j = n - k; j >= 1; j--) inU[j] = inU[j] * beta + inU[j - 1] * alpha;
+    inU[0] = inU[0] * beta + inT[k - 1];
+  }
+  return inU;
+}
+
+Vec ChebyshevGrid(double rangeStart, double rangeEnd, usint n) {
+  Vec x(n);
+  double step = (rangeEnd - rangeStart) / (n + 1);
+  for (usint i = 0; i < n; i++) x[i] = rangeStart + (i + 1) * step;
+  return x;
+}
+
+ApproxError MeasureApproxError(const Vec &x, const Vec &approx, const std::function<double(double)> &func) {
+  double maxError = 0, sumError = 0, sumSquares = 0;
+#pragma omp parallel for reduction(max:maxError) reduction(+:sumError, sumSquares)
+  for (size_t i = 0; i < x.size(); i++) {
+    double error = std::fabs(approx[i] - func(x[i]));
+    maxError = std::max(maxError, error);
+    sumError += error;
+    sumSquares += error * error;
+  }
+  return ApproxError{maxError, sumError / x.size(), std::sqrt(sumSquares / x.size())};
+}
@@ -0,0 +1,75 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__CHEB_PLAIN_H_
+#define DPRIVE_ML__CHEB_PLAIN_H_
+
+#include <functional>
+#include <vector>
+#include "lr_types.h"
+
+////////// Plaintext Chebyshev interpolation and evaluation ///////////////////////////////
+
+/* Chebyshev interpolant of func on [rangeStart, rangeEnd], in OpenFHE's convention (EvalChebyshevCoefficients):
+ * degree + 1 nodes of the first kind, coefficients c_k = 2 / (degree + 1) * sum_j f(x_j) T_k(t_j), and the
+ * polynomial is c_0 / 2 + sum_{k >= 1} c_k T_k(t), with t the point mapped to [-1, 1].
+ */
+std::vector<double> ChebyshevInterpolate(const std::function<double(double)> &func, double rangeStart, double rangeEnd,
+                                         uint32_t degree);
+
+// The series at one point, with Clenshaw's recurrence (what EvalChebyshevSeries computes, without the noise)
+double EvalChebyshevPlain(const std::vector<double> &coefficients, double rangeStart, double rangeEnd, double x);
+
+/* The series at every point of x. Points are processed in blocks spread over the OpenMP threads, and the
+ * recurrence runs over a whole block at once so the compiler vectorizes across points.
+ */
+void EvalChebyshevPlain(const std::vector<double> &coefficients, double rangeStart, double rangeEnd, const Vec &x,
+                        Vec &out);
+
+/* The same polynomial in the power basis of u = x / inputScale: out[k] is the coefficient of u^k. Meant for
+ * low degrees (the least-squares sigmoids); the monomial coefficients grow quickly with the degree.
+ */
+std::vector<double> ChebyshevToPowerBasis(const std::vector<double> &coefficients, double rangeStart, double rangeEnd,
+                                          double inputScale = 1.0);
+
+// n points evenly spaced strictly inside [rangeStart, rangeEnd]
+Vec ChebyshevGrid(double rangeStart, double rangeEnd, usint n);
+
+struct ApproxError {
+  double maxError;
+  double meanError;
+  double l2Error;  // root mean square over the points
+};
+
+// Errors of approx against func at the points x
+ApproxError MeasureApproxError(const Vec &x, const Vec &approx, const std::function<double(double)> &func);
+
+#endif //DPRIVE_ML__CHEB_PLAIN_H_
@@ -0,0 +1,179 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "ct_store.h"
+#include <cerrno>
+#include <fstream>
+#include <sys/stat.h>
+#include "data_io.h"
+#include "lr_train_funcs.h"
+#include "mem_stats.h"
+
+static std::string Path(const std::string &dir, const std::string &name) {
+  return dir + "/" + name;
+}
+
+static std::string ShardFile(const std::string &dir, usint shard, const std::string &part) {
+  return Path(dir, "shard_" + std::to_string(shard) + "_" + part + ".bin");
+}
+
+static void ThrowIoError(const std::string &what) {
+  OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+      std::to_string(__LINE__) + std::string("Error: ") + what);
+}
+
+static void WriteCt(const std::string &file, const CT &ct) {
+  if (!lbcrypto::Serial::SerializeToFile(file, ct, lbcrypto::SerType::BINARY)) {
+    ThrowIoError("cannot write " + file);
+  }
+}
+
+static void ReadCt(const std::string &file, CT &ct) {
+  if (!lbcrypto::Serial::DeserializeFromFile(file, ct, lbcrypto::SerType::BINARY)) {
+    ThrowIoError("cannot read " + file);
+  }
+}
+
+ShardStoreIndex BuildShardStore(
+    const std::string &dir,
+    CC &cc,
+    const std::string &xFile,
+    const std::string &yFile,
+    int rowsToRead,
+    float lrGamma,
+    usint rowSize,
+    usint numSlots,
+    usint rowsPerShard,
+    const KeyPair &keys,
+    const DataLevels &levels
+) {
+  if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    ThrowIoError("cannot create shard store directory " + dir);
+  }
+  ShardStoreIndex index{};
+  ReadDataShape(xFile, rowsToRead, index.numSamples, index.numFeatures);
+  index.rowSize = rowSize;
+  usint capacity = numSlots / rowSize;
+  if (rowsPerShard == 0 || rowsPerShard > capacity) rowsPerShard = capacity;
+
+  CsvRowReader xReader(xFile, rowsToRead);
+  CsvRowReader yReader(yFile, rowsToRead);
+  Vec xRow, yRow;
+  Mat X, y;
+  usint first = 0;
+  bool more = true;
+  while (more) {
+    more = xReader.Next(xRow) && yReader.Next(yRow);
+    if (more) {
+      X.push_back(xRow);
+      y.push_back(yRow);
+    }
+    if (X.size() == rowsPerShard || (!more && !X.empty())) {
+      // scaled by the size of the whole training set, as in populateData
+      Mat NegXt = InitializeLogReg(X, y, lrGamma / index.numSamples);
+      auto shards = EncryptShards(cc, X, NegXt, y, rowSize, numSlots, rowsPerShard, keys, levels);
+      shards[0].firstRow = first;
+      if (index.numRows.empty()) {
+        index.shardBytes = CiphertextBytes(shards[0].ctX) + CiphertextBytes(shards[0].ctNegXt) +
+            CiphertextBytes(shards[0].ctLabels);
+      }
+      WriteShard(dir, index.numRows.size(), shards[0]);
+      index.firstRows.push_back(first);
+      index.numRows.push_back(X.size());
+      first += X.size();
+      X.clear();
+      y.clear();
+    }
+  }
+  if (first != index.numSamples) {
+    ThrowIoError("X and y dimension mismatch in " + xFile + " and " + yFile);
+  }
+
+  std::ofstream os(Path(dir, "store.txt"));
+  os << index.numSamples << " " << index.numFeatures << " " << index.rowSize << " " << index.numRows.size() << " "
+     << index.shardBytes << std::endl;
+  for (size_t i = 0; i < index.numRows.size(); i++) {
+    os << index.firstRows[i] << " " << index.numRows[i] << std::endl;
+  }
+  if (!os) ThrowIoError("cannot write " + Path(dir, "store.txt"));
+  return index;
+}
+
+ShardStoreIndex ReadShardStoreIndex(const std::string &dir) {
+  std::ifstream is(Path(dir, "store.txt"));
+  ShardStoreIndex index{};
+  usint numShards = 0;
+  if (!(is >> index.numSamples >> index.numFeatures >> index.rowSize >> numShards >> index.shardBytes) ||
+      numShards == 0) {
+    ThrowIoError("cannot read " + Path(dir, "store.txt"));
+  }
+  index.firstRows.resize(numShards);
+  index.numRows.resize(numShards);
+  for (usint i = 0; i < numShards; i++) {
+    if (!(is >> index.firstRows[i] >> index.numRows[i])) ThrowIoError("truncated " + Path(dir, "store.txt"));
+  }
+  return index;
+}
+
+void WriteShard(const std::string &dir, usint shard, const DataShard &data) {
+  WriteCt(ShardFile(dir, shard, "x"), data.ctX);
+  WriteCt(ShardFile(dir, shard, "negxt"), data.ctNegXt);
+  WriteCt(ShardFile(dir, shard, "y"), data.ctLabels);
+}
+
+DataShard ReadShard(const std::string &dir, usint shard, const ShardStoreIndex &index) {
+  DataShard data;
+  ReadCt(ShardFile(dir, shard, "x"), data.ctX);
+  ReadCt(ShardFile(dir, shard, "negxt"), data.ctNegXt);
+  ReadCt(ShardFile(dir, shard, "y"), data.ctLabels);
+  data.firstRow = index.firstRows[shard];
+  data.numRows = index.numRows[shard];
+  return data;
+}
+
+ShardStream::ShardStream(const std::string &dir) : dir(dir), index(ReadShardStoreIndex(dir)) {
+  Prefetch(0);
+}
+
+DataShard ShardStream::Next() {
+  TimeVar t;
+  TIC(t);
+  // the future is shared so a single-shard store can hand out the same shard again
+  DataShard data = pending.get();
+  lastWaitMs = TOC(t);
+  nextShard = (nextShard + 1) % NumShards();
+  if (NumShards() > 1) Prefetch(nextShard);
+  return data;
+}
+
+void ShardStream::Prefetch(usint shard) {
+  pending = std::async(std::launch::async, [this, shard]() { return ReadShard(dir, shard, index); }).share();
+}
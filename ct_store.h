@@ -0,0 +1,108 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__CT_STORE_H_
+#define DPRIVE_ML__CT_STORE_H_
+
+#include <future>
+#include <string>
+#include <vector>
+#include "openfhe.h"
+#include "lr_types.h"
+#include "param_planner.h"
+#include "shard_engine.h"
+
+////////// Encrypted training data on disk ///////////////////////////////
+
+/* A directory with the data shards of EncryptShards, each ciphertext serialized at the level it is
+ * consumed at, and a store.txt index. The ciphertexts only decrypt under the keys they were encrypted
+ * with, so lr_nag builds the store right after key generation and reads it back every iteration.
+ */
+struct ShardStoreIndex {
+  usint numSamples;
+  usint numFeatures;
+  usint rowSize;
+  std::vector<usint> firstRows;
+  std::vector<usint> numRows;
+  size_t shardBytes;  // ciphertexts of one shard in memory (see CiphertextBytes); every shard is at the same levels
+};
+
+/* Reads rowsToRead rows of the X and y CSV files rowsPerShard at a time (0 or anything above the
+ * ciphertext capacity means the capacity), derives -X' the way InitializeLogReg does, and encrypts and
+ * writes one shard before reading the next. Only one shard is ever in memory, in plaintext or encrypted.
+ */
+ShardStoreIndex BuildShardStore(
+    const std::string &dir,
+    CC &cc,
+    const std::string &xFile,
+    const std::string &yFile,
+    int rowsToRead,
+    float lrGamma,
+    usint rowSize,
+    usint numSlots,
+    usint rowsPerShard,
+    const KeyPair &keys,
+    const DataLevels &levels
+);
+
+ShardStoreIndex ReadShardStoreIndex(const std::string &dir);
+void WriteShard(const std::string &dir, usint shard, const DataShard &data);
+DataShard ReadShard(const std::string &dir, usint shard, const ShardStoreIndex &index);
+
+/* Hands out the shards of a store in order, starting over after the last one. While the caller works on
+ * a shard, the next one is deserialized on a background thread (double buffering), so at most two
+ * shards are in memory whatever the size of the data set. A store with a single shard is read once.
+ */
+class ShardStream {
+ public:
+  explicit ShardStream(const std::string &dir);
+
+  ShardStream(const ShardStream &) = delete;
+  ShardStream &operator=(const ShardStream &) = delete;
+
+  DataShard Next();
+
+  usint NumShards() const { return index.numRows.size(); }
+  const ShardStoreIndex &Index() const { return index; }
+  // How long the last Next() waited for a read the prefetch had not finished
+  double LastWaitMs() const { return lastWaitMs; }
+
+ private:
+  void Prefetch(usint shard);
+
+  std::string dir;
+  ShardStoreIndex index;
+  usint nextShard = 0;
+  std::shared_future<DataShard> pending;
+  double lastWaitMs = 0;
+};
+
+#endif //DPRIVE_ML__CT_STORE_H_
@@ -161,3 +161,53 @@ void LoadDataFile(
   }
 
 }
+
+void ReadDataShape(std::string filename, int rowsToRead, usint &numRows, usint &numCols) {
+  std::ifstream is(filename);
+  if (!is.is_open()) {
+    std::cerr << "Error reading in file " << filename << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::vector<std::string> featureNames;
+  ReadHeader(is, featureNames);
+  numCols = featureNames.size();
+
+  if (rowsToRead < 0)
+    rowsToRead = std::numeric_limits<int>::max();
+  numRows = 0;
+  std::string line;
+  while ((int) numRows < rowsToRead && getline(is, line)) {
+    if (!line.empty()) numRows++;
+  }
+}
+
+std::string JsonField(const std::string &line, const std::string &key) {
+  auto pos = line.find("\"" + key + "\":");
+  if (pos == std::string::npos) return "";
+  pos = line.find_first_not_of(" \"", pos + key.size() + 3);
+  auto end = line.find_first_of(",\"}", pos);
+  return line.substr(pos, end - pos);
+}
+
+CsvRowReader::CsvRowReader(const std::string &filename, int rowsToRead)
+    : is(filename), remaining((rowsToRead < 0) ? std::numeric_limits<int>::max() : rowsToRead) {
+  if (!is) {
+    std::cerr << "Error reading in file " << filename << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::string header;
+  getline(is, header);
+}
+
+bool CsvRowReader::Next(Vec &row) {
+  std::string line;
+  if (remaining <= 0 || !getline(is, line)) return false;
+  remaining--;
+  row.clear();
+  std::string tok;
+  std::stringstream ss(line);
+  while (getline(ss, tok, ',')) {
+    row.push_back(stof(tok));
+  }
+  return true;
+}
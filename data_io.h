@@ -32,6 +32,7 @@
 #ifndef DPRIVE_ML__DATA_IO_H_
 #define DPRIVE_ML__DATA_IO_H_
 
+#include <fstream>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -52,4 +53,28 @@ void ReadData(std::istream &is, Mat &data, int maxLines = -1);
  */
 void LoadDataFile(std::string filename, Mat &data, std::vector<std::string> &featureNames, int rowsToRead, bool normalize_flag);
 
+/* Counts the data rows (up to rowsToRead if non-negative) and columns of a CSV file without loading it.
+ */
+void ReadDataShape(std::string filename, int rowsToRead, usint &numRows, usint &numCols);
+
+/* Extracts the value of "key" from a single-line JSON object, as bench_lr writes its results.
+ * Returns an empty string if the key is missing.
+ */
+std::string JsonField(const std::string &line, const std::string &key);
+
+/* Reads a CSV file one record at a time, parsed the same way as ReadData, so a data set can be
+ * consumed without holding it in memory. The header is skipped on open.
+ */
+class CsvRowReader {
+ public:
+  CsvRowReader(const std::string &filename, int rowsToRead);
+
+  // Reads the next record into row; returns false once rowsToRead records are read or the file ends
+  bool Next(Vec &row);
+
+ private:
+  std::ifstream is;
+  int remaining;
+};
+
 #endif //DPRIVE_ML__DATA_IO_H_
@@ -0,0 +1,231 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__DEPTH_PLAN_H_
+#define DPRIVE_ML__DEPTH_PLAN_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+////////// Multiplicative depth of the training pipeline, at compile time ///////////////////////////////
+
+/* Highest Chebyshev degree per depth, from depth 4 on. Taken from the table in
+ * https://github.com/openfheorg/openfhe-development/blob/main/src/pke/examples/FUNCTION_EVALUATION.md
+ */
+constexpr uint32_t CHEBYSHEV_MAX_DEGREES[] = {5, 13, 27, 59, 119, 247, 495, 1007, 2031};
+constexpr uint32_t CHEBYSHEV_MIN_DEPTH = 4;
+constexpr uint32_t CHEBYSHEV_NUM_DEPTHS = sizeof(CHEBYSHEV_MAX_DEGREES) / sizeof(CHEBYSHEV_MAX_DEGREES[0]);
+
+// Depth of EvalChebyshevFunction/EvalLogistic at this degree, 0 above 2031
+constexpr uint32_t ChebyshevDepthOf(uint32_t degree) {
+  for (uint32_t i = 0; i < CHEBYSHEV_NUM_DEPTHS; i++) {
+    if (degree <= CHEBYSHEV_MAX_DEGREES[i]) return CHEBYSHEV_MIN_DEPTH + i;
+  }
+  return 0;
+}
+
+/* Least-squares sigmoids (-q) up to this degree can be evaluated in the power basis instead (UsesPowerSeries in
+ * cheb_cache.h): every power u^(2^j) is one squaring deeper than the last, and the polynomial is split in halves
+ * at the highest one, so a degree below 2^m takes m levels. That is 2/3/4 levels for degrees 3/7/15, against
+ * 4/5/6 for EvalChebyshevSeries, which first maps its input to [-1, 1] and pays a level for it.
+ */
+constexpr uint32_t POWER_SERIES_MAX_DEGREE = 15;
+
+// Depth of the power-basis evaluation at this degree, 0 above POWER_SERIES_MAX_DEGREE
+constexpr uint32_t PowerSeriesDepthOf(uint32_t degree) {
+  if (degree == 0 || degree > POWER_SERIES_MAX_DEGREE) return 0;
+  uint32_t depth = 0;
+  for (; degree > 0; degree >>= 1) depth++;
+  return depth;
+}
+
+// Depth of the sigmoid at this degree with either evaluator, 0 if the degree is out of its range
+constexpr uint32_t SigmoidDepthOf(uint32_t degree, bool powerSeries) {
+  return powerSeries ? PowerSeriesDepthOf(degree) : ChebyshevDepthOf(degree);
+}
+
+/* The stages of a NAG iteration, from a refreshed ctWeights to the repacked one, and the levels each
+ * consumes. Rotations, additions and EvalSumRows/Cols' own rotations are free.
+ */
+struct UnpackStage {     // theta/phi mask multiplication
+  static constexpr uint32_t levels = 1;
+};
+struct MatVecRowStage {  // X * theta, then the masking multiplication inside EvalSumCols
+  static constexpr uint32_t levels = 2;
+};
+template <uint32_t Degree>
+struct SigmoidEvalStage {  // EvalLogistic / EvalChebyshevSeries
+  static_assert(Degree > 0 && ChebyshevDepthOf(Degree) > 0, "Chebyshev degree must be in 1..2031");
+  static constexpr uint32_t levels = ChebyshevDepthOf(Degree);
+};
+template <uint32_t Degree>
+struct SigmoidPowerSeriesStage {  // TracedEvalLogistic on logits scaled to [-1, 1] (UsesPowerSeries)
+  static_assert(Degree > 0 && PowerSeriesDepthOf(Degree) > 0, "power-basis degree must be in 1..15");
+  static constexpr uint32_t levels = PowerSeriesDepthOf(Degree);
+};
+template <uint32_t Degree, bool PowerSeries>
+using SigmoidStageOf = std::conditional_t<PowerSeries, SigmoidPowerSeriesStage<Degree>, SigmoidEvalStage<Degree>>;
+struct MatVecColStage {  // -X' * (sigmoid - y)
+  static constexpr uint32_t levels = 1;
+};
+struct MomentumStage {   // eta * (phi' - phi)
+  static constexpr uint32_t levels = 1;
+};
+struct RepackStage {     // theta/phi mask multiplications
+  static constexpr uint32_t levels = 1;
+};
+struct LossTermsStage {  // EncLogRegLoss after the softplus: the label product and the row mask
+  static constexpr uint32_t levels = 2;
+};
+
+template <class... Stages>
+struct Pipeline {
+  static constexpr uint32_t levels = (Stages::levels + ... + 0);
+};
+
+template <uint32_t Degree, bool PowerSeries = false>
+using NagIterationPipeline = Pipeline<UnpackStage, MatVecRowStage, SigmoidStageOf<Degree, PowerSeries>,
+                                      MatVecColStage, MomentumStage, RepackStage>;
+// from a refreshed ctWeights to the logits, where the encrypted loss branches off
+using LogitsPipeline = Pipeline<UnpackStage, MatVecRowStage>;
+template <uint32_t LossDegree>
+using EncryptedLossPipeline = Pipeline<SigmoidEvalStage<LossDegree>, LossTermsStage>;
+// lr_infer: sigmoid(X * theta) on a fresh feature ciphertext
+template <uint32_t Degree>
+using InferencePipeline = Pipeline<MatVecRowStage, SigmoidEvalStage<Degree>>;
+
+/* The same sums for degrees only known at run time (-q, -G, -g). They use the stage descriptors above,
+ * and CheckedTrainingDepth below asserts that both agree.
+ */
+constexpr uint32_t NagIterationLevels(uint32_t degree, bool powerSeries = false) {
+  return UnpackStage::levels + MatVecRowStage::levels + SigmoidDepthOf(degree, powerSeries) +
+      MatVecColStage::levels + MomentumStage::levels + RepackStage::levels;
+}
+
+constexpr uint32_t EncryptedLossLevels(uint32_t lossDegree) {
+  return ChebyshevDepthOf(lossDegree) + LossTermsStage::levels;
+}
+
+struct TrainingVariant {
+  uint32_t degree;              // sigmoid degree of the last iteration of a refresh cycle
+  uint32_t intermediateDegree;  // and of the others
+  uint32_t itersPerRefresh;
+  uint32_t lossDegree;          // softplus degree of the encrypted loss, 0 without it
+  bool powerSeries;             // both sigmoids are evaluated in the power basis (UsesPowerSeries)
+};
+
+struct TrainingDepth {
+  bool supported;           // every degree is at most 2031 (15 in the power basis)
+  uint32_t iterationLevels;
+  uint32_t cycleLevels;     // itersPerRefresh iterations
+  uint32_t lossLevels;      // from a refresh to the encrypted loss of the cycle's first iteration, 0 without it
+  uint32_t requiredLevels;  // what a refresh has to leave: the cycle, or the loss if it goes deeper
+};
+
+constexpr TrainingDepth PlanTrainingDepth(const TrainingVariant &variant) {
+  TrainingDepth depth{};
+  uint32_t iters = std::max(variant.itersPerRefresh, 1u);
+  depth.supported = SigmoidDepthOf(variant.degree, variant.powerSeries) > 0 &&
+      SigmoidDepthOf(variant.intermediateDegree, variant.powerSeries) > 0 &&
+      (variant.lossDegree == 0 || ChebyshevDepthOf(variant.lossDegree) > 0);
+  depth.iterationLevels = NagIterationLevels(variant.degree, variant.powerSeries);
+  depth.cycleLevels = depth.iterationLevels +
+      (iters - 1) * NagIterationLevels(variant.intermediateDegree, variant.powerSeries);
+  depth.lossLevels = (variant.lossDegree > 0) ? LogitsPipeline::levels + EncryptedLossLevels(variant.lossDegree) : 0;
+  depth.requiredLevels = std::max(depth.cycleLevels, depth.lossLevels);
+  return depth;
+}
+
+/* Levels added on top of requiredLevels before a bootstrap. One level of headroom, as the hand-set
+ * configuration always had, and on 64-bit builds one more: OpenFHE's 64-bit EvalBootstrap first scales
+ * its input down by a correction factor (emulating a larger q0), which takes a level from the ciphertext.
+ * Without it the 64-bit runs failed with "DCRTPolyImpl's towers are not initialized".
+ */
+constexpr uint32_t BOOTSTRAP_HEADROOM_LEVELS = 1;
+constexpr uint32_t NATIVE64_BOOTSTRAP_LEVELS = 1;
+
+/* Compile-time check of a configuration: instantiating it fails the build if a degree is out of range, if the
+ * template pipelines and the run-time sums disagree, or if the encrypted loss or the data ciphertexts would
+ * not fit into the levels a refresh leaves.
+ */
+template <uint32_t Degree, uint32_t IntermediateDegree, uint32_t ItersPerRefresh, uint32_t LossDegree = 0,
+          bool PowerSeries = false>
+struct CheckedTrainingDepth {
+  static constexpr TrainingDepth depth =
+      PlanTrainingDepth(TrainingVariant{Degree, IntermediateDegree, ItersPerRefresh, LossDegree, PowerSeries});
+
+  static_assert(depth.supported, "Chebyshev degree must be in 1..2031");
+  static_assert(NagIterationPipeline<Degree, PowerSeries>::levels == depth.iterationLevels,
+                "NagIterationLevels disagrees with the stage descriptors");
+  static_assert(depth.cycleLevels == NagIterationPipeline<Degree, PowerSeries>::levels +
+                    (std::max(ItersPerRefresh, 1u) - 1) *
+                        NagIterationPipeline<IntermediateDegree, PowerSeries>::levels,
+                "the refresh cycle disagrees with the stage descriptors");
+  static_assert(LossDegree == 0 ||
+                    LogitsPipeline::levels + EncryptedLossPipeline<(LossDegree > 0 ? LossDegree : 1)>::levels <=
+                        depth.requiredLevels,
+                "the encrypted loss does not fit after a refresh");
+  // y and -X' are consumed after the cheaper sigmoid, one level below that (GradientDataLevels)
+  static_assert(LogitsPipeline::levels + std::min(SigmoidStageOf<Degree, PowerSeries>::levels,
+                                                  SigmoidStageOf<IntermediateDegree, PowerSeries>::levels) - 1 <
+                    depth.requiredLevels,
+                "the data ciphertexts would be encrypted below the last level");
+
+  static constexpr bool ok = true;
+};
+
+/* The configurations the programs ship with: the degree 59 interpolation (lr_nag, lr_sweep, the daemon), with and
+ * without the encrypted loss, a cheaper intermediate degree, and the least-squares sigmoids (-q) with either
+ * evaluator.
+ */
+constexpr uint32_t DEFAULT_CHEBYSHEV_DEGREE = 59;
+constexpr uint32_t DEFAULT_SOFTPLUS_DEGREE = 59;
+static_assert(CheckedTrainingDepth<DEFAULT_CHEBYSHEV_DEGREE, DEFAULT_CHEBYSHEV_DEGREE, 1>::ok, "");
+static_assert(CheckedTrainingDepth<DEFAULT_CHEBYSHEV_DEGREE, DEFAULT_CHEBYSHEV_DEGREE, 1,
+                                   DEFAULT_SOFTPLUS_DEGREE>::ok, "");
+static_assert(CheckedTrainingDepth<DEFAULT_CHEBYSHEV_DEGREE, 13, 2, DEFAULT_SOFTPLUS_DEGREE>::ok, "");
+static_assert(CheckedTrainingDepth<3, 3, 1, DEFAULT_SOFTPLUS_DEGREE>::ok, "");
+static_assert(CheckedTrainingDepth<5, 5, 1, DEFAULT_SOFTPLUS_DEGREE>::ok, "");
+static_assert(CheckedTrainingDepth<7, 7, 1, DEFAULT_SOFTPLUS_DEGREE>::ok, "");
+static_assert(CheckedTrainingDepth<15, 15, 1, DEFAULT_SOFTPLUS_DEGREE>::ok, "");
+static_assert(CheckedTrainingDepth<3, 3, 1, DEFAULT_SOFTPLUS_DEGREE, true>::ok, "");
+static_assert(CheckedTrainingDepth<5, 5, 1, DEFAULT_SOFTPLUS_DEGREE, true>::ok, "");
+static_assert(CheckedTrainingDepth<7, 7, 1, DEFAULT_SOFTPLUS_DEGREE, true>::ok, "");
+static_assert(CheckedTrainingDepth<15, 15, 1, DEFAULT_SOFTPLUS_DEGREE, true>::ok, "");
+static_assert(CheckedTrainingDepth<15, 3, 2, 0, true>::ok, "");
+static_assert(SigmoidPowerSeriesStage<3>::levels == 2 && SigmoidPowerSeriesStage<7>::levels == 3 &&
+                  SigmoidPowerSeriesStage<15>::levels == 4,
+              "the power basis is documented as 2/3/4 levels for degrees 3/7/15");
+static_assert(NagIterationPipeline<DEFAULT_CHEBYSHEV_DEGREE>::levels == 13,
+              "the degree 59 interpolation is documented as 13 levels per iteration");
+
+#endif //DPRIVE_ML__DEPTH_PLAN_H_
@@ -34,6 +34,7 @@
 
 #include "openfhe.h"
 #include "lr_types.h"
+#include "he_tracer.h"
 
 // convert 1d vector to row cloned (input must be zero padded to power of two
 // output is a VEC_ROW_CLONED
@@ -63,9 +64,9 @@ void MatrixVectorProductRow(
     lbcrypto::Ciphertext<Element> &cProduct
 ) {
   OPENFHE_DEBUG_FLAG(false);
-  auto cMult = context->EvalMult(cMat, cVecRowCloned);
+  auto cMult = TracedEvalMult(context, cMat, cVecRowCloned);
   OPENFHE_DEBUG(cMult->GetLevel());
-  cProduct = context->EvalSumCols(cMult, rowSize, *evalSumCols);
+  cProduct = TracedEvalSumCols(context, cMult, rowSize, evalSumCols);
   OPENFHE_DEBUG(cProduct->GetLevel());
 }
 
@@ -80,8 +81,8 @@ void MatrixVectorProductCol(
     const uint32_t rowSize,
     lbcrypto::Ciphertext<Element> &cProduct
 ) {
-  auto cMult = context->EvalMult(cMat, cVecColCloned);
-  cProduct = context->EvalSumRows(cMult, rowSize, *evalSumRows);
+  auto cMult = TracedEvalMult(context, cMat, cVecColCloned);
+  cProduct = TracedEvalSumRows(context, cMult, rowSize, evalSumRows);
 }
 
 template<typename type>
@@ -0,0 +1,291 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "exec_config.h"
+#include "openfhe.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <sched.h>
+#include <set>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+const std::vector<std::string> EXEC_PHASES = {
+    "setup", "refresh", "unpack", "gradient", "loss", "nag_update", "monitor", "repack"
+};
+
+std::vector<int> ParseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") continue;
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+static std::set<int> AllowedCpus() {
+  std::set<int> allowed;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) allowed.insert(cpu);
+    }
+  }
+  if (allowed.empty()) {
+    for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); cpu++) allowed.insert(cpu);
+  }
+  return allowed;
+}
+
+std::vector<std::vector<int>> ReadNumaTopology() {
+  auto allowed = AllowedCpus();
+  std::map<int, std::vector<int>> nodes;
+  DIR *dir = opendir("/sys/devices/system/node");
+  if (dir) {
+    while (auto *entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+          !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+        continue;
+      }
+      std::ifstream ifs("/sys/devices/system/node/" + name + "/cpulist");
+      std::string list;
+      if (!getline(ifs, list)) continue;
+      std::vector<int> cpus;
+      for (int cpu : ParseCpuList(list)) {
+        if (allowed.count(cpu)) cpus.push_back(cpu);
+      }
+      if (!cpus.empty()) nodes[std::stoi(name.substr(4))] = cpus;
+    }
+    closedir(dir);
+  }
+
+  std::vector<std::vector<int>> topology;
+  for (auto &node : nodes) topology.push_back(node.second);
+  if (topology.empty()) topology.emplace_back(allowed.begin(), allowed.end());
+  return topology;
+}
+
+void PinCurrentThread(const std::vector<int> &cpus) {
+  if (cpus.empty()) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) CPU_SET(cpu, &set);
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    std::cerr << "Warning: could not set the CPU affinity of a thread" << std::endl;
+  }
+}
+
+void PinOpenMPTeam(const std::vector<int> &cpus, int numThreads) {
+  if (cpus.empty()) return;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads)
+  {
+    PinCurrentThread({cpus[omp_get_thread_num() % cpus.size()]});
+  }
+#else
+  PinCurrentThread({cpus[0]});
+#endif
+}
+
+ExecConfig ExecConfig::FromOptions(const ExecOptions &options) {
+  ExecConfig config;
+  config.totalThreads = std::max(0, options.threads);
+  std::stringstream ss(options.phaseThreads);
+  std::string entry;
+  while (getline(ss, entry, ',')) {
+    if (entry.empty()) continue;
+    auto eq = entry.find('=');
+    std::string phase = entry.substr(0, eq);
+    std::transform(phase.begin(), phase.end(), phase.begin(), ::tolower);
+    if (eq == std::string::npos || std::find(EXEC_PHASES.begin(), EXEC_PHASES.end(), phase) == EXEC_PHASES.end()) {
+      std::cerr << "Invalid phase thread count " << entry << " (use <phase>=<n> with phase one of setup, refresh,"
+                << " unpack, gradient, loss, nag_update, monitor, repack)" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    int threads = atoi(entry.substr(eq + 1).c_str());
+    if (threads > 0) config.phaseThreads[phase] = threads;
+  }
+  config.nested = options.nested;
+  config.numaNode = options.numaNode;
+
+  if (options.pin == "compact") {
+    config.pin = PIN_COMPACT;
+  } else if (options.pin == "spread") {
+    config.pin = PIN_SPREAD;
+  } else if (options.pin != "none") {
+    std::cerr << "Unknown pinning policy " << options.pin << " (use none, compact or spread)" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  config.topology = ReadNumaTopology();
+  if (config.numaNode >= int(config.topology.size())) {
+    std::cerr << "NUMA node " << config.numaNode << " requested but only " << config.topology.size()
+              << " NUMA node(s) are available" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (config.numaNode >= 0) {
+    config.cpuOrder = config.topology[config.numaNode];
+    // a single node does not have the cores for the machine-wide default
+    if (config.totalThreads == 0) config.totalThreads = config.cpuOrder.size();
+  } else if (config.pin == PIN_SPREAD) {
+    size_t numCpus = 0;
+    for (auto &node : config.topology) numCpus += node.size();
+    for (size_t i = 0; config.cpuOrder.size() < numCpus; i++) {
+      for (auto &node : config.topology) {
+        if (i < node.size()) config.cpuOrder.push_back(node[i]);
+      }
+    }
+  } else {
+    for (auto &node : config.topology) {
+      config.cpuOrder.insert(config.cpuOrder.end(), node.begin(), node.end());
+    }
+  }
+  return config;
+}
+
+void ExecConfig::Apply() {
+#ifdef _OPENMP
+  if (nested >= 0) omp_set_max_active_levels(nested ? 2 : 1);
+  if (totalThreads > 0) omp_set_num_threads(totalThreads);
+
+  int teamSize = omp_get_max_threads();
+  for (auto &phase : phaseThreads) teamSize = std::max(teamSize, phase.second);
+  if (pin != PIN_NONE) {
+    PinOpenMPTeam(cpuOrder, teamSize);
+  } else if (numaNode >= 0) {
+    // no per-thread pinning, but keep every thread on the node
+#pragma omp parallel num_threads(teamSize)
+    {
+      PinCurrentThread(cpuOrder);
+    }
+  }
+#else
+  if (numaNode >= 0) PinCurrentThread(cpuOrder);
+#endif
+}
+
+int ExecConfig::ThreadsFor(const std::string &phase) const {
+  auto found = phaseThreads.find(phase);
+  if (found != phaseThreads.end()) return found->second;
+  if (totalThreads > 0) return totalThreads;
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+void ExecConfig::EnterPhase(const std::string &phase) const {
+#ifdef _OPENMP
+  if (totalThreads > 0 || !phaseThreads.empty()) omp_set_num_threads(ThreadsFor(phase));
+#endif
+}
+
+std::vector<std::vector<int>> ExecConfig::WorkerCpus(usint numWorkers, int innerThreads) const {
+  std::vector<std::vector<int>> workerCpus;
+  if (pin == PIN_NONE && numaNode < 0) return workerCpus;
+
+  if (pin == PIN_SPREAD && numaNode < 0 && topology.size() > 1) {
+    // whole workers are dealt round robin over the nodes, so no worker straddles two nodes
+    std::vector<size_t> next(topology.size(), 0);
+    for (usint w = 0; w < numWorkers; w++) {
+      auto &node = topology[w % topology.size()];
+      auto &pos = next[w % topology.size()];
+      std::vector<int> cpus;
+      for (int k = 0; k < innerThreads; k++) cpus.push_back(node[pos++ % node.size()]);
+      workerCpus.push_back(cpus);
+    }
+  } else {
+    for (usint w = 0; w < numWorkers; w++) {
+      std::vector<int> cpus;
+      for (int k = 0; k < innerThreads; k++) cpus.push_back(cpuOrder[(w * innerThreads + k) % cpuOrder.size()]);
+      workerCpus.push_back(cpus);
+    }
+  }
+  return workerCpus;
+}
+
+static std::string CpuListString(const std::vector<int> &cpus) {
+  std::string out;
+  for (size_t i = 0; i < cpus.size(); i++) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+    if (!out.empty()) out += ",";
+    out += std::to_string(cpus[i]);
+    if (j > i) out += "-" + std::to_string(cpus[j]);
+    i = j;
+  }
+  return out;
+}
+
+void ExecConfig::Report(std::ostream &os) const {
+  os << "*********************************************" << std::endl;
+  os << "Execution Configuration" << std::endl;
+  for (size_t node = 0; node < topology.size(); node++) {
+    os << "\tNUMA node " << node << ": CPUs " << CpuListString(topology[node]) << std::endl;
+  }
+#ifdef _OPENMP
+  os << "\tOpenMP threads: " << omp_get_max_threads() << (totalThreads > 0 ? " (-H)" : " (default)")
+     << std::endl;
+  os << "\tOpenMP max active levels: " << omp_get_max_active_levels()
+     << (nested >= 0 ? " (-N)" : " (default)") << std::endl;
+#else
+  os << "\tOpenMP: not available, running single-threaded" << std::endl;
+#endif
+  for (auto &phase : EXEC_PHASES) {
+    os << "\tThreads in " << phase << ": " << ThreadsFor(phase)
+       << (phaseThreads.count(phase) ? " (-J)" : "") << std::endl;
+  }
+  const char *pinNames[] = {"none", "compact", "spread"};
+  os << "\tPinning: " << pinNames[pin];
+  if (pin != PIN_NONE || numaNode >= 0) os << " over CPUs " << CpuListString(cpuOrder);
+  os << std::endl;
+  os << "\tNUMA node: " << ((numaNode >= 0) ? std::to_string(numaNode) + " (data and keys first touched there)"
+                                            : std::string("all")) << std::endl;
+  for (auto var : {"OMP_PROC_BIND", "OMP_PLACES"}) {
+    if (getenv(var)) {
+      os << "\tNOTE: " << var << "=" << getenv(var) << " is set and may conflict with -B" << std::endl;
+    }
+  }
+}
@@ -0,0 +1,111 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__EXEC_CONFIG_H_
+#define DPRIVE_ML__EXEC_CONFIG_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include "lr_types.h"
+
+////////// Thread budget, nesting and CPU/NUMA placement ///////////////////////////////
+
+enum PinPolicy {
+  PIN_NONE,     // leave placement to the OS
+  PIN_COMPACT,  // OpenMP thread i on the i-th allowed CPU, filling one NUMA node before the next
+  PIN_SPREAD,   // OpenMP threads dealt round robin over the NUMA nodes
+};
+
+// CPUs of every NUMA node, from /sys/devices/system/node (one node holding all CPUs if unavailable)
+std::vector<std::vector<int>> ReadNumaTopology();
+
+// Parses a Linux CPU list such as "0-3,8,10-11"
+std::vector<int> ParseCpuList(const std::string &list);
+
+// Restricts the calling thread to cpus
+void PinCurrentThread(const std::vector<int> &cpus);
+
+/* Starts an OpenMP team of numThreads threads from the calling thread and pins its thread i to
+ * cpus[i % cpus.size()]. OpenMP keeps reusing these threads for later regions of the same caller.
+ */
+void PinOpenMPTeam(const std::vector<int> &cpus, int numThreads);
+
+/* Execution options as given on the command line (the same letters in lr_nag, lr_sweep and lr_train_daemon):
+ *   -H <n>                    OpenMP threads (default: OpenMP's own default)
+ *   -J <phase>=<n>,...        threads for single training phases: setup, refresh, unpack, gradient,
+ *                             loss, nag_update, monitor, repack
+ *   -N 0|1                    allow nested OpenMP regions inside OpenFHE (max active levels 1 or 2)
+ *   -B none|compact|spread    pin the OpenMP threads
+ *   -O <node>                 run on the CPUs of a single NUMA node only. Every thread then runs there, so the
+ *                             keys, data and ciphertexts are first touched (and so allocated) on that node.
+ */
+struct ExecOptions {
+  int threads = 0;
+  std::string phaseThreads;
+  int nested = -1;  // -1: OpenMP default
+  std::string pin = "none";
+  int numaNode = -1;
+};
+
+// Thread budget and placement of a run, from its ExecOptions
+class ExecConfig {
+ public:
+  static ExecConfig FromOptions(const ExecOptions &options);
+
+  /* Applies the nesting policy and the default thread count, and pins the main OpenMP team. Call it
+   * before the crypto context and keys are generated so that their pages are first touched by
+   * threads placed according to this configuration.
+   */
+  void Apply();
+
+  // Sets the OpenMP thread count for the phase about to run
+  void EnterPhase(const std::string &phase) const;
+  int ThreadsFor(const std::string &phase) const;
+
+  /* Disjoint CPU sets of innerThreads CPUs for numWorkers pool workers, each taken from a single NUMA
+   * node where possible. Empty when not pinning.
+   */
+  std::vector<std::vector<int>> WorkerCpus(usint numWorkers, int innerThreads) const;
+
+  void Report(std::ostream &os) const;
+
+ private:
+  int totalThreads = 0;
+  std::map<std::string, int> phaseThreads;
+  int nested = -1;  // -1: OpenMP default
+  PinPolicy pin = PIN_NONE;
+  int numaNode = -1;
+  std::vector<std::vector<int>> topology;
+  std::vector<int> cpuOrder;  // allowed CPUs in pinning order
+};
+
+#endif //DPRIVE_ML__EXEC_CONFIG_H_
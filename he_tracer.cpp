@@ -0,0 +1,427 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "he_tracer.h"
+#include "cheb_cache.h"
+#include "cheb_plain.h"
+#include "depth_plan.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+const char *HEOpName(HEOp op) {
+  switch (op) {
+    case OP_EVAL_MULT: return "EvalMult";
+    case OP_EVAL_MULT_PT: return "EvalMultPt";
+    case OP_EVAL_MULT_CONST: return "EvalMultConst";
+    case OP_EVAL_ADD: return "EvalAdd";
+    case OP_EVAL_SUB: return "EvalSub";
+    case OP_EVAL_NEGATE: return "EvalNegate";
+    case OP_EVAL_ROTATE: return "EvalRotate";
+    case OP_EVAL_SUM_ROWS: return "EvalSumRows";
+    case OP_EVAL_SUM_COLS: return "EvalSumCols";
+    case OP_EVAL_SUM: return "EvalSum";
+    case OP_EVAL_LOGISTIC: return "EvalLogistic";
+    case OP_EVAL_CHEBYSHEV: return "EvalChebyshev";
+    case OP_KEY_SWITCH: return "KeySwitch";
+    case OP_RESCALE: return "Rescale";
+    case OP_BOOTSTRAP: return "Bootstrap";
+    case OP_ENCRYPT: return "Encrypt";
+    case OP_DECRYPT: return "Decrypt";
+    default: return "Unknown";
+  }
+}
+
+HETracer &HETracer::Get() {
+  static HETracer tracer;
+  return tracer;
+}
+
+void HETracer::SetPhase(const std::string &phase) {
+  if (!enabled) return;
+  std::lock_guard<std::mutex> lock(mutex);
+  currentPhase = phase;
+}
+
+void HETracer::Count(HEOp op, uint64_t times) {
+  if (!enabled) return;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = iterCounts.find(currentPhase);
+  if (found == iterCounts.end()) {
+    if (std::find(phaseOrder.begin(), phaseOrder.end(), currentPhase) == phaseOrder.end()) {
+      phaseOrder.push_back(currentPhase);
+    }
+    OpCounts zeros{};
+    found = iterCounts.emplace(currentPhase, zeros).first;
+  }
+  found->second[op] += times;
+}
+
+void HETracer::CountLevelsConsumed(size_t inLevel, const CT &out) {
+  if (!enabled) return;
+  if (out->GetLevel() > inLevel) {
+    Count(OP_RESCALE, out->GetLevel() - inLevel);
+  }
+}
+
+void HETracer::RecordStage(const std::string &stage, const CT &ct) {
+  if (!enabled) return;
+  StageRecord record;
+  record.stage = stage;
+  record.level = ct->GetLevel();
+  record.noiseScaleDeg = ct->GetNoiseScaleDeg();
+  record.numTowers = ct->GetElements()[0].GetNumOfElements();
+  record.log2ScalingFactor = std::log2(ct->GetScalingFactor());
+  std::lock_guard<std::mutex> lock(mutex);
+  record.phase = currentPhase;
+  stages.push_back(record);
+}
+
+void HETracer::CountAllocation(const CT &out) {
+  if (!enabled) return;
+  uint64_t bytes = 0;
+  for (auto &element : out->GetElements()) {
+    bytes += uint64_t(element.GetNumOfElements()) * element.GetRingDimension() * sizeof(lbcrypto::NativeInteger);
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  iterAllocations++;
+  iterAllocatedBytes += bytes;
+}
+
+static void PrintCounts(std::ostream &os, const OpCounts &counts, double divisor = 1.0) {
+  for (int op = 0; op < NUM_HE_OPS; op++) {
+    if (counts[op] == 0) continue;
+    os << " " << HEOpName(HEOp(op)) << "=" << double(counts[op]) / divisor;
+  }
+  os << std::endl;
+}
+
+void HETracer::ReportIteration(std::ostream &os, usint iteration, uint32_t multDepth) {
+  if (!enabled) return;
+  std::lock_guard<std::mutex> lock(mutex);
+  os << "\tHE operation trace for iteration " << iteration << std::endl;
+  OpCounts iterTotal{};
+  for (auto &phase : phaseOrder) {
+    auto found = iterCounts.find(phase);
+    if (found == iterCounts.end()) continue;
+    os << "\t\t[" << phase << "]";
+    PrintCounts(os, found->second);
+    auto &total = totalCounts[phase];
+    for (int op = 0; op < NUM_HE_OPS; op++) {
+      total[op] += found->second[op];
+      iterTotal[op] += found->second[op];
+    }
+  }
+  os << "\t\t[iteration]";
+  PrintCounts(os, iterTotal);
+  os << "\t\tResult ciphertexts allocated: " << iterAllocations << " (" << double(iterAllocatedBytes) / (1 << 20)
+     << " MB)" << std::endl;
+  totalAllocations += iterAllocations;
+  totalAllocatedBytes += iterAllocatedBytes;
+  iterAllocations = 0;
+  iterAllocatedBytes = 0;
+
+  if (!stages.empty()) {
+    os << "\t\tStage levels (level / noise deg / towers / log2 scale):" << std::endl;
+    for (auto &record : stages) {
+      os << "\t\t\t" << std::left << std::setw(12) << record.phase << std::setw(20) << record.stage << std::right
+         << record.level << " / " << record.noiseScaleDeg << " / " << record.numTowers << " / "
+         << record.log2ScalingFactor << std::endl;
+    }
+    // levels still pending a rescale are counted as consumed
+    auto first = stages.front();
+    auto deepest = std::max_element(stages.begin(), stages.end(), [](const StageRecord &a, const StageRecord &b) {
+      return a.level + a.noiseScaleDeg < b.level + b.noiseScaleDeg;
+    });
+    auto used = (deepest->level + deepest->noiseScaleDeg) - (first.level + first.noiseScaleDeg);
+    os << "\t\tLevels consumed between '" << first.stage << "' and '" << deepest->stage << "': " << used
+       << " (deepest level " << deepest->level + deepest->noiseScaleDeg - 1 << " of multDepth " << multDepth << ")"
+       << std::endl;
+  }
+  iterCounts.clear();
+  stages.clear();
+}
+
+void HETracer::ReportTotals(std::ostream &os, usint numIterations) {
+  if (!enabled) return;
+  std::lock_guard<std::mutex> lock(mutex);
+  os << "HE operation totals over " << numIterations << " iterations" << std::endl;
+  for (auto &phase : phaseOrder) {
+    auto found = totalCounts.find(phase);
+    if (found == totalCounts.end()) continue;
+    os << "\t[" << phase << "] total:";
+    PrintCounts(os, found->second);
+    if (numIterations > 0) {
+      os << "\t[" << phase << "] per iteration:";
+      PrintCounts(os, found->second, double(numIterations));
+    }
+  }
+  os << "\tResult ciphertexts allocated: " << totalAllocations << " (" << double(totalAllocatedBytes) / (1 << 20)
+     << " MB)";
+  if (numIterations > 0) {
+    os << ", per iteration: " << double(totalAllocations) / numIterations << " ("
+       << double(totalAllocatedBytes) / (1 << 20) / numIterations << " MB)";
+  }
+  os << std::endl;
+}
+
+///////////////////////////////////////////////////////////////
+// Traced wrappers
+
+static size_t MaxLevel(const CT &ct1, const CT &ct2) {
+  return std::max(ct1->GetLevel(), ct2->GetLevel());
+}
+
+CT TracedEvalMult(const CC &cc, const CT &ct1, const CT &ct2) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalMult(ct1, ct2);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_MULT);
+    tracer.Count(OP_KEY_SWITCH);
+    tracer.CountLevelsConsumed(MaxLevel(ct1, ct2), out);
+  }
+  return out;
+}
+
+CT TracedEvalMult(const CC &cc, const CT &ct, const PT &pt) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalMult(ct, pt);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_MULT_PT);
+    tracer.CountLevelsConsumed(ct->GetLevel(), out);
+  }
+  return out;
+}
+
+CT TracedEvalMult(const CC &cc, const CT &ct, double constant) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalMult(ct, constant);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_MULT_CONST);
+    tracer.CountLevelsConsumed(ct->GetLevel(), out);
+  }
+  return out;
+}
+
+CT TracedEvalAdd(const CC &cc, const CT &ct1, const CT &ct2) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalAdd(ct1, ct2);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_ADD);
+    tracer.CountLevelsConsumed(MaxLevel(ct1, ct2), out);
+  }
+  return out;
+}
+
+CT TracedEvalSub(const CC &cc, const CT &ct1, const CT &ct2) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalSub(ct1, ct2);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_SUB);
+    tracer.CountLevelsConsumed(MaxLevel(ct1, ct2), out);
+  }
+  return out;
+}
+
+CT TracedEvalRotate(const CC &cc, const CT &ct, int32_t index) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalRotate(ct, index);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_ROTATE);
+    tracer.Count(OP_KEY_SWITCH);
+  }
+  return out;
+}
+
+void TracedEvalAddInPlace(const CC &cc, CT &ct1, const CT &ct2) {
+  auto &tracer = HETracer::Get();
+  size_t inLevel = tracer.IsEnabled() ? MaxLevel(ct1, ct2) : 0;
+  cc->EvalAddInPlace(ct1, ct2);
+  if (tracer.IsEnabled()) {
+    tracer.Count(OP_EVAL_ADD);
+    tracer.CountLevelsConsumed(inLevel, ct1);
+  }
+}
+
+void TracedEvalSubInPlace(const CC &cc, CT &ct1, const CT &ct2) {
+  auto &tracer = HETracer::Get();
+  size_t inLevel = tracer.IsEnabled() ? MaxLevel(ct1, ct2) : 0;
+  cc->EvalSubInPlace(ct1, ct2);
+  if (tracer.IsEnabled()) {
+    tracer.Count(OP_EVAL_SUB);
+    tracer.CountLevelsConsumed(inLevel, ct1);
+  }
+}
+
+void TracedEvalMultInPlace(const CC &cc, CT &ct, double constant) {
+  auto &tracer = HETracer::Get();
+  size_t inLevel = ct->GetLevel();
+  cc->EvalMultInPlace(ct, constant);
+  if (tracer.IsEnabled()) {
+    tracer.Count(OP_EVAL_MULT_CONST);
+    tracer.CountLevelsConsumed(inLevel, ct);
+  }
+}
+
+void TracedEvalNegateInPlace(const CC &cc, CT &ct) {
+  cc->EvalNegateInPlace(ct);
+  HETracer::Get().Count(OP_EVAL_NEGATE);
+}
+
+CT TracedEvalSumRows(const CC &cc, const CT &ct, usint rowSize, const MatKeys &evalSumRowKeys) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalSumRows(ct, rowSize, *evalSumRowKeys);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_SUM_ROWS);
+    tracer.Count(OP_KEY_SWITCH, evalSumRowKeys->size());
+    tracer.CountLevelsConsumed(ct->GetLevel(), out);
+  }
+  return out;
+}
+
+CT TracedEvalSumCols(const CC &cc, const CT &ct, usint rowSize, const MatKeys &evalSumColKeys) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalSumCols(ct, rowSize, *evalSumColKeys);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_SUM_COLS);
+    tracer.Count(OP_KEY_SWITCH, evalSumColKeys->size());
+    tracer.CountLevelsConsumed(ct->GetLevel(), out);
+  }
+  return out;
+}
+
+CT TracedEvalSum(const CC &cc, const CT &ct, usint batchSize) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalSum(ct, batchSize);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_SUM);
+    // one rotation per doubling of the summed span
+    tracer.Count(OP_KEY_SWITCH, uint64_t(std::ceil(std::log2(batchSize))));
+    tracer.CountLevelsConsumed(ct->GetLevel(), out);
+  }
+  return out;
+}
+
+CT TracedEvalChebyshevSeries(const CC &cc, const CT &ct, const std::vector<double> &coefficients,
+                             double rangeStart, double rangeEnd) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalChebyshevSeries(ct, coefficients, rangeStart, rangeEnd);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_CHEBYSHEV);
+    tracer.CountLevelsConsumed(ct->GetLevel(), out);
+  }
+  return out;
+}
+
+// sum_{k < 2^m} c[k] u^k as a ciphertext (nullptr when only the constant is left) plus a constant
+struct PowerSum {
+  CT ct;
+  double constant;
+};
+
+/* The low half of the terms plus u^(2^(m-1)) times the high half, where powers[j] = u^(2^j). Both halves and
+ * the power are m - 1 levels deep, so the sum is m levels below u. Coefficients only ever multiply u or one of
+ * the powers, never a sum, which keeps the scalar multiplications inside those m levels.
+ */
+static PowerSum EvalPowerSum(const CC &cc, const std::vector<CT> &powers, const double *c, uint32_t m) {
+  if (m == 0) return PowerSum{nullptr, c[0]};
+  uint32_t half = 1u << (m - 1);
+  PowerSum low = EvalPowerSum(cc, powers, c, m - 1);
+  PowerSum high = EvalPowerSum(cc, powers, c + half, m - 1);
+  CT sum = low.ct;
+  auto add = [&](const CT &term) { sum = sum ? cc->EvalAdd(sum, term) : term; };
+  if (high.ct) add(cc->EvalMult(powers[m - 1], high.ct));
+  if (high.constant != 0) add(cc->EvalMult(powers[m - 1], high.constant));
+  return PowerSum{sum, low.constant};
+}
+
+// sum_k coefficients[k] ct^k, at PowerSeriesDepthOf(degree) levels
+static CT EvalPowerSeries(const CC &cc, const CT &ct, const std::vector<double> &coefficients) {
+  uint32_t m = PowerSeriesDepthOf(uint32_t(coefficients.size() - 1));
+  std::vector<double> padded(coefficients);
+  padded.resize(size_t(1) << m, 0.0);
+  std::vector<CT> powers{ct};
+  for (uint32_t j = 1; j < m; j++) powers.push_back(cc->EvalSquare(powers.back()));
+  PowerSum sum = EvalPowerSum(cc, powers, padded.data(), m);
+  if (!sum.ct) sum.ct = cc->EvalMult(ct, 0.0);
+  return cc->EvalAdd(sum.ct, sum.constant);
+}
+
+CT TracedEvalLogistic(const CC &cc, const CT &ct, double rangeStart, double rangeEnd, uint32_t degree,
+                      SigmoidApprox approx, double logitScale) {
+  auto &tracer = HETracer::Get();
+  auto &coefficients = ChebyshevCache::Get().Coefficients(SigmoidCacheName(approx), rangeStart, rangeEnd, degree);
+  CT out;
+  if (UsesPowerSeries(approx, rangeStart, rangeEnd, degree, logitScale)) {
+    out = EvalPowerSeries(cc, ct, ChebyshevToPowerBasis(coefficients, rangeStart, rangeEnd, logitScale));
+  } else {
+    out = cc->EvalChebyshevSeries(ct, coefficients, rangeStart / logitScale, rangeEnd / logitScale);
+  }
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_EVAL_LOGISTIC);
+    tracer.CountLevelsConsumed(ct->GetLevel(), out);
+  }
+  return out;
+}
+
+CT TracedEvalBootstrap(const CC &cc, const CT &ct, uint32_t numIterations, uint32_t precision) {
+  auto &tracer = HETracer::Get();
+  auto out = cc->EvalBootstrap(ct, numIterations, precision);
+  if (tracer.IsEnabled()) {
+    tracer.CountAllocation(out);
+    tracer.Count(OP_BOOTSTRAP, numIterations);
+  }
+  return out;
+}
+
+CT TracedEncrypt(const CC &cc, const KeyPair &keys, const PT &pt) {
+  auto &tracer = HETracer::Get();
+  tracer.Count(OP_ENCRYPT);
+  auto out = cc->Encrypt(keys.publicKey, pt);
+  tracer.CountAllocation(out);
+  return out;
+}
+
+void TracedDecrypt(const CC &cc, const KeyPair &keys, const CT &ct, PT *pt) {
+  HETracer::Get().Count(OP_DECRYPT);
+  cc->Decrypt(keys.secretKey, ct, pt);
+}
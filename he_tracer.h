@@ -0,0 +1,169 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__HE_TRACER_H_
+#define DPRIVE_ML__HE_TRACER_H_
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "openfhe.h"
+#include "lr_types.h"
+#include "cheb_cache.h"
+
+////////// Instrumentation of the homomorphic operations used during training ///////////////////////////////
+
+/* Operations we count. Composite operations (EvalSum*, EvalLogistic, EvalChebyshevSeries, EvalBootstrap)
+ * are counted once each; the key-switches they perform internally are only estimated for the
+ * EvalSum* family (one per automorphism key in the supplied key map). Rescales are not issued
+ * explicitly under FIXEDAUTO, so they are derived from the level an operation consumed.
+ */
+enum HEOp {
+  OP_EVAL_MULT = 0,     // ciphertext x ciphertext (includes a relinearization)
+  OP_EVAL_MULT_PT,      // ciphertext x plaintext
+  OP_EVAL_MULT_CONST,   // ciphertext x scalar
+  OP_EVAL_ADD,
+  OP_EVAL_SUB,
+  OP_EVAL_NEGATE,
+  OP_EVAL_ROTATE,
+  OP_EVAL_SUM_ROWS,
+  OP_EVAL_SUM_COLS,
+  OP_EVAL_SUM,
+  OP_EVAL_LOGISTIC,
+  OP_EVAL_CHEBYSHEV,    // Chebyshev series of anything but the sigmoid
+  OP_KEY_SWITCH,
+  OP_RESCALE,
+  OP_BOOTSTRAP,
+  OP_ENCRYPT,
+  OP_DECRYPT,
+  NUM_HE_OPS
+};
+
+const char *HEOpName(HEOp op);
+
+// Level and scaling factor of a ciphertext at a named stage boundary
+struct StageRecord {
+  std::string phase;
+  std::string stage;
+  size_t level;
+  size_t noiseScaleDeg;
+  usint numTowers;
+  double log2ScalingFactor;
+};
+
+using OpCounts = std::array<uint64_t, NUM_HE_OPS>;
+
+/* Process-wide operation counter and level tracer. Disabled by default, in which case every
+ * call below is a single branch. Counts are kept per phase (set by the caller with SetPhase)
+ * for the current iteration and accumulated into run totals by ReportIteration.
+ * Counting is thread-safe, so shard gradients running on a thread pool can be traced; they all
+ * count into the phase that was current when they started.
+ * Every wrapper that returns a new ciphertext also counts it as an allocation, with its size. Temporaries
+ * that OpenFHE creates inside an operation (EvalSum*, the Chebyshev series, bootstrapping, level
+ * adjustments) are not seen, so this is a lower bound on the heap traffic.
+ */
+class HETracer {
+ public:
+  static HETracer &Get();
+
+  void Enable(bool enable) { enabled = enable; }
+  bool IsEnabled() const { return enabled; }
+
+  void SetPhase(const std::string &phase);
+  void Count(HEOp op, uint64_t times = 1);
+
+  // Counts the rescales implied by an operation taking inputs at inLevel to out
+  void CountLevelsConsumed(size_t inLevel, const CT &out);
+
+  void RecordStage(const std::string &stage, const CT &ct);
+
+  // Counts a result ciphertext; the in-place wrappers write into their first operand and don't call this
+  void CountAllocation(const CT &out);
+
+  // Prints this iteration's per-phase counts and stage records, then folds them into the totals
+  void ReportIteration(std::ostream &os, usint iteration, uint32_t multDepth);
+
+  // Prints the run totals and the per-iteration average
+  void ReportTotals(std::ostream &os, usint numIterations);
+
+ private:
+  HETracer() = default;
+
+  bool enabled = false;
+  std::mutex mutex;
+  std::string currentPhase = "setup";
+  std::vector<std::string> phaseOrder;
+  std::map<std::string, OpCounts> iterCounts;
+  std::map<std::string, OpCounts> totalCounts;
+  std::vector<StageRecord> stages;
+  uint64_t iterAllocations = 0;
+  uint64_t iterAllocatedBytes = 0;
+  uint64_t totalAllocations = 0;
+  uint64_t totalAllocatedBytes = 0;
+};
+
+///////////////////////////////////////////////////////////////
+// Traced wrappers around the CryptoContext calls used by the training code.
+// Each forwards to the CryptoContext and, when tracing is enabled, records the operation.
+
+CT TracedEvalMult(const CC &cc, const CT &ct1, const CT &ct2);
+CT TracedEvalMult(const CC &cc, const CT &ct, const PT &pt);
+CT TracedEvalMult(const CC &cc, const CT &ct, double constant);
+CT TracedEvalAdd(const CC &cc, const CT &ct1, const CT &ct2);
+CT TracedEvalSub(const CC &cc, const CT &ct1, const CT &ct2);
+CT TracedEvalRotate(const CC &cc, const CT &ct, int32_t index);
+
+/* In-place variants: the result replaces ct1 (ct) instead of being allocated. CT is a shared pointer, so
+ * only use them on ciphertexts nothing else holds, e.g. the result of an earlier operation.
+ */
+void TracedEvalAddInPlace(const CC &cc, CT &ct1, const CT &ct2);
+void TracedEvalSubInPlace(const CC &cc, CT &ct1, const CT &ct2);
+void TracedEvalMultInPlace(const CC &cc, CT &ct, double constant);
+void TracedEvalNegateInPlace(const CC &cc, CT &ct);
+
+CT TracedEvalSumRows(const CC &cc, const CT &ct, usint rowSize, const MatKeys &evalSumRowKeys);
+CT TracedEvalSumCols(const CC &cc, const CT &ct, usint rowSize, const MatKeys &evalSumColKeys);
+CT TracedEvalSum(const CC &cc, const CT &ct, usint batchSize);
+/* The sigmoid's coefficients come from the ChebyshevCache instead of being recomputed by EvalLogistic.
+ * ct holds the logits divided by logitScale; least-squares fits that qualify (UsesPowerSeries) are evaluated
+ * in the power basis, everything else with EvalChebyshevSeries over the range divided by logitScale.
+ */
+CT TracedEvalLogistic(const CC &cc, const CT &ct, double rangeStart, double rangeEnd, uint32_t degree,
+                      SigmoidApprox approx = SIGMOID_CHEBYSHEV, double logitScale = 1.0);
+CT TracedEvalChebyshevSeries(const CC &cc, const CT &ct, const std::vector<double> &coefficients,
+                             double rangeStart, double rangeEnd);
+CT TracedEvalBootstrap(const CC &cc, const CT &ct, uint32_t numIterations = 1, uint32_t precision = 0);
+CT TracedEncrypt(const CC &cc, const KeyPair &keys, const PT &pt);
+void TracedDecrypt(const CC &cc, const KeyPair &keys, const CT &ct, PT *pt);
+
+#endif //DPRIVE_ML__HE_TRACER_H_
@@ -0,0 +1,98 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "level_scheduler.h"
+#include "param_planner.h"
+
+LevelScheduler::LevelScheduler(uint32_t multDepth, uint32_t levelsAfterRefresh, const SigmoidSchedule &sigmoidSchedule,
+                               uint32_t intermediateDegree, uint32_t margin, bool powerSeries)
+    : multDepth(multDepth), levelsAfterRefresh(levelsAfterRefresh), sigmoidSchedule(sigmoidSchedule),
+      intermediateDegree(intermediateDegree), margin(margin), powerSeries(powerSeries) {
+  if (Required(intermediateDegree) > levelsAfterRefresh ||
+      Required(this->sigmoidSchedule.MaxDegree()) > levelsAfterRefresh) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: a single iteration does not fit into the levels available after a refresh"));
+  }
+}
+
+uint32_t LevelScheduler::Required(uint32_t degree) const {
+  return NagIterationDepth(degree, powerSeries) + margin;
+}
+
+uint32_t LevelScheduler::IntermediateDegree(usint iteration) const {
+  return std::min(intermediateDegree, sigmoidSchedule.At(iteration).degree);
+}
+
+uint32_t LevelScheduler::RemainingLevels(const CT &ct) const {
+  size_t consumed = ct->GetLevel() + ct->GetNoiseScaleDeg() - 1;
+  return (consumed >= multDepth) ? 0 : multDepth - consumed;
+}
+
+bool LevelScheduler::NeedsRefresh(const CT &ctWeights, usint iteration, uint32_t minLevels) const {
+  uint32_t fullDegree = sigmoidSchedule.At(iteration).degree;
+  uint32_t required = std::min(Required(IntermediateDegree(iteration)), Required(fullDegree));
+  return RemainingLevels(ctWeights) < std::max(required, minLevels);
+}
+
+IterationSchedule LevelScheduler::Next(const CT &ctWeights, usint iteration, usint numIters, uint32_t minLevels) {
+  IterationSchedule schedule{};
+  const SigmoidStage &stage = sigmoidSchedule.At(iteration);
+  uint32_t fullDegree = stage.degree;
+  uint32_t intermediateDegree = IntermediateDegree(iteration);
+  uint32_t remaining = RemainingLevels(ctWeights);
+  uint32_t cheapest = std::min(Required(intermediateDegree), Required(fullDegree));
+  schedule.chebRangeStart = stage.rangeStart;
+  schedule.chebRangeEnd = stage.rangeEnd;
+
+  if (NeedsRefresh(ctWeights, iteration, minLevels)) {
+    schedule.refresh = true;
+    numRefreshes++;
+    remaining = levelsAfterRefresh;
+  }
+  schedule.levelsBefore = remaining;
+
+  bool lastIteration = (iteration + 1 == numIters);
+  bool roomForAnother = (remaining >= Required(intermediateDegree) + cheapest);
+  if (remaining >= Required(fullDegree) && (lastIteration || !roomForAnother)) {
+    // this iteration closes the refresh cycle: use the accurate sigmoid
+    schedule.chebDegree = fullDegree;
+  } else {
+    schedule.chebDegree = intermediateDegree;
+  }
+  return schedule;
+}
+
+void LevelScheduler::Report(std::ostream &os, usint numIters) const {
+  os << "Refreshes: " << numRefreshes << " for " << numIters << " iterations ("
+     << ((numRefreshes > 0) ? double(numIters) / numRefreshes : double(numIters)) << " iterations per refresh)"
+     << std::endl;
+}
@@ -0,0 +1,92 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__LEVEL_SCHEDULER_H_
+#define DPRIVE_ML__LEVEL_SCHEDULER_H_
+
+#include "openfhe.h"
+#include "lr_types.h"
+#include "sigmoid_schedule.h"
+
+////////// Level-aware scheduling of refreshes (bootstrap or re-encryption) ///////////////////////////////
+
+struct IterationSchedule {
+  bool refresh;          // bootstrap (or re-encrypt) ctWeights before this iteration
+  uint32_t chebDegree;   // Chebyshev degree of the sigmoid for this iteration
+  int chebRangeStart;    // and its interval
+  int chebRangeEnd;
+  uint32_t levelsBefore; // levels left in ctWeights at the start of the iteration (after any refresh)
+};
+
+/* Tracks the levels remaining in ctWeights and runs as many NAG iterations as fit between refreshes.
+ * Within a refresh cycle every iteration but the last uses intermediateDegree; the last one (and the
+ * final iteration of the run, whenever it fits) uses the full degree. The full degree and the interval come
+ * from the sigmoid schedule's stage for the iteration, and intermediateDegree is capped at the stage's
+ * degree, so cheap early stages also fit more iterations into a refresh cycle. With powerSeries, the sigmoids
+ * are charged at the depth of the power-basis evaluation (UsesPowerSeries).
+ */
+class LevelScheduler {
+ public:
+  LevelScheduler(uint32_t multDepth, uint32_t levelsAfterRefresh, const SigmoidSchedule &sigmoidSchedule,
+                 uint32_t intermediateDegree, uint32_t margin = 0, bool powerSeries = false);
+
+  // Levels ctWeights can still consume, counting a pending rescale as consumed
+  uint32_t RemainingLevels(const CT &ct) const;
+
+  // Level of ctWeights right after a refresh, as assumed by the schedule
+  uint32_t RefreshLevel() const { return multDepth - levelsAfterRefresh; }
+
+  /* True if the call to Next() on ctWeights for this iteration will ask for a refresh. With minLevels, it
+   * also refreshes if fewer levels are left, e.g. for an encrypted loss that cannot wait for a later iteration.
+   */
+  bool NeedsRefresh(const CT &ctWeights, usint iteration, uint32_t minLevels = 0) const;
+
+  // Decides the refresh and sigmoid degree for the iteration about to run on ctWeights
+  IterationSchedule Next(const CT &ctWeights, usint iteration, usint numIters, uint32_t minLevels = 0);
+
+  usint NumRefreshes() const { return numRefreshes; }
+
+  void Report(std::ostream &os, usint numIters) const;
+
+ private:
+  uint32_t Required(uint32_t degree) const;
+  uint32_t IntermediateDegree(usint iteration) const;
+
+  uint32_t multDepth;
+  uint32_t levelsAfterRefresh;
+  SigmoidSchedule sigmoidSchedule;
+  uint32_t intermediateDegree;
+  uint32_t margin;
+  bool powerSeries;
+  usint numRefreshes = 0;
+};
+
+#endif //DPRIVE_ML__LEVEL_SCHEDULER_H_
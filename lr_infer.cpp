@@ -0,0 +1,372 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/* Batch inference with trained logistic regression weights on encrypted features.
+ * Features are encrypted (or loaded, already encrypted) in MAT_ROW_MAJOR ciphertexts, each one scored
+ * with MatrixVectorProductRow + EvalLogistic on a thread pool. Weights come either from a weights CSV
+ * written by lr_nag (plaintext) or from an encrypted model directory written by lr_nag -M.
+ */
+
+#include "openfhe.h"
+#include <getopt.h>
+#include <omp.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include "cheb_cache.h"
+#include "data_io.h"
+#include "enc_matrix.h"
+#include "he_tracer.h"
+#include "lr_train_funcs.h"
+#include "lr_types.h"
+#include "model_io.h"
+#include "param_planner.h"
+#include "shard_engine.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+/////////////////////////////////////////////////////////
+// Global Values
+/////////////////////////////////////////////////////////
+std::string SCORES_OUT_DEF = "../results/infer_scores.csv";
+std::string CHEB_TABLE_DEF = "../results/chebyshev_table.txt";
+uint32_t RING_DIM_DEF(1 << 16);
+int ROWS_TO_READ_DEF(-1);
+// Must match the range the model was trained with (see lr_nag.cpp)
+int CHEBYSHEV_RANGE_ESTIMATION_START = -16;
+int CHEBYSHEV_RANGE_ESTIMATION_END = 16;
+int CHEBYSHEV_ESTIMATION_DEGREE = 59;
+
+// Context for scoring with plaintext weights: one EvalMult, the EvalSumCols mask and EvalLogistic
+static CC MakeInferenceContext(uint32_t ringDim, uint32_t chebDegree) {
+#if NATIVEINT == 128
+  uint32_t firstModSize = 89;
+  uint32_t dcrtBits = 78;
+#else
+  uint32_t firstModSize = 60;
+  uint32_t dcrtBits = 59;
+#endif
+  CryptoParams parameters;
+  parameters.SetMultiplicativeDepth(MatVecRowStage::levels + ChebyshevDepth(chebDegree));
+  parameters.SetScalingModSize(dcrtBits);
+  parameters.SetFirstModSize(firstModSize);
+  parameters.SetBatchSize(ringDim / 2);
+  parameters.SetRingDim(ringDim);
+  parameters.SetSecurityLevel(lbcrypto::HEStd_128_classic);
+  parameters.SetScalingTechnique(lbcrypto::FIXEDAUTO);
+  parameters.SetKeySwitchTechnique(lbcrypto::HYBRID);
+
+  CC cc = GenCryptoContext(parameters);
+  cc->Enable(lbcrypto::PKE);
+  cc->Enable(lbcrypto::LEVELEDSHE);
+  cc->Enable(lbcrypto::ADVANCEDSHE);
+  return cc;
+}
+
+static double SecondsSince(const std::chrono::high_resolution_clock::time_point &start) {
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  std::string modelDir;
+  std::string weightsFile;
+  std::string featuresFile;
+  std::string encFeaturesIn;
+  std::string encFeaturesOut;
+  std::string scoresOut = SCORES_OUT_DEF;
+  std::string encScoresOut;
+  int rowsToRead = ROWS_TO_READ_DEF;
+  uint32_t ringDim = RING_DIM_DEF;
+  uint32_t chebDegree = CHEBYSHEV_ESTIMATION_DEGREE;
+  usint numWorkers = 0;
+  std::string chebTableFile = CHEB_TABLE_DEF;
+  SigmoidApprox sigmoidApprox = SIGMOID_CHEBYSHEV;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "m:w:x:E:X:o:c:r:d:g:q:W:C:h")) != -1) {
+    switch (opt) {
+      case 'm':modelDir = optarg;
+        break;
+      case 'w':weightsFile = optarg;
+        break;
+      case 'x':featuresFile = optarg;
+        break;
+      case 'E':encFeaturesIn = optarg;
+        break;
+      case 'X':encFeaturesOut = optarg;
+        break;
+      case 'o':scoresOut = optarg;
+        break;
+      case 'c':encScoresOut = optarg;
+        break;
+      case 'r':rowsToRead = atoi(optarg);
+        break;
+      case 'd':ringDim = atoi(optarg);
+        break;
+      case 'g':chebDegree = atoi(optarg);
+        break;
+      case 'q':chebDegree = atoi(optarg);
+        sigmoidApprox = SIGMOID_LEAST_SQUARES;
+        break;
+      case 'W':numWorkers = atoi(optarg);
+        break;
+      case 'C':chebTableFile = optarg;
+        break;
+      case 'h':
+      default:
+        std::cerr << "Usage: " << std::endl
+                  << "arguments:" << std::endl
+                  << "  -m <encrypted model directory written by lr_nag -M>" << std::endl
+                  << "  -w <weights CSV written by lr_nag; the last row is used, overrides the model's theta>"
+                  << std::endl
+                  << "  -x <features CSV to encrypt and score>" << std::endl
+                  << "  -E <encrypted features written by an earlier run with -X; needs -m>" << std::endl
+                  << "  -X <file to save the encrypted features to; needs -m>" << std::endl
+                  << "  -o <decrypted scores CSV, empty to skip> [" << SCORES_OUT_DEF << "]" << std::endl
+                  << "  -c <file to save the encrypted scores to>" << std::endl
+                  << "  -r <number of rows to read> [" << ROWS_TO_READ_DEF << "]" << std::endl
+                  << "  -d <ring dimension without -m> [" << RING_DIM_DEF << "]" << std::endl
+                  << "  -g <Chebyshev degree of the sigmoid> [" << CHEBYSHEV_ESTIMATION_DEGREE << "]" << std::endl
+                  << "  -q <degree of the least-squares sigmoid the model was trained with (lr_nag -q)>" << std::endl
+                  << "  -W <ciphertexts scored concurrently, 0 = one per core> [0]" << std::endl
+                  << "  -C <Chebyshev coefficient table shared with lr_nag> [" << CHEB_TABLE_DEF << "]" << std::endl
+                  << "  -h prints this message" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+  }
+  if (weightsFile.empty() && modelDir.empty()) {
+    std::cerr << "Either a weights CSV (-w) or an encrypted model (-m) is required." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (featuresFile.empty() == encFeaturesIn.empty()) {
+    std::cerr << "Give exactly one of a features CSV (-x) and encrypted features (-E)." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (!encFeaturesIn.empty() && modelDir.empty()) {
+    std::cerr << "Encrypted features (-E) can only be scored under the keys of a model (-m)." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (!encFeaturesOut.empty() && modelDir.empty()) {
+    // without a model the features are encrypted under keys that are gone once this run ends
+    std::cerr << "Encrypted features (-X) can only be saved under the keys of a model (-m)." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // the same sigmoid polynomial the model was trained with
+  if (!chebTableFile.empty()) ChebyshevCache::Get().UseTable(chebTableFile);
+  SigmoidPolynomial modelSigmoid;
+  if (!modelDir.empty() && LoadSigmoidPolynomial(modelDir, modelSigmoid)) {
+    // the model's own copy wins over -g/-q and the table: a fit towards its training set is nowhere else
+    sigmoidApprox = modelSigmoid.approx;
+    chebDegree = modelSigmoid.degree;
+    CHEBYSHEV_RANGE_ESTIMATION_START = int(modelSigmoid.rangeStart);
+    CHEBYSHEV_RANGE_ESTIMATION_END = int(modelSigmoid.rangeEnd);
+    ChebyshevCache::Get().Store(SigmoidCacheName(sigmoidApprox), CHEBYSHEV_RANGE_ESTIMATION_START,
+                                CHEBYSHEV_RANGE_ESTIMATION_END, chebDegree, modelSigmoid.coefficients, false);
+    std::cout << "Using the model's " << SigmoidCacheName(sigmoidApprox) << " polynomial of degree " << chebDegree
+              << std::endl;
+  }
+  ChebyshevCache::Get().Coefficients(SigmoidCacheName(sigmoidApprox), CHEBYSHEV_RANGE_ESTIMATION_START,
+                                     CHEBYSHEV_RANGE_ESTIMATION_END, chebDegree);
+
+  /////////////////////////////////////////////////////////////////
+  // Context, keys and weights
+  /////////////////////////////////////////////////////////////////
+  Mat features;
+  if (!featuresFile.empty()) {
+    CsvRowReader reader(featuresFile, rowsToRead);
+    Vec row;
+    while (reader.Next(row)) features.push_back(row);
+    if (features.empty()) {
+      std::cerr << "No rows read from " << featuresFile << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  CC cc;
+  KeyPair keys;
+  CT ctTheta;
+  usint rowSize = 0;
+  if (!modelDir.empty()) {
+    std::cout << "Loading encrypted model from " << modelDir << std::endl;
+    auto model = LoadEncryptedModel(modelDir);
+    cc = model.cc;
+    keys = model.keys;
+    ctTheta = model.ctTheta;
+    rowSize = model.rowSize;
+  } else {
+    cc = MakeInferenceContext(ringDim, chebDegree);
+    keys = cc->KeyGen();
+  }
+
+  Mat weights;
+  if (!weightsFile.empty()) {
+    weights = LoadWeightsCsv(weightsFile);
+    if (rowSize == 0) rowSize = NextPow2(weights.size());
+  }
+  if (!features.empty() && features[0].size() > rowSize) {
+    std::cerr << "The features have " << features[0].size() << " columns but the model only " << rowSize
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::cout << "Generating keys" << std::endl;
+  cc->EvalMultKeyGen(keys.secretKey);
+  MatKeys evalSumColKeys = cc->EvalSumColsKeyGen(keys.secretKey);
+  usint numSlots = cc->GetEncodingParams()->GetBatchSize();
+
+  // encrypt the features at the level theta is at, so the product needs no level adjustment
+  uint32_t featureLevel = 0;
+  PT ptTheta;
+  if (!weights.empty()) {
+    Vec theta(rowSize, 0.0), thetaCloned;
+    for (usint i = 0; i < weights.size(); i++) theta[i] = weights[i][0];
+    GetVecRowCloned<double>(theta, numSlots, 0.0, thetaCloned);
+    ptTheta = cc->MakeCKKSPackedPlaintext(thetaCloned);
+  } else {
+    uint32_t multDepth = cc->GetElementParams()->GetParams().size() - 1;
+    uint32_t used = ctTheta->GetLevel() + ctTheta->GetNoiseScaleDeg() - 1;
+    uint32_t needed = MatVecRowStage::levels + ChebyshevDepth(chebDegree);
+    if (used + needed > multDepth) {
+      // the model holds the secret key already, so this is the same refresh interactive training uses
+      std::cout << "Encrypted theta has " << multDepth - std::min(used, multDepth) << " levels left, " << needed
+                << " needed: re-encrypting it" << std::endl;
+      ReEncrypt(cc, ctTheta, keys);
+    }
+    featureLevel = ctTheta->GetLevel();
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Encrypted features
+  /////////////////////////////////////////////////////////////////
+  usint totalThreads = omp_get_max_threads();
+  EncryptedFeatureSet featureSet;
+  double encryptSeconds = 0;
+  if (!encFeaturesIn.empty()) {
+    std::cout << "Loading encrypted features from " << encFeaturesIn << std::endl;
+    featureSet = LoadFeatureSet(encFeaturesIn);
+    if (featureSet.rowSize != rowSize) {
+      std::cerr << "Encrypted features are packed with row size " << featureSet.rowSize << ", the model uses "
+                << rowSize << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  } else {
+    featureSet.rowSize = rowSize;
+    featureSet.rowsPerCt = numSlots / rowSize;
+    featureSet.numRows = features.size();
+    featureSet.cts.resize((features.size() + featureSet.rowsPerCt - 1) / featureSet.rowsPerCt);
+
+    auto config = SplitThreads(featureSet.cts.size(), numWorkers, totalThreads);
+    ThreadPool pool(config.shardWorkers, config.innerThreads);
+    std::vector<std::future<void>> futures;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (usint i = 0; i < featureSet.cts.size(); i++) {
+      futures.push_back(pool.Submit([&, i]() {
+        usint first = i * featureSet.rowsPerCt;
+        usint last = std::min<usint>(features.size(), first + featureSet.rowsPerCt);
+        Mat chunk(features.begin() + first, features.begin() + last);
+        featureSet.cts[i] = Mat2CtMRM(cc, chunk, rowSize, numSlots, keys, featureLevel);
+      }));
+    }
+    WaitAll(futures);
+    encryptSeconds = SecondsSince(start);
+    Mat().swap(features);
+    if (!encFeaturesOut.empty()) {
+      SaveFeatureSet(encFeaturesOut, featureSet);
+      std::cout << "Saved encrypted features to " << encFeaturesOut << std::endl;
+    }
+  }
+
+  /////////////////////////////////////////////////////////////////
+  // Scoring
+  /////////////////////////////////////////////////////////////////
+  auto config = SplitThreads(featureSet.cts.size(), numWorkers, totalThreads);
+  std::cout << "Scoring " << featureSet.numRows << " rows in " << featureSet.cts.size() << " ciphertexts ("
+            << featureSet.rowsPerCt << " rows each) with " << config.shardWorkers << " workers x "
+            << config.innerThreads << " threads" << std::endl;
+
+  EncryptedFeatureSet scores{std::vector<CT>(featureSet.cts.size()), rowSize, featureSet.rowsPerCt,
+                             featureSet.numRows};
+  double scoreSeconds;
+  {
+    ThreadPool pool(config.shardWorkers, config.innerThreads);
+    std::vector<std::future<void>> futures;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (usint i = 0; i < featureSet.cts.size(); i++) {
+      futures.push_back(pool.Submit([&, i]() {
+        scores.cts[i] = (ptTheta)
+            ? EncLogRegPredict(cc, featureSet.cts[i], ptTheta, rowSize, evalSumColKeys,
+                               CHEBYSHEV_RANGE_ESTIMATION_START, CHEBYSHEV_RANGE_ESTIMATION_END, chebDegree,
+                               sigmoidApprox)
+            : EncLogRegPredict(cc, featureSet.cts[i], ctTheta, rowSize, evalSumColKeys,
+                               CHEBYSHEV_RANGE_ESTIMATION_START, CHEBYSHEV_RANGE_ESTIMATION_END, chebDegree,
+                               sigmoidApprox);
+      }));
+    }
+    WaitAll(futures);
+    scoreSeconds = SecondsSince(start);
+  }
+
+  if (!encScoresOut.empty()) {
+    // score i of a ciphertext sits in slot i * rowSize, so the feature set layout describes the scores too
+    SaveFeatureSet(encScoresOut, scores);
+    std::cout << "Saved encrypted scores to " << encScoresOut << std::endl;
+  }
+
+  double decryptSeconds = 0;
+  if (!scoresOut.empty()) {
+    Vec decrypted(scores.numRows, 0.0);
+    auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel for
+    for (usint i = 0; i < scores.cts.size(); i++) {
+      PT pt;
+      cc->Decrypt(keys.secretKey, scores.cts[i], &pt);
+      auto values = pt->GetRealPackedValue();
+      for (usint r = 0; r < scores.rowsPerCt && i * scores.rowsPerCt + r < scores.numRows; r++) {
+        decrypted[i * scores.rowsPerCt + r] = values[r * rowSize];
+      }
+    }
+    decryptSeconds = SecondsSince(start);
+
+    std::ofstream ofs(scoresOut);
+    for (usint r = 0; r < decrypted.size(); r++) {
+      ofs << r << ", " << decrypted[r] << std::endl;
+    }
+    std::cout << "Wrote scores to " << scoresOut << std::endl;
+  }
+
+  std::cout << "Inference summary" << std::endl;
+  if (encryptSeconds > 0) std::cout << "\tEncrypt features: " << encryptSeconds << " s" << std::endl;
+  std::cout << "\tScore: " << scoreSeconds << " s, " << featureSet.numRows / scoreSeconds << " predictions/s"
+            << std::endl;
+  if (decryptSeconds > 0) std::cout << "\tDecrypt scores: " << decryptSeconds << " s" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -44,6 +44,25 @@
 #include "lr_types.h"
 #include "utils.h"
 #include "parameters.h"
+#include "he_tracer.h"
+#include "param_planner.h"
+#include "bootstrap_tuner.h"
+#include "bootstrap_schedule.h"
+#include "packing_planner.h"
+#include "level_scheduler.h"
+#include "refresh_protocol.h"
+#include "shard_engine.h"
+#include "ct_store.h"
+#include "exec_config.h"
+#include "mem_stats.h"
+#include "model_io.h"
+#include "cheb_cache.h"
+#include "sigmoid_schedule.h"
+#include "nag_step.h"
+#include "pt_cache.h"
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 /////////////////////////////////////////////////////////
 // Global Values
@@ -71,7 +90,9 @@ bool HIGHPRECISION_CS(false);
 // https://github.com/openfheorg/openfhe-development/blob/main/src/pke/examples/FUNCTION_EVALUATION.md#how-to-choose-multiplicative-depth
 int CHEBYSHEV_RANGE_ESTIMATION_START = -16;
 int CHEBYSHEV_RANGE_ESTIMATION_END = 16;
-int CHEBYSHEV_ESTIMATION_DEGREE = 59;
+int CHEBYSHEV_ESTIMATION_DEGREE = DEFAULT_CHEBYSHEV_DEGREE;
+// softplus for the encrypted loss (-l), over the same range as the sigmoid
+int SOFTPLUS_ESTIMATION_DEGREE = DEFAULT_SOFTPLUS_DEGREE;
 bool DEBUG = true;
 int DEBUG_PLAINTEXT_LENGTH = 32;
 
@@ -130,6 +151,19 @@ int main(int argc, char *argv[]) {
                         RING_DIM_DEF, WRITE_EVERY, BOOTSTRAP_PRECISION_DEF, false, 
                         WITH_COMPOSITESCALING, WITH_DBPRECISION_CS, HIGHPRECISION_CS
   );
+  auto &tracer = HETracer::Get();
+  tracer.Enable(params.traceOps);
+
+  // Thread budget and placement come from -H, -J, -N, -B and -O (see exec_config.h). They are applied
+  // before any keys are allocated, so first-touch places them where the threads run.
+  auto execConfig = ExecConfig::FromOptions(params.execOptions);
+  execConfig.Apply();
+  execConfig.Report(std::cout);
+  execConfig.EnterPhase("setup");
+  auto enterPhase = [&](const std::string &phase) {
+    tracer.SetPhase(phase);
+    execConfig.EnterPhase(phase);
+  };
 
   /////////////////////////////////////////////////////////
   // Handle IO for writing
@@ -162,6 +196,17 @@ int main(int argc, char *argv[]) {
   }
   testOFS << "Test Losses" << std::endl;
 
+  std::ofstream encLossOFS;
+  if (params.encLossEvery > 0) {
+    encLossOFS.precision(params.outputPrecision);
+    encLossOFS.open(params.encLossOutFile, std::ofstream::out | std::ofstream::trunc);
+    if (!encLossOFS.is_open()) {
+      std::cerr << "Couldn't open file to write the encrypted loss to";
+      exit(EXIT_FAILURE);
+    }
+    encLossOFS << "Iteration, " << "Encrypted Train Losses" << std::endl;
+  }
+
 
   /////////////////////////////////////////////////////////
   // Crypto CryptoParams
@@ -180,7 +225,6 @@ int main(int argc, char *argv[]) {
   uint32_t firstModSize = 60;
   uint32_t dcrtBits = 59;
 #endif
-  uint32_t batchSize = params.ringDimension / 2;
   lbcrypto::ScalingTechnique rsTech = lbcrypto::FIXEDAUTO;
   lbcrypto::KeySwitchTechnique ksTech = lbcrypto::HYBRID;
 
@@ -205,27 +249,209 @@ int main(int argc, char *argv[]) {
     std::cout << "Ring Size: " << params.ringDimension << std::endl;
   }
 
+  // A least-squares sigmoid (-q) is fitted at a much lower degree than the interpolation, which shrinks
+  // every depth derived from CHEBYSHEV_ESTIMATION_DEGREE below
+  SigmoidApprox sigmoidApprox = SIGMOID_CHEBYSHEV;
+  if (params.lsqSigmoidDegree > 0) {
+    // a fit towards this training set's logits (-Q) is kept apart from the grid-only fits in the shared table
+    sigmoidApprox = params.sigmoidRefWeightsFile.empty() ? SIGMOID_LEAST_SQUARES : SIGMOID_LEAST_SQUARES_DATA;
+    CHEBYSHEV_ESTIMATION_DEGREE = params.lsqSigmoidDegree;
+    std::cout << "Using a degree " << CHEBYSHEV_ESTIMATION_DEGREE << " least-squares sigmoid" << std::endl;
+  }
+
+  // A configured sigmoid schedule ends with the most expensive sigmoid, which the depth is planned for
+  SigmoidSchedule sigmoidSchedule;
+  bool autoSigmoidSchedule = (params.sigmoidSchedule == "auto");
+  if (!params.sigmoidSchedule.empty() && !autoSigmoidSchedule) {
+    sigmoidSchedule = SigmoidSchedule::Parse(params.sigmoidSchedule);
+    CHEBYSHEV_ESTIMATION_DEGREE = sigmoidSchedule.MaxDegree();
+  }
+
+  // The secret key stays in the refresh server, so there is none to save the model with
+  if (!params.refreshSocket.empty() && !params.withBT && !params.modelDir.empty()) {
+    std::cerr << "-M cannot be combined with -s: the secret key stays in the refresh server" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // With a shard store the training set is never in memory, only one or two encrypted shards
+  bool streamShards = !params.ctStoreDir.empty();
+  if (streamShards) {
+    if (params.encLossEvery > 0 || autoSigmoidSchedule || !params.sigmoidRefWeightsFile.empty()) {
+      std::cerr << "-T cannot be combined with -l, -G auto or -Q, which need the whole training set" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    params.leanMemory = true;
+  }
+
   CryptoParams parameters;
-  std::vector<uint32_t> levelBudget;
-  std::vector<uint32_t> bsgsDim = {0, 0};
   uint32_t multDepth;
 
-  if (params.withBT) {
-    std::cout << "Using Bootstrapping" << std::endl;
-    // Params here set based on discussion in
-    // https://github.com/openfheorg/openfhe-development/blob/main/src/pke/examples/advanced-ckks-bootstrapping.cpp
-    lbcrypto::SecretKeyDist skDist = lbcrypto::UNIFORM_TERNARY;
-    // linear transform using 1 level is good for CKKS bootstrapping as the number of features is small (10)
-    levelBudget = {2, 2};
-    uint32_t levelsBeforeBootstrap = 14;
-    uint32_t approxBootstrapDepth = 8;
+  // Bootstrapping params here set based on discussion in
+  // https://github.com/openfheorg/openfhe-development/blob/main/src/pke/examples/advanced-ckks-bootstrapping.cpp
+  lbcrypto::SecretKeyDist skDist = lbcrypto::UNIFORM_TERNARY;
+  // linear transform using 1 level is good for CKKS bootstrapping as the number of features is small (10)
+  std::vector<uint32_t> levelBudget = {2, 2};
+  std::vector<uint32_t> bsgsDim = {0, 0};
+  uint32_t approxBootstrapDepth = 8;
+
+  // Several NAG iterations may share one bootstrap (or re-encryption); all but the last iteration of
+  // such a cycle may use a cheaper sigmoid
+  uint32_t intermediateDegree = (params.intermediateDegree > 0) ? params.intermediateDegree
+                                                                : CHEBYSHEV_ESTIMATION_DEGREE;
+  // A least-squares sigmoid over one symmetric range [-B, B] is evaluated in the power basis, on logits that come
+  // divided by B because X is encrypted divided by it (see UsesPowerSeries). Every degree a stage may use has to
+  // qualify, since the depth below is planned for one evaluator.
+  bool powerSeriesSigmoid = false;
+  double logitScale = 1.0;
+  if (sigmoidApprox != SIGMOID_CHEBYSHEV && !streamShards && !autoSigmoidSchedule) {
+    std::vector<SigmoidStage> stages = params.sigmoidSchedule.empty()
+        ? SigmoidSchedule::Fixed(CHEBYSHEV_ESTIMATION_DEGREE, CHEBYSHEV_RANGE_ESTIMATION_START,
+                                 CHEBYSHEV_RANGE_ESTIMATION_END).Stages()
+        : sigmoidSchedule.Stages();
+    double bound = stages.front().rangeEnd;
+    powerSeriesSigmoid = true;
+    for (auto &stage : stages) {
+      for (uint32_t degree : {stage.degree, std::min(stage.degree, intermediateDegree)}) {
+        powerSeriesSigmoid &= UsesPowerSeries(sigmoidApprox, stage.rangeStart, stage.rangeEnd, degree, bound);
+      }
+    }
+    if (powerSeriesSigmoid) logitScale = bound;
+  }
+  if (sigmoidApprox != SIGMOID_CHEBYSHEV) {
+    std::cout << "Evaluating the sigmoid "
+              << (powerSeriesSigmoid ? "in the power basis, X encrypted divided by " + std::to_string(int(logitScale))
+                                     : std::string("with EvalChebyshevSeries"))
+              << " (" << NagIterationLevels(CHEBYSHEV_ESTIMATION_DEGREE, powerSeriesSigmoid)
+              << " levels per iteration)" << std::endl;
+  }
 
+  // The levels a refresh has to leave, summed from the stage depths in depth_plan.h; the default configurations
+  // are checked there at compile time, degrees given on the command line are checked here
+  TrainingDepth trainingDepth = PlanTrainingDepth(TrainingVariant{
+      uint32_t(CHEBYSHEV_ESTIMATION_DEGREE), intermediateDegree, params.itersPerRefresh,
+      (params.encLossEvery > 0) ? uint32_t(SOFTPLUS_ESTIMATION_DEGREE) : 0, powerSeriesSigmoid});
+  if (!trainingDepth.supported) {
+    std::cerr << "Chebyshev degrees above 2031 are not supported" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::cout << "Levels per refresh: " << trainingDepth.requiredLevels << " (" << params.itersPerRefresh
+            << " iteration(s): " << trainingDepth.cycleLevels << ", encrypted loss: " << trainingDepth.lossLevels
+            << ")" << std::endl;
+  uint32_t levelsBeforeBootstrap = trainingDepth.requiredLevels + BOOTSTRAP_HEADROOM_LEVELS;
 #if NATIVEINT == 64
-    // Add an extra level based on empirical run results. We've encountered an error of
-    //"DCRTPolyImpl's towers are not initialized" and this addition solves that.
-    levelsBeforeBootstrap++;
+  levelsBeforeBootstrap += NATIVE64_BOOTSTRAP_LEVELS;
 #endif
 
+  usint shapeNumSamples;
+  usint shapeNumFeatures;
+  ReadDataShape(params.trainXFile, params.rowsToRead, shapeNumSamples, shapeNumFeatures);
+  // sparse bootstrapping slot count: 8 blocks of the (padded) features
+  uint32_t numSlotsBoot = NextPow2(shapeNumFeatures) * 8;
+
+  CKKSPlan plan{};
+  PlannerInput plannerInput;
+  if (params.autoPlan) {
+    plannerInput.chebDegree = CHEBYSHEV_ESTIMATION_DEGREE;
+    plannerInput.intermediateDegree = intermediateDegree;
+    plannerInput.itersPerRefresh = params.itersPerRefresh;
+    plannerInput.lossDegree = (params.encLossEvery > 0) ? SOFTPLUS_ESTIMATION_DEGREE : 0;
+    plannerInput.powerSeries = powerSeriesSigmoid;
+    // with sharding only one shard has to fit into a ciphertext
+    plannerInput.numSamples = (params.shardRows > 0) ? std::min(shapeNumSamples, params.shardRows) : shapeNumSamples;
+    plannerInput.numFeatures = shapeNumFeatures;
+    plannerInput.withBT = params.withBT;
+    plannerInput.levelBudget = levelBudget;
+    plannerInput.approxBootstrapDepth = approxBootstrapDepth;
+    plannerInput.skDist = skDist;
+    plannerInput.securityLevel = securityLevel;
+    plannerInput.dcrtBits = dcrtBits;
+    plannerInput.firstModSize = firstModSize;
+    plannerInput.minRingDim = params.ringDimFromCLI ? params.ringDimension : 0;
+    // the same bootstrapping headroom as the hand-set depth above, 64-bit level included (see depth_plan.h)
+    plannerInput.extraLevels = params.withBT ? levelsBeforeBootstrap - trainingDepth.requiredLevels : 0;
+    plan = PlanCKKSParameters(plannerInput);
+    PrintPlan(std::cout, plan);
+
+    params.ringDimension = plan.ringDim;
+    numLargeDigits = plan.numLargeDigits;
+    levelsBeforeBootstrap = plan.levelsBeforeBootstrap;
+  }
+
+  if (params.withBT) {
+    /////////////////////////////////////////////////////////
+    // Use the tuned bootstrapping configuration for this parameter set if there is one
+    /////////////////////////////////////////////////////////
+    BootstrapTuneKey tuneKey{params.ringDimension, dcrtBits, firstModSize, levelsBeforeBootstrap,
+                             NextPow2(shapeNumFeatures), securityLevel, rsTech, registerWordSize};
+    BootstrapConfig bootConfig{levelBudget, bsgsDim, approxBootstrapDepth, skDist, numSlotsBoot};
+    BootstrapTuneResult tuned;
+    bool haveTuned = false;
+    if (params.autotuneBT) {
+      tuned = AutotuneBootstrap(tuneKey, bootConfig, params.sparseSecretBT);
+      StoreTunedBootstrap(params.bootstrapCacheFile, tuneKey, tuned);
+      haveTuned = true;
+    } else if (LookupTunedBootstrap(params.bootstrapCacheFile, tuneKey, tuned)) {
+      // a sparse secret key is only used when asked for on this run too
+      if (IsSparseSecret(tuned.config.skDist) && !params.sparseSecretBT) {
+        std::cout << "NOTE: ignoring cached bootstrapping configuration " << tuneKey.Hash() << ", it uses a sparse "
+                  << "secret key (allow it with -Z)" << std::endl;
+      } else {
+        std::cout << "Using cached bootstrapping configuration " << tuneKey.Hash() << " from "
+                  << params.bootstrapCacheFile << std::endl;
+        haveTuned = true;
+      }
+    }
+    if (haveTuned && IsSparseSecret(tuned.config.skDist)) {
+      std::cout << "WARNING: bootstrapping with a sparse secret key (" << tuned.config.skDist << "), which is weaker "
+                << "than the HE-standard parameters assume" << std::endl;
+    }
+    if (haveTuned) {
+      levelBudget = tuned.config.levelBudget;
+      bsgsDim = tuned.config.bsgsDim;
+      approxBootstrapDepth = tuned.config.approxBootstrapDepth;
+      skDist = tuned.config.skDist;
+      numSlotsBoot = tuned.config.numSlotsBoot;
+
+      if (params.autoPlan && (levelBudget != plannerInput.levelBudget || skDist != plannerInput.skDist)) {
+        // the bootstrap depth changed, so the modulus (and possibly dnum) must be re-planned
+        plannerInput.levelBudget = levelBudget;
+        plannerInput.approxBootstrapDepth = approxBootstrapDepth;
+        plannerInput.skDist = skDist;
+        plannerInput.minRingDim = params.ringDimension;
+        plan = PlanCKKSParameters(plannerInput);
+        PrintPlan(std::cout, plan);
+        if (plan.ringDim != params.ringDimension) {
+          std::cout << "NOTE: re-planned ring dimension " << plan.ringDim << " differs from the one the "
+                    << "bootstrapping configuration was tuned at (" << params.ringDimension << ")" << std::endl;
+        }
+        params.ringDimension = plan.ringDim;
+        numLargeDigits = plan.numLargeDigits;
+      }
+    }
+  }
+  // Only as many slots as the data needs, so the EvalSum rotations and keys cover the data, not the whole ring
+  uint32_t batchSize = params.ringDimension / 2;
+  if (!params.fullBatch) {
+    OpCostModel opCosts;
+    if (!params.opCostFile.empty() && !opCosts.Calibrate(params.opCostFile)) {
+      std::cout << "NOTE: no operation timings in " << params.opCostFile << ", planning with relative costs"
+                << std::endl;
+    }
+    PackingInput packingInput{shapeNumSamples, shapeNumFeatures, params.ringDimension,
+                              uint32_t(CHEBYSHEV_ESTIMATION_DEGREE),
+                              params.withBT ? numSlotsBoot : 0, params.shardRows, params.shardWorkers,
+                              execConfig.ThreadsFor("gradient")};
+    auto packing = PlanPacking(packingInput, opCosts);
+    PrintPackingPlan(std::cout, packing);
+    batchSize = packing.batchSize;
+    if (packing.numShards > 1) {
+      if (params.shardRows == 0) params.shardRows = packing.rowsPerShard;
+      if (params.shardWorkers == 0) params.shardWorkers = packing.shardWorkers;
+    }
+  }
+
+  if (params.withBT) {
+    std::cout << "Using Bootstrapping" << std::endl;
     multDepth = levelsBeforeBootstrap + lbcrypto::FHECKKSRNS::GetBootstrapDepth(
         approxBootstrapDepth, levelBudget, skDist
     );
@@ -233,6 +459,9 @@ int main(int argc, char *argv[]) {
     std::cout << "*********************************************" << std::endl;
     std::cout << "Bootstrapping Crypto Params" << std::endl;
     std::cout << "\tDiscrete key used: " << skDist << std::endl;
+    std::cout << "\tLevel budget: {" << levelBudget[0] << ", " << levelBudget[1] << "}" << std::endl;
+    std::cout << "\tBSGS dims: {" << bsgsDim[0] << ", " << bsgsDim[1] << "}" << std::endl;
+    std::cout << "\tSparse slots: " << numSlotsBoot << std::endl;
     std::cout << "\tApprox Bootstrap depth: " << approxBootstrapDepth << std::endl;
     std::cout << "\tLevels before bootstrap: " << levelsBeforeBootstrap << std::endl;
 
@@ -242,20 +471,12 @@ int main(int argc, char *argv[]) {
     std::cout << "Using Interactive Methods" << std::endl;
     // Unpacking the two ciphertexts
 
-    // EncLogRegCalculateGradient consumes 12 levels:
-    // MatrixVectorProductRow takes 2 levels,
-    // EvalLogistic for deg = 128 takes 9 levels
-    // and then MatrixVectorProductCol takes 1 level
-
-    // then 2 more levels are used after logreg iteration
-
-    // Used to be 12 based on above, but in the case where we pack the
-    // weights nto a single ciphertext we need to do extra mults
-    // NOTE: Recreating the theta and phi from the single ciphertext
-    //      + 1 multiplication and 1 rotation
-    // NOTE: Joining theta and phi into a single ciphertext
-    //      + 1 multiplication and 1 addition
-    multDepth = 13;
+    // Re-encryption refreshes at the top level, so the depth is what a refresh cycle consumes (see
+    // NagIterationPipeline in depth_plan.h), or the encrypted loss if it goes deeper
+    multDepth = trainingDepth.requiredLevels;
+    if (params.autoPlan) {
+      multDepth = plan.multDepth;
+    }
   }
 
   /////////////////////////////////////////////////////////
@@ -286,12 +507,58 @@ int main(int argc, char *argv[]) {
     std::cout << "Error generating CKKS context... " << std::endl;
     exit(EXIT_FAILURE);
   }
-  std::cout << "Generating keys" << std::endl;
-  KeyPair keys = cc->KeyGen();
-  std::cout << "\tMult keys" << std::endl;
-  cc->EvalMultKeyGen(keys.secretKey);
-  std::cout << "\tEvalSum keys" << std::endl;
-  cc->EvalSumKeyGen(keys.secretKey);
+  // Interactive refreshes can go to a separate process that holds the secret key. It generates the key pair
+  // and sends back only the public and evaluation keys, so this process cannot decrypt anything itself.
+  RefreshClient refreshClient;
+  bool remoteRefresh = !params.withBT && !params.refreshSocket.empty();
+  KeyPair keys;
+  MatKeys evalSumRowKeys;
+  MatKeys evalSumColKeys;
+  if (remoteRefresh) {
+    std::cout << "Connecting to refresh server at " << params.refreshSocket << std::endl;
+    refreshClient.Connect(params.refreshSocket);
+    auto provisioned = refreshClient.Provision(cc, NextPow2(shapeNumFeatures));
+    keys = provisioned.keys;
+    evalSumRowKeys = provisioned.sumRowKeys;
+    evalSumColKeys = provisioned.sumColKeys;
+  } else {
+    std::cout << "Generating keys" << std::endl;
+    keys = cc->KeyGen();
+    std::cout << "\tMult keys" << std::endl;
+    cc->EvalMultKeyGen(keys.secretKey);
+    std::cout << "\tEvalSum keys" << std::endl;
+    cc->EvalSumKeyGen(keys.secretKey);
+  }
+  // With -s the plaintext values come from the refresh server, which is the only holder of the secret key
+  auto decryptValues = [&](const CT &ct, usint length) {
+    if (remoteRefresh) {
+      tracer.Count(OP_DECRYPT);
+      return refreshClient.Decrypt(ct, length);
+    }
+    PT pt;
+    TracedDecrypt(cc, keys, ct, &pt);
+    Vec values = pt->GetRealPackedValue();
+    values.resize(length);
+    return values;
+  };
+
+  // The sigmoid (and softplus) coefficients are computed once here, or read from the table, instead of
+  // being recomputed by every EvalLogistic call
+  auto &chebCache = ChebyshevCache::Get();
+  if (!params.chebTableFile.empty()) chebCache.UseTable(params.chebTableFile);
+  chebCache.Coefficients(SigmoidCacheName(sigmoidApprox), CHEBYSHEV_RANGE_ESTIMATION_START,
+                         CHEBYSHEV_RANGE_ESTIMATION_END, CHEBYSHEV_ESTIMATION_DEGREE);
+  chebCache.Coefficients(SigmoidCacheName(sigmoidApprox), CHEBYSHEV_RANGE_ESTIMATION_START,
+                         CHEBYSHEV_RANGE_ESTIMATION_END, intermediateDegree);
+  if (params.encLossEvery > 0) {
+    chebCache.Coefficients("softplus", CHEBYSHEV_RANGE_ESTIMATION_START, CHEBYSHEV_RANGE_ESTIMATION_END,
+                           SOFTPLUS_ESTIMATION_DEGREE);
+  }
+
+  MemoryLedger memory;
+  memory.Set("relinearization keys", EvalMultKeyBytes());
+  memory.Set("automorphism keys", AutomorphismKeyBytes());
+  memory.Report(std::cout, "key generation");
 
   usint numSlots = cc->GetEncodingParams()->GetBatchSize();
 
@@ -313,32 +580,136 @@ int main(int argc, char *argv[]) {
                ptExtractThetaMask, ptExtractPhiMask, LR_GAMMA
   );
 
-  usint originalNumSamp = X.size();     //n_samp
+  memory.Set("plaintext train", MatBytes(X) + MatBytes(NegXt) + MatBytes(y));
+  memory.Set("plaintext test", MatBytes(testX) + MatBytes(testY));
+  memory.Report(std::cout, "data load");
 
-  usint originalNumFeat = X[0].size();  //n_feat (including the intecept column
+  usint originalNumSamp = streamShards ? shapeNumSamples : X.size();     //n_samp
+
+  usint originalNumFeat = streamShards ? shapeNumFeatures : X[0].size();  //n_feat (including the intecept column
   auto dims = ComputePaddedDimensions(originalNumSamp, originalNumFeat, numSlots);
   usint rowSize = dims.second;
   int signedRowSize = (int) rowSize;
 
-  MatKeys evalSumRowKeys = cc->EvalSumRowsKeyGen(keys.secretKey, nullptr, rowSize);
-  MatKeys evalSumColKeys = cc->EvalSumColsKeyGen(keys.secretKey);
+  if (!remoteRefresh) {
+    evalSumRowKeys = cc->EvalSumRowsKeyGen(keys.secretKey, nullptr, rowSize);
+    evalSumColKeys = cc->EvalSumColsKeyGen(keys.secretKey);
+  }
   /////////////////////////////////////////////////////////////////
   //Encrypt Data
   /////////////////////////////////////////////////////////////////
 
-  CT ctWeights = collateOneDMats2CtVRC(cc, beta, beta, rowSize, numSlots, keys);
-  // returns negative X' matrix n_samp x n_features and initializes beta
-  auto ctNegXt = Mat2CtMRM(cc, NegXt, rowSize, numSlots, keys);
+  // Without -G every iteration uses the full degree and range
+  if (autoSigmoidSchedule) {
+    sigmoidSchedule = SigmoidSchedule::FromDataBound(X, LR_GAMMA, LR_ETA, params.numIters, CHEBYSHEV_ESTIMATION_DEGREE,
+                                                     CHEBYSHEV_RANGE_ESTIMATION_END);
+  } else if (params.sigmoidSchedule.empty()) {
+    sigmoidSchedule = SigmoidSchedule::Fixed(CHEBYSHEV_ESTIMATION_DEGREE, CHEBYSHEV_RANGE_ESTIMATION_START,
+                                             CHEBYSHEV_RANGE_ESTIMATION_END);
+  }
+  sigmoidSchedule.Print(std::cout);
+  if (sigmoidApprox == SIGMOID_LEAST_SQUARES_DATA) {
+    // Weight the fit towards the logits the reference weights produce on this training set, for every range and
+    // degree the schedule evaluates; the cache only keeps grid fits on disk, so these would otherwise be grid fits
+    Mat refWeights = LoadWeightsCsv(params.sigmoidRefWeightsFile);
+    Vec logitSamples;
+    for (auto &row : X) {
+      double z = 0;
+      for (size_t j = 0; j < std::min(row.size(), refWeights.size()); j++) z += row[j] * refWeights[j][0];
+      logitSamples.push_back(z);
+    }
+    for (auto &stage : sigmoidSchedule.Stages()) {
+      for (uint32_t degree : {stage.degree, std::min(stage.degree, intermediateDegree)}) {
+        chebCache.Store(SigmoidCacheName(sigmoidApprox), stage.rangeStart, stage.rangeEnd, degree,
+                        FitSigmoidLeastSquares(stage.rangeStart, stage.rangeEnd, degree, logitSamples), false);
+      }
+    }
+    std::cout << "Fitted the sigmoid to " << logitSamples.size() << " logits of " << params.sigmoidRefWeightsFile
+              << std::endl;
+  }
+  for (auto &stage : sigmoidSchedule.Stages()) {
+    chebCache.Coefficients(SigmoidCacheName(sigmoidApprox), stage.rangeStart, stage.rangeEnd, stage.degree);
+    chebCache.Coefficients(SigmoidCacheName(sigmoidApprox), stage.rangeStart, stage.rangeEnd,
+                           std::min(stage.degree, intermediateDegree));
+  }
 
+  /////////////////////////////////////////////////////////////////
+  // Refresh only when the levels left in ctWeights cannot fit the next iteration
+  /////////////////////////////////////////////////////////////////
+  uint32_t levelsAfterRefresh = (params.withBT) ? levelsBeforeBootstrap : multDepth;
+  uint32_t levelMargin = 0;
+#if NATIVEINT == 64
+  levelMargin = (params.withBT) ? 1 : 0;
+#endif
+  LevelScheduler scheduler(multDepth, levelsAfterRefresh, sigmoidSchedule, intermediateDegree, levelMargin,
+                           powerSeriesSigmoid);
+  // Single bootstraps until the weights settle, double ones (-e) after that
+  BootstrapPrecisionSchedule btSchedule(params.btPrecision, params.btSwitchFraction, params.btTolerance);
+
+  // The initial weights start at the level a refresh leaves them at, so every refresh cycle sees the same
+  // levels and the data can be encrypted with only the towers it is consumed with (by the cheapest sigmoid)
+  auto dataLevels = GradientDataLevels(scheduler.RefreshLevel(), sigmoidSchedule.MinDegree(), intermediateDegree,
+                                       powerSeriesSigmoid);
+  std::cout << "Encrypting at levels: weights " << scheduler.RefreshLevel() << ", X " << dataLevels.x
+            << ", -X' " << dataLevels.negXt << ", y " << dataLevels.labels << std::endl;
+  CT ctWeights = collateOneDMats2CtVRC(cc, beta, beta, rowSize, numSlots, keys, scheduler.RefreshLevel());
   ///note these functions WILL zero pad out the matricies
-  auto ctX = Mat2CtMRM(cc, X, rowSize, numSlots, keys); //verified ok
-  // using mcm because NegXt is -X being transposed by packing.
-  CT ctyVCC = OneDMat2CtVCC(cc, y, rowSize, numSlots, keys);
+  // X, -X' and y are split row-wise into shards of at most one ciphertext each
+  std::vector<DataShard> shards;
+  std::shared_ptr<ShardStream> shardStream;
+  size_t dataCtBytes = 0;
+  if (streamShards) {
+    auto storeIndex = BuildShardStore(params.ctStoreDir, cc, params.trainXFile, params.trainYFile, params.rowsToRead,
+                                      LR_GAMMA, rowSize, numSlots, params.shardRows, keys, dataLevels);
+    std::cout << "Wrote " << storeIndex.numRows.size() << " encrypted shard(s) to " << params.ctStoreDir << std::endl;
+    shardStream = std::make_shared<ShardStream>(params.ctStoreDir);
+    // the shard in use and the one being read ahead
+    dataCtBytes = std::min<size_t>(2, storeIndex.numRows.size()) * storeIndex.shardBytes;
+  } else {
+    shards = EncryptShards(cc, X, NegXt, y, rowSize, numSlots, params.shardRows, keys, dataLevels, logitScale);
+    for (auto &shard : shards) {
+      dataCtBytes += CiphertextBytes(shard.ctX) + CiphertextBytes(shard.ctNegXt) + CiphertextBytes(shard.ctLabels);
+    }
+  }
+  auto shardConfig = streamShards ? SplitThreads(1, 1, execConfig.ThreadsFor("gradient"))
+                                  : SplitThreads(shards.size(), params.shardWorkers, execConfig.ThreadsFor("gradient"));
+  shardConfig.workerCpus = execConfig.WorkerCpus(shardConfig.shardWorkers, shardConfig.innerThreads);
+  ShardedGradientEngine gradientEngine = streamShards
+      ? ShardedGradientEngine(cc, shardStream, rowSize, evalSumRowKeys, evalSumColKeys, keys, shardConfig)
+      : ShardedGradientEngine(cc, std::move(shards), rowSize, evalSumRowKeys, evalSumColKeys, keys, shardConfig);
+  gradientEngine.PrintConfig(std::cout);
+
+  // The masks are encoded again at every level the weights are unpacked/packed at, on first use
+  PlaintextCache weightMasks(cc);
+  AddNagWeightMasks(weightMasks, numSlots, rowSize);
+
+  memory.Set("automorphism keys", AutomorphismKeyBytes());
+  memory.Set("sum rows/cols keys", KeyMapBytes(evalSumRowKeys) + KeyMapBytes(evalSumColKeys));
+  memory.Set("data ciphertexts", dataCtBytes);
+  memory.Set("weights", CiphertextBytes(ctWeights));
+  memory.Report(std::cout, "encryption");
+
+  if (params.leanMemory) {
+    // Nothing reads the plaintext data past this point: the losses are computed by streaming the
+    // CSV files. Freeing it before the bootstrapping keys are generated lowers the peak RSS.
+    Mat().swap(X);
+    Mat().swap(NegXt);
+    Mat().swap(y);
+    Mat().swap(testX);
+    Mat().swap(testY);
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    memory.Set("plaintext train", 0);
+    memory.Set("plaintext test", 0);
+    memory.Report(std::cout, "freeing the plaintext data");
+  }
   /////////////////////////////////////////////////////////////////
   //Tracking and debugging
   /////////////////////////////////////////////////////////////////
   PT ptTheta; //plaintext for the resulting beta output
   CT ctGradient;
+  CT ctThetaFinal;
   double totalTime = 0;
   Vec final_b_vec;
   Mat final_b;
@@ -348,17 +719,33 @@ int main(int argc, char *argv[]) {
   // Optimization: set the number of slots for sparse bootstrap
   /////////////////////////////////////////////////////////////////
 
-  auto numFeaturesEnc = NextPow2(originalNumFeat);
-  auto numSlotsBoot = numFeaturesEnc * 8;
   if (params.withBT) {
     cc->Enable(lbcrypto::FHE);
     cc->EvalBootstrapSetup(levelBudget, bsgsDim, numSlotsBoot);
     cc->EvalBootstrapKeyGen(keys.secretKey, numSlotsBoot);
+    memory.Set("automorphism keys", AutomorphismKeyBytes());
+    memory.Report(std::cout, "bootstrapping key generation");
   }
 
+  // ctWeights repeats theta/phi with this period, so the server only needs to decode one period
+  usint refreshPeriod = 2 * rowSize;
+  // keep two levels' worth of towers on the wire: enough modulus above the scaling factor to decrypt
+  uint32_t refreshTowers = 2 * std::max<uint32_t>(1, ctWeights->GetElements()[0].GetNumOfElements() / (multDepth + 1));
+
   /////////////////////////////////////////////////////////////////
   // Logistic regression training loop on encrypted data
   auto mode = (params.withBT) ? "Bootstrap " : "Interactive ";
+  // with the encrypted loss, nothing but the loss scalar is decrypted during training
+  bool monitor = DEBUG && params.encLossEvery == 0;
+  bool encLossPending = false;
+  // the loss of the last iteration has no later one to wait for, so its weights are refreshed if it would not fit
+  auto minLevelsFor = [&](usint iteration) {
+    return (params.encLossEvery > 0 && iteration + 1 == params.numIters)
+        ? LogitsPipeline::levels + EncryptedLossLevels(SOFTPLUS_ESTIMATION_DEGREE) : 0;
+  };
+  // the sigmoid of the last iteration, which the saved model is scored with
+  IterationSchedule lastSchedule{false, uint32_t(CHEBYSHEV_ESTIMATION_DEGREE), CHEBYSHEV_RANGE_ESTIMATION_START,
+                                 CHEBYSHEV_RANGE_ESTIMATION_END, 0};
   std::cout << std::endl;
   for (usint epochI = 0; epochI < params.numIters; epochI++) {
     TIC(t);
@@ -366,55 +753,55 @@ int main(int argc, char *argv[]) {
               << " ******************************************************************"
               << std::endl;
     auto epochInferenceStart = std::chrono::high_resolution_clock::now();
-    if ((params.withBT) && epochI > 0) {
+    enterPhase("refresh");
+    auto schedule = scheduler.Next(ctWeights, epochI, params.numIters, minLevelsFor(epochI));
+    lastSchedule = schedule;
+    if (!schedule.refresh) {
+      OPENFHE_DEBUGEXP(ReturnDepth(ctWeights));
+    } else if (params.withBT) {
       ctWeights->SetSlots(numSlotsBoot);
 #if NATIVEINT == 128
-      ctWeights = cc->EvalBootstrap(ctWeights);
+      ctWeights = TracedEvalBootstrap(cc, ctWeights);
 #else
       // If we are in the 64-bit case, we may want to run bootstrapping twice
       //    As this will increase our precision, which will make our results
-      //    more in-line with the 128-bit version
-      if (params.btPrecision > 0){
+      //    more in-line with the 128-bit version. It is only needed near convergence.
+      uint32_t btIterations = btSchedule.Iterations(epochI, params.numIters);
+      TimeVar tBoot;
+      TIC(tBoot);
+      if (btIterations > 1) {
         std::cout << "Running double-bootstrapping at: " << params.btPrecision << " precision" << std::endl;
-        ctWeights = cc->EvalBootstrap(ctWeights, 2, params.btPrecision);
+        ctWeights = TracedEvalBootstrap(cc, ctWeights, 2, params.btPrecision);
       } else {
-        ctWeights = cc->EvalBootstrap(ctWeights);
+        ctWeights = TracedEvalBootstrap(cc, ctWeights);
       }
+      btSchedule.Record(btIterations, TOC(tBoot));
 #endif
       OPENFHE_DEBUGEXP(ctWeights->GetLevel());
+    } else if (remoteRefresh) {
+      // normally started at the end of the previous iteration and overlapped with the monitoring
+      ctWeights = refreshClient.Pending() ? refreshClient.Finish()
+                                          : refreshClient.Refresh(cc, ctWeights, refreshPeriod, refreshTowers);
     } else {
       OPENFHE_DEBUGEXP(ReturnDepth(ctWeights));
       ReEncrypt(cc, ctWeights, keys);
       OPENFHE_DEBUGEXP(ReturnDepth(ctWeights));
     }
+    tracer.RecordStage("weights", ctWeights);
+    std::cout << "\t" << (schedule.refresh ? "Refreshed" : "No refresh") << ", " << schedule.levelsBefore
+              << " levels left, sigmoid degree " << schedule.chebDegree << " over [" << schedule.chebRangeStart
+              << ", " << schedule.chebRangeEnd << "]" << std::endl;
 
     /////////////////////////////////////////////////////////////////
     // Extract the weights
     //  1) mask out the phi to get just Theta
     //  2) mask
     /////////////////////////////////////////////////////////////////
-    CT _ctTheta = cc->EvalMult(ctWeights, ptExtractThetaMask);
-    // _ctTheta
-    //      - numFeaturesEnc of 0s, numFeaturesEnc of thetas repeating to fill in the entire CT
-    // | 0, 0, ..., 0, theta_0, theta_1, ..., theta_15, 0,| (repeated)
-    CT ctTheta = cc->EvalAdd(
-        cc->EvalRotate(_ctTheta, signedRowSize),  // | 0, theta, 0, theta ...|
-        _ctTheta);
-    // ctTheta
-    // | theta_0, theta_1, ..., theta_15, theta_0, theta_1, ..., theta_15|
+    enterPhase("unpack");
+    auto nagWeights = UnpackNagWeights(cc, ctWeights, weightMasks, signedRowSize);
+    CT ctTheta = nagWeights.theta;
     OPENFHE_DEBUGEXP(ctTheta);
 
-    CT _ctPhi = cc->EvalMult(ctWeights, ptExtractPhiMask); // | 0, phi, 0, phi, ...|
-    // _ctPhi
-    //      - numFeaturesEnc of phis, numFeaturesEnc of 0s repeating to fill in the entire CT
-    // | phi_0, phi_1, ..., phi_15, 0, 0, ..., 0|
-    CT ctPhi = cc->EvalAdd(
-        cc->EvalRotate(_ctPhi, -signedRowSize),
-        _ctPhi
-    );
-    // ctPhi
-    // | phi_0, phi_1, ..., phi_15, phi_0, phi_1, ..., phi_15|
-
 #ifdef ENABLE_DEBUG
     OPENFHE_DEBUG("Decrypting the ciphertexts to inspect the values");
     PT ptThetaDBG;
@@ -439,50 +826,84 @@ int main(int argc, char *argv[]) {
     // and https://jlmelville.github.io/mize/nesterov.html
     /////////////////////////////////////////////////////////////////
 
-    EncLogRegCalculateGradient(cc, ctX, ctNegXt, ctyVCC, ctTheta, ctGradient,
-                               rowSize, evalSumRowKeys, evalSumColKeys, keys,
-                               false,
-                               CHEBYSHEV_RANGE_ESTIMATION_START,
-                               CHEBYSHEV_RANGE_ESTIMATION_END,
-                               CHEBYSHEV_ESTIMATION_DEGREE,
-                               DEBUG_PLAINTEXT_LENGTH
+    enterPhase("gradient");
+    bool encLossDue = params.encLossEvery > 0 &&
+        (encLossPending || epochI % params.encLossEvery == 0 || epochI + 1 == params.numIters);
+    gradientEngine.CalculateGradient(ctTheta, ctGradient,
+                                     schedule.chebRangeStart,
+                                     schedule.chebRangeEnd,
+                                     schedule.chebDegree,
+                                     encLossDue,
+                                     sigmoidApprox
     );
+    if (streamShards) {
+      std::cout << "\tStreamed shard gradients: " << gradientEngine.LastShardMs() << " ms, waiting for reads: "
+                << gradientEngine.LastStreamWaitMs() << " ms" << std::endl;
+    } else if (gradientEngine.NumShards() > 1) {
+      std::cout << "\tShard gradients: " << gradientEngine.LastShardMs() << " ms, reduction: "
+                << gradientEngine.LastReduceMs() << " ms" << std::endl;
+    }
 #ifdef ENABLE_DEBUG
     PT ptGrad;
     cc->Decrypt(keys.secretKey, ctGradient, &ptGrad);
     std::cout << "\tGradient: " << ptGrad << std::endl;
 #endif
+    if (encLossDue) {
+      // Loss of the weights this iteration started from, from the logits the gradient just computed.
+      // Later iterations of a refresh cycle may leave the logits too deep for the softplus; the loss
+      // then waits for the next iteration.
+      enterPhase("loss");
+      uint32_t lossDepth = EncryptedLossLevels(SOFTPLUS_ESTIMATION_DEGREE);
+      if (scheduler.RemainingLevels(gradientEngine.Logits(0)) >= lossDepth) {
+        CT ctLoss = gradientEngine.CalculateLoss(originalNumSamp,
+                                                 CHEBYSHEV_RANGE_ESTIMATION_START,
+                                                 CHEBYSHEV_RANGE_ESTIMATION_END,
+                                                 SOFTPLUS_ESTIMATION_DEGREE);
+        double encLoss = decryptValues(ctLoss, 1)[0];
+        std::cout << "\tEncrypted loss: " << encLoss << std::endl;
+        encLossOFS << epochI << ", " << encLoss << std::endl;
+        btSchedule.ObserveLoss(epochI, encLoss);
+        encLossPending = false;
+      } else if (epochI + 1 == params.numIters) {
+        std::cout << "\tEncrypted loss skipped: " << lossDepth << " levels needed after the logits" << std::endl;
+      } else {
+        std::cout << "\tEncrypted loss deferred: " << lossDepth << " levels needed after the logits" << std::endl;
+        encLossPending = true;
+      }
+    }
     OPENFHE_DEBUG("Applying gradient");
     /////////////////////////////////////////////////////////////////
     //Note: Formulation of NAG update based on
     // and https://jlmelville.github.io/mize/nesterov.html
     /////////////////////////////////////////////////////////////////
 
-    auto ctPhiPrime = cc->EvalSub(
-        ctTheta,
-        ctGradient
-    );
+    enterPhase("nag_update");
+    nagWeights = NagUpdate(cc, NagWeights{ctTheta, nagWeights.phi}, ctGradient, LR_ETA, epochI == 0);
+    ctTheta = nagWeights.theta;
+    ctThetaFinal = ctTheta;
+    tracer.RecordStage("theta_updated", ctTheta);
 
-    if (epochI == 0) {
-      ctTheta = ctPhiPrime;
-    } else {
-      ctTheta = cc->EvalAdd(
-          ctPhiPrime,
-          cc->EvalMult(
-              LR_ETA,
-              cc->EvalSub(ctPhiPrime, ctPhi)
-          )
-      );
+    /////////////////////////////////////////////////////////////////
+    // Packing the two ciphertexts back
+    /////////////////////////////////////////////////////////////////
+    OPENFHE_DEBUG("Repacking the ciphertexts");
+    enterPhase("repack");
+    ctWeights = PackNagWeights(cc, nagWeights, weightMasks);
+    tracer.RecordStage("weights_packed", ctWeights);
+
+    // With -s the weights are decrypted over the same connection, so before the next refresh is sent
+    if (monitor) {
+      enterPhase("monitor");
+      final_b_vec = decryptValues(ctTheta, originalNumFeat);
     }
-    // Step 11
-    ctPhi = ctPhiPrime;
-    if (DEBUG) {
-      cc->Decrypt(keys.secretKey, ctTheta, &ptTheta);
-
-      final_b_vec = ptTheta->GetRealPackedValue();
 
-      final_b_vec.resize(originalNumFeat);
+    // Start the next refresh now so its round trip overlaps with the monitoring below
+    if (remoteRefresh && epochI + 1 < params.numIters &&
+        scheduler.NeedsRefresh(ctWeights, epochI + 1, minLevelsFor(epochI + 1))) {
+      refreshClient.Begin(cc, ctWeights, refreshPeriod, refreshTowers);
+    }
 
+    if (monitor) {
       final_b = Mat(originalNumFeat, Vec(1, 0.0));
       //copy values into final_b matrix
       std::cout << "\tNew weights: ";
@@ -492,7 +913,9 @@ int main(int argc, char *argv[]) {
       }
       std::cout << std::endl;
 
-      auto loss = ComputeLoss(final_b, X, y);
+      auto loss = (params.leanMemory)
+                  ? ComputeLossStreamed(final_b, params.trainXFile, params.trainYFile, params.rowsToRead)
+                  : ComputeLoss(final_b, X, y);
       /////////////////////////////////////////////////////////////////
       //Saving and logging information
       /////////////////////////////////////////////////////////////////
@@ -504,6 +927,7 @@ int main(int argc, char *argv[]) {
                 << epochTime / 1000.0 << " s" << std::endl;
       OPENFHE_DEBUG(loss);
       ofsloss << epochTime << ", " << loss << std::endl;
+      btSchedule.ObserveLoss(epochI, loss);
 
       if (epochI % WRITE_EVERY == 0 && epochI > 0) {
         std::cout << "\t Writing weights and test loss to files: " << "(" <<
@@ -522,19 +946,19 @@ int main(int argc, char *argv[]) {
         // Writing the Test Loss
         /////////////////////////////////////////////////////////////////
         OPENFHE_DEBUG("Writing test loss to: " + params.testLossOutFile);
-        auto testLoss = ComputeLoss(final_b, testX, testY);
+        auto testLoss = (params.leanMemory)
+                        ? ComputeLossStreamed(final_b, params.testXFile, params.testYFile, params.rowsToRead)
+                        : ComputeLoss(final_b, testX, testY);
         std::cout << "\tTest Loss: " << testLoss << std::endl;
         testOFS << epochI << ", " << testLoss << std::endl;
       }
+    } else {
+      totalTime += TOC(t);
     }
-
-    /////////////////////////////////////////////////////////////////
-    // Packing the two ciphertexts back
-    /////////////////////////////////////////////////////////////////
-    OPENFHE_DEBUG("Repacking the ciphertexts");
-    ctTheta = cc->EvalMult(ctTheta, ptExtractThetaMask);  // | theta, 0, theta, 0|
-    ctPhi = cc->EvalMult(ctPhi, ptExtractPhiMask);  //| 0, phi, 0, phi|
-    ctWeights = cc->EvalAdd(ctTheta, ctPhi);
+    tracer.ReportIteration(std::cout, epochI, multDepth);
+    memory.Set("weights", CiphertextBytes(ctWeights));
+    memory.Set("plaintext operands", weightMasks.Bytes());
+    memory.ReportLine(std::cout);
 
     auto epochInferenceEnd = std::chrono::high_resolution_clock::now();
     auto inferenceDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -545,6 +969,36 @@ int main(int argc, char *argv[]) {
   ofsloss.close();
   weightOFS.close();
   testOFS.close();
+  encLossOFS.close();
   std::cout << "Total Time for training " << params.numIters << " epochs was " << totalTime / 1000.0 << " s"
             << std::endl;
+  scheduler.Report(std::cout, params.numIters);
+#if NATIVEINT != 128
+  if (params.withBT && btSchedule.Enabled()) btSchedule.Report(std::cout);
+#endif
+
+  if (ctThetaFinal) {
+    final_b_vec = decryptValues(ctThetaFinal, originalNumFeat);
+    final_b = Mat(originalNumFeat, Vec(1, 0.0));
+    for (auto copyI = 0U; copyI < originalNumFeat; copyI++) {
+      final_b[copyI][0] = final_b_vec[copyI];
+    }
+    std::cout << "Writing training set predictions to " << params.trainOutFile << std::endl;
+    WritePredictions(final_b, params.trainXFile, params.rowsToRead, params.trainOutFile);
+    if (!params.modelDir.empty()) {
+      std::cout << "Saving the encrypted model to " << params.modelDir << std::endl;
+      SaveEncryptedModel(params.modelDir, cc, keys, ctThetaFinal, rowSize, originalNumFeat);
+      // the last iteration's sigmoid (its -G stage and degree), so lr_infer scores with exactly the same polynomial
+      SaveSigmoidPolynomial(params.modelDir, SigmoidPolynomial{
+          sigmoidApprox, double(lastSchedule.chebRangeStart), double(lastSchedule.chebRangeEnd),
+          lastSchedule.chebDegree,
+          chebCache.Coefficients(SigmoidCacheName(sigmoidApprox), lastSchedule.chebRangeStart,
+                                 lastSchedule.chebRangeEnd, lastSchedule.chebDegree)});
+    }
+  }
+  if (remoteRefresh) {
+    refreshClient.Report(std::cout);
+    refreshClient.Shutdown();
+  }
+  tracer.ReportTotals(std::cout, params.numIters);
 }
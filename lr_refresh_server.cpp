@@ -0,0 +1,183 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/* Refresh server for interactive training (lr_nag without -b, started with -s <socket>).
+ * Generates the key pair for the crypto context the trainer provisions it with and sends back only the
+ * public and evaluation keys. Answers REFRESH requests by decrypting the (level-reduced) weights ciphertext
+ * and re-encrypting it at the top level, and DECRYPT requests with the leading plaintext values.
+ * See refresh_protocol.h.
+ */
+
+#include "openfhe.h"
+#include <getopt.h>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+#include "lr_types.h"
+#include "refresh_protocol.h"
+#include "socket_io.h"
+
+std::string SOCKET_PATH_DEF = "/tmp/lr_refresh.sock";
+
+int main(int argc, char *argv[]) {
+  std::string socketPath = SOCKET_PATH_DEF;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:h")) != -1) {
+    switch (opt) {
+      case 's':socketPath = optarg;
+        break;
+      case 'h':
+      default:
+        std::cerr << "Usage: " << std::endl
+                  << "arguments:" << std::endl
+                  << "  -s <Unix socket path> [" << SOCKET_PATH_DEF << "]" << std::endl
+                  << "  -h prints this message" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+  }
+
+  int listenFd = ListenUnixSocket(socketPath);
+  std::cout << "Refresh server listening on " << socketPath << std::endl;
+
+  CC cc;
+  KeyPair keys;
+  // DECRYPT returns at most one row of values: the weights or the loss, never a whole data ciphertext
+  uint32_t maxDecryptLength = 0;
+  usint numRefreshes = 0;
+  usint numDecryptions = 0;
+  bool running = true;
+  while (running) {
+    int fd = AcceptUnixSocket(listenFd);
+    std::cout << "Trainer connected" << std::endl;
+
+    uint32_t type;
+    std::string payload;
+    while (running && RecvFrame(fd, type, payload)) {
+      try {
+        switch (type) {
+          case REFRESH_MSG_PROVISION: {
+            auto blobs = SplitBlobs(payload);
+            if (blobs.size() != 2 || blobs[1].size() != sizeof(uint32_t)) {
+              SendFrame(fd, REFRESH_MSG_ERROR, "malformed PROVISION message");
+              break;
+            }
+            DeserializeFromString(cc, blobs[0]);
+            uint32_t rowSize;
+            std::memcpy(&rowSize, blobs[1].data(), sizeof(rowSize));
+            int signedRowSize = (int) rowSize;
+            maxDecryptLength = rowSize;
+
+            keys = cc->KeyGen();
+            cc->EvalMultKeyGen(keys.secretKey);
+            cc->EvalSumKeyGen(keys.secretKey);
+            cc->EvalRotateKeyGen(keys.secretKey, {-signedRowSize, signedRowSize});
+            MatKeys sumRowKeys = cc->EvalSumRowsKeyGen(keys.secretKey, nullptr, rowSize);
+            MatKeys sumColKeys = cc->EvalSumColsKeyGen(keys.secretKey);
+
+            std::string reply;
+            AppendBlob(reply, SerializeToString(keys.publicKey));
+            AppendEvalKeys(reply, keys.publicKey->GetKeyTag());
+            AppendBlob(reply, SerializeToString(*sumRowKeys));
+            AppendBlob(reply, SerializeToString(*sumColKeys));
+            size_t sent = SendFrame(fd, REFRESH_MSG_KEYS, reply);
+            std::cout << "\tProvisioned: ring dimension " << cc->GetRingDimension() << ", batch size "
+                      << cc->GetEncodingParams()->GetBatchSize() << ", row size " << rowSize << "; sent "
+                      << sent << " bytes of public and evaluation keys" << std::endl;
+            break;
+          }
+          case REFRESH_MSG_REFRESH: {
+            if (!cc || !keys.secretKey) {
+              SendFrame(fd, REFRESH_MSG_ERROR, "REFRESH before PROVISION");
+              break;
+            }
+            if (payload.size() < sizeof(uint32_t)) {
+              SendFrame(fd, REFRESH_MSG_ERROR, "malformed REFRESH message");
+              break;
+            }
+            TimeVar t;
+            TIC(t);
+            uint32_t period;
+            std::memcpy(&period, payload.data(), sizeof(period));
+            CT ct;
+            DeserializeFromString(ct, payload.substr(sizeof(period)));
+            size_t towersIn = ct->GetElements()[0].GetNumOfElements();
+            CT refreshed = RefreshCiphertext(cc, keys, ct, period);
+            size_t sent = SendFrame(fd, REFRESH_MSG_REFRESHED, SerializeToString(refreshed));
+            std::cout << "\tRefresh " << numRefreshes++ << ": " << payload.size() << " bytes in (" << towersIn
+                      << " towers), " << sent << " bytes out, " << TOC_US(t) / 1000.0 << " ms" << std::endl;
+            break;
+          }
+          case REFRESH_MSG_DECRYPT: {
+            if (!cc || !keys.secretKey) {
+              SendFrame(fd, REFRESH_MSG_ERROR, "DECRYPT before PROVISION");
+              break;
+            }
+            if (payload.size() < sizeof(uint32_t)) {
+              SendFrame(fd, REFRESH_MSG_ERROR, "malformed DECRYPT message");
+              break;
+            }
+            uint32_t length;
+            std::memcpy(&length, payload.data(), sizeof(length));
+            if (length > maxDecryptLength) {
+              SendFrame(fd, REFRESH_MSG_ERROR, "DECRYPT of " + std::to_string(length) +
+                  " values, more than the row size " + std::to_string(maxDecryptLength));
+              break;
+            }
+            CT ct;
+            DeserializeFromString(ct, payload.substr(sizeof(length)));
+            PT pt;
+            cc->Decrypt(keys.secretKey, ct, &pt);
+            Vec values = pt->GetRealPackedValue();
+            values.resize(std::min<size_t>(length, values.size()));
+            SendFrame(fd, REFRESH_MSG_DECRYPTED,
+                      std::string(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(double)));
+            numDecryptions++;
+            break;
+          }
+          case REFRESH_MSG_SHUTDOWN:
+            running = false;
+            break;
+          default:
+            SendFrame(fd, REFRESH_MSG_ERROR, "unknown message type " + std::to_string(type));
+        }
+      } catch (const std::exception &e) {
+        std::cerr << "Error handling message " << type << ": " << e.what() << std::endl;
+        SendFrame(fd, REFRESH_MSG_ERROR, e.what());
+      }
+    }
+    CloseSocket(fd);
+    std::cout << "Trainer disconnected" << std::endl;
+  }
+  CloseSocket(listenFd);
+  unlink(socketPath.c_str());
+  std::cout << "Served " << numRefreshes << " refreshes and " << numDecryptions << " decryptions" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,500 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/* Runs several NAG trainings in one process. The runs differ only in their training hyperparameters
+ * (learning rate gamma, momentum eta, iterations, sigmoid degree) or use other training sets of the same
+ * shape, so they can share one context, one key set, the bootstrapping setup and the encrypted data,
+ * which lr_nag would otherwise rebuild on every launch. Runs go one after the other or, with -P,
+ * several at a time on the shared context. Every run writes its own loss, test loss, weights and
+ * prediction files, and a summary of all runs goes to <prefix>summary.csv.
+ */
+
+#include "openfhe.h"
+#include <getopt.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include "cheb_cache.h"
+#include "data_io.h"
+#include "exec_config.h"
+#include "he_tracer.h"
+#include "lr_train_funcs.h"
+#include "lr_types.h"
+#include "nag_trainer.h"
+#include "shard_engine.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+/////////////////////////////////////////////////////////
+// Global Values
+/////////////////////////////////////////////////////////
+usint NUM_ITERS_DEF(200);
+usint WRITE_EVERY(10);
+int ROWS_TO_READ_DEF(-1);
+std::string TRAIN_X_FILE_DEF = "train_data/X_norm_1024.csv";
+std::string TRAIN_Y_FILE_DEF = "train_data/y_1024.csv";
+std::string TEST_X_FILE_DEF = "train_data/X_norm.csv";
+std::string TEST_Y_FILE_DEF = "train_data/y.csv";
+std::string OUT_PREFIX_DEF = "../results/sweep_";
+std::string CHEB_TABLE_DEF = "../results/chebyshev_table.txt";
+uint32_t RING_DIM_DEF(1 << 17);
+float LR_GAMMA_DEF(0.1);
+float LR_ETA_DEF(0.1);
+// Same range as lr_nag; the degree is per run
+int CHEBYSHEV_RANGE_ESTIMATION_START = -16;
+int CHEBYSHEV_RANGE_ESTIMATION_END = 16;
+int CHEBYSHEV_ESTIMATION_DEGREE = 59;
+
+struct SweepRun {
+  std::string name;
+  float gamma;
+  float eta;
+  usint numIters;
+  uint32_t chebDegree;
+  std::string trainXFile;
+  std::string trainYFile;
+  std::string testXFile;
+  std::string testYFile;
+};
+
+struct SweepResult {
+  double trainLoss;
+  double testLoss;
+  double seconds;
+  usint numRefreshes;
+};
+
+// Settings of the sweep as a whole; the context and keys are in a TrainingContext
+struct SweepSettings {
+  int btPrecision;
+  usint rowsPerShard;
+  int rowsToRead;
+  std::string outPrefix;
+};
+
+/* A training set as the runs share it: X and y are encrypted once, -gamma X' / n once per distinct
+ * gamma. The shards keep ctNegXt empty; the run picks its own from negXt.
+ */
+struct SweepData {
+  Mat X;
+  Mat y;
+  Mat testX;
+  Mat testY;
+  std::vector<DataShard> shards;
+  std::map<float, std::vector<CT>> negXt;
+};
+
+static std::mutex logMutex;
+
+// Concurrent runs print whole lines only, each tagged with the run's name
+static void Log(const SweepRun &run, const std::string &line) {
+  std::lock_guard<std::mutex> lock(logMutex);
+  std::cout << "[" << run.name << "] " << line << std::endl;
+}
+
+/* One run per line as whitespace separated key=value pairs, '#' starts a comment:
+ *   name=g05_d27 gamma=0.05 degree=27
+ *   name=other_set eta=0.3 iters=100 x=train_data/X_b.csv y=train_data/y_b.csv
+ * Keys: name (required, used in the output file names), gamma, eta, iters, degree, and x, y, j, k for the
+ * training and test files. Keys that are left out take their value from defaults.
+ */
+static std::vector<SweepRun> ReadSweepRuns(const std::string &file, const SweepRun &defaults) {
+  std::ifstream in(file);
+  if (!in.is_open()) {
+    std::cerr << "Could not open the run list " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::vector<SweepRun> runs;
+  std::string line;
+  usint lineNumber = 0;
+  while (std::getline(in, line)) {
+    lineNumber++;
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::string field;
+    SweepRun run = defaults;
+    bool any = false;
+    while (fields >> field) {
+      any = true;
+      auto eq = field.find('=');
+      if (eq == std::string::npos) {
+        std::cerr << file << ":" << lineNumber << ": expected key=value, got " << field << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      std::string key = field.substr(0, eq);
+      std::string value = field.substr(eq + 1);
+      if (key == "name") run.name = value;
+      else if (key == "gamma") run.gamma = std::stof(value);
+      else if (key == "eta") run.eta = std::stof(value);
+      else if (key == "iters") run.numIters = std::stoul(value);
+      else if (key == "degree") run.chebDegree = std::stoul(value);
+      else if (key == "x") run.trainXFile = value;
+      else if (key == "y") run.trainYFile = value;
+      else if (key == "j") run.testXFile = value;
+      else if (key == "k") run.testYFile = value;
+      else {
+        std::cerr << file << ":" << lineNumber << ": unknown key " << key << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    if (!any) continue;
+    if (run.name.empty()) {
+      std::cerr << file << ":" << lineNumber << ": every run needs a name" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    for (auto &other : runs) {
+      if (other.name == run.name) {
+        std::cerr << file << ":" << lineNumber << ": run " << run.name << " is listed twice" << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    runs.push_back(run);
+  }
+  if (runs.empty()) {
+    std::cerr << "No runs in " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return runs;
+}
+
+static std::string DataKey(const SweepRun &run) {
+  return run.trainXFile + "|" + run.trainYFile + "|" + run.testXFile + "|" + run.testYFile;
+}
+
+// -gamma X' / n of the rows [first, first + numRows), packed like EncryptShards packs it
+static CT EncryptNegXt(TrainingContext &ctx, const SweepData &data, const DataShard &shard, float gamma) {
+  Mat shardX(data.X.begin() + shard.firstRow, data.X.begin() + shard.firstRow + shard.numRows);
+  Mat shardY(data.y.begin() + shard.firstRow, data.y.begin() + shard.firstRow + shard.numRows);
+  Mat shardNegXt = InitializeLogReg(shardX, shardY, gamma / data.y.size());
+  return Mat2CtMRM(ctx.cc, shardNegXt, ctx.rowSize, ctx.numSlots, ctx.keys, ctx.dataLevels.negXt);
+}
+
+/* Loads and encrypts the training set of a run unless an earlier run already did, and encrypts -X' for
+ * the run's gamma if it is new. Called for every run before any of them starts, so the runs only read
+ * the data.
+ */
+static void PrepareData(std::map<std::string, SweepData> &datasets, TrainingContext &ctx,
+                        const SweepSettings &settings, const SweepRun &run) {
+  auto key = DataKey(run);
+  bool isNew = (datasets.find(key) == datasets.end());
+  SweepData &data = datasets[key];
+  if (isNew) {
+    std::vector<std::string> featureNames;
+    std::vector<std::string> labelNames;
+    LoadDataFile(run.trainXFile, data.X, featureNames, settings.rowsToRead, false);
+    LoadDataFile(run.testXFile, data.testX, featureNames, settings.rowsToRead, false);
+    LoadDataFile(run.trainYFile, data.y, labelNames, settings.rowsToRead, false);
+    LoadDataFile(run.testYFile, data.testY, labelNames, settings.rowsToRead, false);
+    if (data.X.size() != data.y.size() || data.testX.size() != data.testY.size()) {
+      std::cerr << " X and y dimension mismatch in " << run.trainXFile << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    // the rotation keys and the weight masks were made for one row size
+    if (ComputePaddedDimensions(data.X.size(), data.X[0].size(), ctx.numSlots).second != ctx.rowSize) {
+      std::cerr << run.trainXFile << " has " << data.X[0].size() << " features; every training set of a sweep"
+                << " must pad to " << ctx.rowSize << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    Mat NegXt = InitializeLogReg(data.X, data.y, run.gamma / data.y.size());
+    data.shards = EncryptShards(ctx.cc, data.X, NegXt, data.y, ctx.rowSize, ctx.numSlots, settings.rowsPerShard,
+                                ctx.keys, ctx.dataLevels);
+    auto &negXt = data.negXt[run.gamma];
+    for (auto &shard : data.shards) {
+      negXt.push_back(shard.ctNegXt);
+      shard.ctNegXt = nullptr;
+    }
+    std::cout << "Encrypted " << run.trainXFile << ": " << data.X.size() << " rows in " << data.shards.size()
+              << " shard(s)" << std::endl;
+  }
+  if (data.negXt.find(run.gamma) == data.negXt.end()) {
+    auto &negXt = data.negXt[run.gamma];
+    for (auto &shard : data.shards) negXt.push_back(EncryptNegXt(ctx, data, shard, run.gamma));
+    std::cout << "Encrypted -X' of " << run.trainXFile << " for gamma " << run.gamma << std::endl;
+  }
+}
+
+static Mat DecryptTheta(const TrainingContext &ctx, const CT &ctTheta, usint numFeatures) {
+  PT ptTheta;
+  TracedDecrypt(ctx.cc, ctx.keys, ctTheta, &ptTheta);
+  auto thetaVec = ptTheta->GetRealPackedValue();
+  Mat theta(numFeatures, Vec(1, 0.0));
+  for (usint i = 0; i < numFeatures; i++) theta[i][0] = thetaVec[i];
+  return theta;
+}
+
+static std::ofstream OpenOutput(const std::string &file, const std::string &header) {
+  std::ofstream ofs(file, std::ofstream::out | std::ofstream::trunc);
+  if (!ofs.is_open()) {
+    std::cerr << "Could not open " << file << " for writing" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  ofs.precision(dbl::max_digits10);
+  ofs << header << std::endl;
+  return ofs;
+}
+
+// TrainNag on the shared data, with the plaintext loss of the decrypted weights after every iteration
+static SweepResult RunSweep(const TrainingContext &ctx, const SweepSettings &settings, const SweepRun &run,
+                            const SweepData &data, int threads) {
+  std::string prefix = settings.outPrefix + run.name + "_";
+  auto ofsloss = OpenOutput(prefix + "loss.csv", "Time Taken(s), Train Losses");
+  auto weightOFS = OpenOutput(prefix + "weights.csv", "Weights");
+  auto testOFS = OpenOutput(prefix + "test.csv", "Test Losses");
+
+  auto shards = data.shards;
+  auto &negXt = data.negXt.at(run.gamma);
+  for (size_t i = 0; i < shards.size(); i++) shards[i].ctNegXt = negXt[i];
+
+  NagJob job{run.eta, run.numIters, run.chebDegree, CHEBYSHEV_RANGE_ESTIMATION_START, CHEBYSHEV_RANGE_ESTIMATION_END,
+             settings.btPrecision, usint(data.X.size()), 0, 0};
+  usint numFeatures = data.X[0].size();
+  Mat theta(numFeatures, Vec(1, 0.0));
+  SweepResult result{0, 0, 0, 0};
+  bool testLossCurrent = false;
+
+  auto nagResult = TrainNag(ctx, shards, job, threads, [&](const NagIteration &iteration, const CT &ctTheta) {
+    theta = DecryptTheta(ctx, ctTheta, numFeatures);
+    result.trainLoss = ComputeLoss(theta, data.X, data.y);
+    ofsloss << iteration.ms << ", " << result.trainLoss << std::endl;
+
+    std::ostringstream line;
+    line << "Iteration " << iteration.iteration << ": loss " << result.trainLoss << ", "
+         << (iteration.refreshed ? "refreshed, " : "") << iteration.levelsBefore << " levels left, took "
+         << iteration.ms / 1000.0 << " s";
+    Log(run, line.str());
+
+    testLossCurrent = false;
+    if (iteration.iteration % WRITE_EVERY == 0 && iteration.iteration > 0) {
+      weightOFS << iteration.iteration << ",";
+      for (auto &singletonWeight : theta) weightOFS << singletonWeight[0] << ",";
+      weightOFS << std::endl;
+      result.testLoss = ComputeLoss(theta, data.testX, data.testY);
+      testOFS << iteration.iteration << ", " << result.testLoss << std::endl;
+      testLossCurrent = true;
+    }
+  });
+  // the final weights and test loss, unless the last iteration already wrote them
+  if (!testLossCurrent) {
+    weightOFS << run.numIters << ",";
+    for (auto &singletonWeight : theta) weightOFS << singletonWeight[0] << ",";
+    weightOFS << std::endl;
+    result.testLoss = ComputeLoss(theta, data.testX, data.testY);
+    testOFS << run.numIters << ", " << result.testLoss << std::endl;
+  }
+  WritePredictions(theta, run.trainXFile, settings.rowsToRead, prefix + "train.csv");
+  result.numRefreshes = nagResult.numRefreshes;
+  result.seconds = nagResult.seconds;
+
+  std::ostringstream line;
+  line << "Done: train loss " << result.trainLoss << ", test loss " << result.testLoss << ", "
+       << result.numRefreshes << " refreshes, " << result.seconds << " s";
+  Log(run, line.str());
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  std::string runsFile;
+  bool withBT = false;
+  int btPrecision = 0;
+  uint32_t ringDim = RING_DIM_DEF;
+  int rowsToRead = ROWS_TO_READ_DEF;
+  usint itersPerRefresh = 1;
+  usint rowsPerShard = 0;
+  usint runWorkers = 1;
+  std::string outPrefix = OUT_PREFIX_DEF;
+  std::string chebTableFile = CHEB_TABLE_DEF;
+  ExecOptions execOptions;
+  SweepRun defaults{"", LR_GAMMA_DEF, LR_ETA_DEF, NUM_ITERS_DEF, uint32_t(CHEBYSHEV_ESTIMATION_DEGREE),
+                    TRAIN_X_FILE_DEF, TRAIN_Y_FILE_DEF, TEST_X_FILE_DEF, TEST_Y_FILE_DEF};
+
+  int opt;
+  while ((opt = getopt(argc, argv, "c:be:d:r:i:S:P:w:C:n:x:y:j:k:H:J:N:B:O:h")) != -1) {
+    switch (opt) {
+      case 'c':runsFile = optarg;
+        break;
+      case 'b':withBT = true;
+        break;
+      case 'e':btPrecision = atoi(optarg);
+        break;
+      case 'd':ringDim = atoi(optarg);
+        break;
+      case 'r':rowsToRead = atoi(optarg);
+        break;
+      case 'i':itersPerRefresh = atoi(optarg);
+        break;
+      case 'S':rowsPerShard = atoi(optarg);
+        break;
+      case 'P':runWorkers = atoi(optarg);
+        break;
+      case 'w':outPrefix = optarg;
+        break;
+      case 'C':chebTableFile = optarg;
+        break;
+      case 'n':defaults.numIters = atoi(optarg);
+        break;
+      case 'x':defaults.trainXFile = optarg;
+        break;
+      case 'y':defaults.trainYFile = optarg;
+        break;
+      case 'j':defaults.testXFile = optarg;
+        break;
+      case 'k':defaults.testYFile = optarg;
+        break;
+      case 'H':execOptions.threads = atoi(optarg);
+        break;
+      case 'J':execOptions.phaseThreads = optarg;
+        break;
+      case 'N':execOptions.nested = atoi(optarg);
+        break;
+      case 'B':execOptions.pin = optarg;
+        break;
+      case 'O':execOptions.numaNode = atoi(optarg);
+        break;
+      case 'h':
+      default:
+        std::cerr << "Usage: " << std::endl
+                  << "arguments:" << std::endl
+                  << "  -c <run list: one run per line as key=value pairs (name, gamma, eta, iters, degree, x, y,"
+                  << " j, k)>" << std::endl
+                  << "  -b do bootstraping (re-encrypt otherwise) [false]" << std::endl
+                  << "  -e <bootstrapping precision in 64-bit scenario> [0]" << std::endl
+                  << "  -d <ring dimension> [" << RING_DIM_DEF << "]" << std::endl
+                  << "  -r <number of rows to read> [" << ROWS_TO_READ_DEF << "]" << std::endl
+                  << "  -i <NAG iterations per bootstrap/refresh> [1]" << std::endl
+                  << "  -S <rows per data shard, 0 = as many as fit in a ciphertext> [0]" << std::endl
+                  << "  -P <runs trained concurrently; the OpenMP threads are split among them> [1]" << std::endl
+                  << "  -w <output file name prefix, followed by <run name>_> [" << OUT_PREFIX_DEF << "]" << std::endl
+                  << "  -C <Chebyshev coefficient table shared with lr_nag> [" << CHEB_TABLE_DEF << "]" << std::endl
+                  << "  -n <default number of iterations> [" << NUM_ITERS_DEF << "]" << std::endl
+                  << "  -x <default training X file name> [" << TRAIN_X_FILE_DEF << "]" << std::endl
+                  << "  -y <default training y file name> [" << TRAIN_Y_FILE_DEF << "]" << std::endl
+                  << "  -j <default testing X file name> [" << TEST_X_FILE_DEF << "]" << std::endl
+                  << "  -k <default testing y file name> [" << TEST_Y_FILE_DEF << "]" << std::endl
+                  << "  -H <OpenMP threads> [OpenMP's default]" << std::endl
+                  << "  -J <threads per phase, e.g. gradient=16 (see exec_config.h)> [-H]" << std::endl
+                  << "  -N <nested OpenMP regions inside OpenFHE, 0|1> [OpenMP's default]" << std::endl
+                  << "  -B <thread pinning: none, compact or spread> [none]" << std::endl
+                  << "  -O <run on this NUMA node only> [all]" << std::endl
+                  << "  -h prints this message" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+  }
+  if (runsFile.empty()) {
+    std::cerr << "A run list (-c) is required." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  rowsToRead = (rowsToRead == 0) ? -1 : rowsToRead;
+  itersPerRefresh = (itersPerRefresh == 0) ? 1 : itersPerRefresh;
+  runWorkers = std::max(usint(1), runWorkers);
+
+  auto runs = ReadSweepRuns(runsFile, defaults);
+  runWorkers = std::min(runWorkers, usint(runs.size()));
+
+  auto execConfig = ExecConfig::FromOptions(execOptions);
+  execConfig.Apply();
+  execConfig.Report(std::cout);
+
+  /////////////////////////////////////////////////////////
+  // One context for the most expensive sigmoid of the sweep
+  /////////////////////////////////////////////////////////
+  uint32_t maxDegree = 0;
+  uint32_t minDegree = runs[0].chebDegree;
+  for (auto &run : runs) {
+    maxDegree = std::max(maxDegree, run.chebDegree);
+    minDegree = std::min(minDegree, run.chebDegree);
+  }
+  usint shapeNumSamples;
+  usint shapeNumFeatures;
+  ReadDataShape(runs[0].trainXFile, rowsToRead, shapeNumSamples, shapeNumFeatures);
+
+  std::cout << runs.size() << " run(s), sigmoid degrees " << minDegree << " to " << maxDegree << std::endl;
+  std::cout << "Generating the context and keys" << std::endl;
+  TrainingContextSpec spec{withBT, ringDim, maxDegree, minDegree, itersPerRefresh, shapeNumFeatures, 0};
+  auto ctx = MakeTrainingContext(spec);
+  std::cout << "\tMultiplicative depth " << ctx->multDepth << ", " << ctx->levelsAfterRefresh
+            << " levels after a refresh" << std::endl;
+  SweepSettings settings{btPrecision, rowsPerShard, rowsToRead, outPrefix};
+
+  // every run's sigmoid is in the cache before any of them starts
+  auto &chebCache = ChebyshevCache::Get();
+  if (!chebTableFile.empty()) chebCache.UseTable(chebTableFile);
+  for (auto &run : runs) {
+    chebCache.Coefficients(SigmoidCacheName(SIGMOID_CHEBYSHEV), CHEBYSHEV_RANGE_ESTIMATION_START,
+                           CHEBYSHEV_RANGE_ESTIMATION_END, run.chebDegree);
+  }
+
+  /////////////////////////////////////////////////////////
+  // Encrypt each distinct training set once, at the levels the cheapest sigmoid consumes it at
+  /////////////////////////////////////////////////////////
+  std::map<std::string, SweepData> datasets;
+  for (auto &run : runs) PrepareData(datasets, *ctx, settings, run);
+
+  /////////////////////////////////////////////////////////
+  // Train
+  /////////////////////////////////////////////////////////
+  int totalThreads = execConfig.ThreadsFor("gradient");
+  int threadsPerRun = std::max(1, totalThreads / int(runWorkers));
+  std::vector<SweepResult> results(runs.size());
+  if (runWorkers == 1) {
+    for (size_t i = 0; i < runs.size(); i++) {
+      results[i] = RunSweep(*ctx, settings, runs[i], datasets.at(DataKey(runs[i])), threadsPerRun);
+    }
+  } else {
+    std::cout << "Training " << runWorkers << " runs at a time, " << threadsPerRun << " thread(s) each" << std::endl;
+    ThreadPool pool(runWorkers, threadsPerRun);
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < runs.size(); i++) {
+      futures.push_back(pool.Submit([&, i]() {
+        results[i] = RunSweep(*ctx, settings, runs[i], datasets.at(DataKey(runs[i])), threadsPerRun);
+      }));
+    }
+    WaitAll(futures);
+  }
+
+  auto summaryOFS = OpenOutput(outPrefix + "summary.csv",
+                               "Run, Gamma, Eta, Iterations, Sigmoid Degree, Refreshes, Train Loss, Test Loss, "
+                               "Time Taken(s)");
+  std::cout << "Run\tGamma\tEta\tIters\tDegree\tTrain loss\tTest loss\tTime (s)" << std::endl;
+  for (size_t i = 0; i < runs.size(); i++) {
+    auto &run = runs[i];
+    auto &result = results[i];
+    summaryOFS << run.name << ", " << run.gamma << ", " << run.eta << ", " << run.numIters << ", " << run.chebDegree
+               << ", " << result.numRefreshes << ", " << result.trainLoss << ", " << result.testLoss << ", "
+               << result.seconds << std::endl;
+    std::cout << run.name << "\t" << run.gamma << "\t" << run.eta << "\t" << run.numIters << "\t" << run.chebDegree
+              << "\t" << result.trainLoss << "\t" << result.testLoss << "\t" << result.seconds << std::endl;
+  }
+  std::cout << "Summary written to " << outPrefix << "summary.csv" << std::endl;
+  return 0;
+}
@@ -0,0 +1,265 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/* Submits a training job to lr_train_daemon: asks for a context that fits the data and the sigmoid,
+ * generates a key pair for it and uploads the public and evaluation keys (or, with -K, reuses a saved key
+ * pair and the daemon's kept copy of its evaluation keys), encrypts X, -gamma X' / n and y,
+ * sends them and prints the per-iteration metrics while the job runs. The secret key stays here: the
+ * client decrypts the encrypted loss and, for interactive jobs, re-encrypts the weights when the daemon
+ * asks. The metrics go to <prefix>metrics.csv and the encrypted theta to <prefix>theta.bin.
+ */
+
+#include "openfhe.h"
+#include <getopt.h>
+#include <fstream>
+#include <iostream>
+#include "data_io.h"
+#include "lr_train_funcs.h"
+#include "lr_types.h"
+#include "model_io.h"
+#include "shard_engine.h"
+#include "train_protocol.h"
+
+std::string SOCKET_PATH_DEF = "/tmp/lr_train.sock";
+std::string TRAIN_X_FILE_DEF = "train_data/X_norm_1024.csv";
+std::string TRAIN_Y_FILE_DEF = "train_data/y_1024.csv";
+std::string OUT_PREFIX_DEF = "../results/daemon_";
+uint32_t RING_DIM_DEF(1 << 17);
+usint NUM_ITERS_DEF(200);
+float LR_GAMMA_DEF(0.1);
+float LR_ETA_DEF(0.1);
+int ROWS_TO_READ_DEF(-1);
+int CHEBYSHEV_RANGE_ESTIMATION_START = -16;
+int CHEBYSHEV_RANGE_ESTIMATION_END = 16;
+uint32_t CHEBYSHEV_ESTIMATION_DEGREE = 59;
+uint32_t SOFTPLUS_ESTIMATION_DEGREE = 59;
+
+int main(int argc, char *argv[]) {
+  std::string socketPath = SOCKET_PATH_DEF;
+  std::string trainXFile = TRAIN_X_FILE_DEF;
+  std::string trainYFile = TRAIN_Y_FILE_DEF;
+  std::string outPrefix = OUT_PREFIX_DEF;
+  std::string modelDir;
+  std::string keyDir;
+  bool releaseKeys = false;
+  int rowsToRead = ROWS_TO_READ_DEF;
+  usint rowsPerShard = 0;
+  float gamma = LR_GAMMA_DEF;
+  bool shutdown = false;
+  TrainingContextSpec spec{false, RING_DIM_DEF, CHEBYSHEV_ESTIMATION_DEGREE, CHEBYSHEV_ESTIMATION_DEGREE, 1, 0,
+                           0};
+  NagJob job{LR_ETA_DEF, NUM_ITERS_DEF, CHEBYSHEV_ESTIMATION_DEGREE, CHEBYSHEV_RANGE_ESTIMATION_START,
+             CHEBYSHEV_RANGE_ESTIMATION_END, 0, 0, 0, SOFTPLUS_ESTIMATION_DEGREE};
+
+  int opt;
+  while ((opt = getopt(argc, argv, "s:x:y:r:S:bd:g:i:n:G:E:e:l:M:K:Rw:qh")) != -1) {
+    switch (opt) {
+      case 's':socketPath = optarg;
+        break;
+      case 'x':trainXFile = optarg;
+        break;
+      case 'y':trainYFile = optarg;
+        break;
+      case 'r':rowsToRead = atoi(optarg);
+        break;
+      case 'S':rowsPerShard = atoi(optarg);
+        break;
+      case 'b':spec.withBT = true;
+        break;
+      case 'd':spec.ringDim = atoi(optarg);
+        break;
+      case 'g':job.chebDegree = atoi(optarg);
+        break;
+      case 'i':spec.itersPerRefresh = atoi(optarg);
+        break;
+      case 'n':job.numIters = atoi(optarg);
+        break;
+      case 'G':gamma = atof(optarg);
+        break;
+      case 'E':job.eta = atof(optarg);
+        break;
+      case 'e':job.btPrecision = atoi(optarg);
+        break;
+      case 'l':job.encLossEvery = atoi(optarg);
+        break;
+      case 'M':modelDir = optarg;
+        break;
+      case 'K':keyDir = optarg;
+        break;
+      case 'R':releaseKeys = true;
+        break;
+      case 'w':outPrefix = optarg;
+        break;
+      case 'q':shutdown = true;
+        break;
+      case 'h':
+      default:
+        std::cerr << "Usage: " << std::endl
+                  << "arguments:" << std::endl
+                  << "  -s <daemon socket path> [" << SOCKET_PATH_DEF << "]" << std::endl
+                  << "  -x <training X file name> [" << TRAIN_X_FILE_DEF << "]" << std::endl
+                  << "  -y <training y file name> [" << TRAIN_Y_FILE_DEF << "]" << std::endl
+                  << "  -r <number of rows to read> [" << ROWS_TO_READ_DEF << "]" << std::endl
+                  << "  -S <rows per data shard, 0 = as many as fit in a ciphertext> [0]" << std::endl
+                  << "  -b bootstrap (the client re-encrypts otherwise) [false]" << std::endl
+                  << "  -d <ring dimension> [" << RING_DIM_DEF << "]" << std::endl
+                  << "  -g <Chebyshev degree of the sigmoid> [" << CHEBYSHEV_ESTIMATION_DEGREE << "]" << std::endl
+                  << "  -i <NAG iterations per bootstrap/refresh> [1]" << std::endl
+                  << "  -n <number of iterations> [" << NUM_ITERS_DEF << "]" << std::endl
+                  << "  -G <learning rate gamma> [" << LR_GAMMA_DEF << "]" << std::endl
+                  << "  -E <momentum eta> [" << LR_ETA_DEF << "]" << std::endl
+                  << "  -e <bootstrapping precision in 64-bit scenario> [0]" << std::endl
+                  << "  -l <encrypted loss every k iterations, 0 = off> [0]" << std::endl
+                  << "  -M <directory to save the encrypted model to, for lr_infer> [none]" << std::endl
+                  << "  -K <key directory: reuse the key pair saved there, or save a new one; the daemon keeps the"
+                  << " evaluation keys> [new keys every run]" << std::endl
+                  << "  -R release the daemon's kept keys of -K after the job" << std::endl
+                  << "  -w <output file name prefix> [" << OUT_PREFIX_DEF << "]" << std::endl
+                  << "  -q ask the daemon to shut down once its running jobs are done" << std::endl
+                  << "  -h prints this message" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+  }
+  rowsToRead = (rowsToRead == 0) ? -1 : rowsToRead;
+
+  TrainClient client;
+  client.Connect(socketPath);
+  if (shutdown) {
+    try {
+      client.ShutdownDaemon();
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    std::cout << "Asked the daemon at " << socketPath << " to shut down" << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  Mat X;
+  Mat y;
+  std::vector<std::string> featureNames;
+  std::vector<std::string> labelNames;
+  LoadDataFile(trainXFile, X, featureNames, rowsToRead, false);
+  LoadDataFile(trainYFile, y, labelNames, rowsToRead, false);
+  if (X.empty() || X.size() != y.size()) {
+    std::cerr << " X and y dimension mismatch!" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  spec.numFeatures = X[0].size();
+  spec.minDegree = job.chebDegree;
+  spec.maxDegree = job.chebDegree;
+  spec.lossDegree = (job.encLossEvery > 0) ? job.lossDegree : 0;
+  job.numSamples = X.size();
+
+  std::cout << "Requesting a context" << std::endl;
+  CC cc;
+  auto info = client.RequestContext(spec, cc);
+  std::cout << "\tContext " << info.contextId << (info.created ? ", created in " + std::to_string(info.setupSeconds)
+      + " s" : ", resident") << std::endl;
+
+  // The key pair is generated here and the secret key never leaves this process. With -K, a saved pair for
+  // this context skips key generation, and the upload too while the daemon still keeps its evaluation keys.
+  ClientKeys clientKeys;
+  bool keepKeys = !keyDir.empty();
+  if (keepKeys && LoadClientKeys(keyDir, cc, info.rowSize, info.numSlotsBoot, spec.withBT, clientKeys)) {
+    std::cout << "Using the keys saved in " << keyDir << std::endl;
+    if (client.UseKeys(info.contextId, clientKeys.keys.publicKey->GetKeyTag())) {
+      std::cout << "\tThe daemon still holds their evaluation keys" << std::endl;
+    } else {
+      client.SendKeys(info.contextId, clientKeys.evalKeys, true);
+    }
+  } else {
+    TrainingContext keyCtx{};
+    keyCtx.spec = spec;
+    keyCtx.cc = cc;
+    keyCtx.rowSize = info.rowSize;
+    keyCtx.numSlots = info.numSlots;
+    keyCtx.numSlotsBoot = info.numSlotsBoot;
+    std::cout << "Generating keys" << std::endl;
+    SetupTrainingBootstrap(keyCtx);
+    GenerateTrainingKeys(keyCtx);
+    clientKeys = ClientKeys{keyCtx.keys, SerializeTrainingKeys(keyCtx), info.rowSize, info.numSlotsBoot, spec.withBT};
+    client.SendKeys(info.contextId, clientKeys.evalKeys, keepKeys);
+    if (keepKeys) {
+      SaveClientKeys(keyDir, cc, clientKeys);
+      std::cout << "\tKeys saved to " << keyDir << std::endl;
+    }
+  }
+  KeyPair &keys = clientKeys.keys;
+
+  Mat NegXt = InitializeLogReg(X, y, gamma / y.size());
+  auto shards = EncryptShards(cc, X, NegXt, y, info.rowSize, info.numSlots, rowsPerShard, keys, info.dataLevels);
+  std::cout << "Encrypted " << X.size() << " rows in " << shards.size() << " shard(s)" << std::endl;
+
+  std::ofstream metricsOFS(outPrefix + "metrics.csv", std::ofstream::out | std::ofstream::trunc);
+  if (!metricsOFS.is_open()) {
+    std::cerr << "Could not open " << outPrefix << "metrics.csv for writing" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  metricsOFS.precision(dbl::max_digits10);
+  metricsOFS << "Iteration, Time Taken(ms), Refreshed, Levels Left, Sigmoid Degree, Encrypted Train Loss" << std::endl;
+
+  TrainJobSummary summary;
+  auto onMetric = [&](const TrainMetric &metric, const CT &ctLoss) {
+    double loss = 0;
+    if (ctLoss) {
+      PT ptLoss;
+      cc->Decrypt(keys.secretKey, ctLoss, &ptLoss);
+      loss = ptLoss->GetRealPackedValue()[0];
+    }
+    std::cout << "\tIteration " << metric.iteration << ": " << metric.ms << " ms, " << metric.levelsBefore
+              << " levels left" << (metric.refreshed ? ", refreshed" : "");
+    if (ctLoss) std::cout << ", encrypted loss " << loss;
+    std::cout << std::endl;
+    metricsOFS << metric.iteration << ", " << metric.ms << ", " << metric.refreshed << ", " << metric.levelsBefore
+               << ", " << metric.chebDegree << ", ";
+    if (ctLoss) metricsOFS << loss;
+    metricsOFS << std::endl;
+  };
+  auto onRefresh = [&](const CT &ct, usint period) {
+    return RefreshCiphertext(cc, keys, ct, period);
+  };
+  CT ctTheta = client.Train(info.contextId, job, shards, onMetric, onRefresh, summary);
+
+  lbcrypto::Serial::SerializeToFile(outPrefix + "theta.bin", ctTheta, lbcrypto::SerType::BINARY);
+  std::cout << "Job " << summary.jobId << ": " << summary.trainSeconds << " s training, " << summary.queueSeconds
+            << " s queued, " << summary.numRefreshes << " refreshes" << std::endl;
+  std::cout << "Encrypted theta written to " << outPrefix << "theta.bin" << std::endl;
+  if (!modelDir.empty()) {
+    SaveEncryptedModel(modelDir, cc, keys, ctTheta, info.rowSize, spec.numFeatures);
+    std::cout << "Encrypted model saved to " << modelDir << std::endl;
+  }
+  if (keepKeys && releaseKeys) {
+    client.ReleaseKeys(keys.publicKey->GetKeyTag());
+    std::cout << "Released the daemon's copy of the keys" << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
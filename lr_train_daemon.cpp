@@ -0,0 +1,481 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/* Training daemon. Keeps crypto contexts, their evaluation keys and bootstrapping precomputations
+ * resident between jobs, so a job only pays for its iterations. Clients (lr_train_client) ask for a
+ * context by TrainingContextSpec, encrypt their data under its public key and submit it as a job over a
+ * Unix socket. Jobs run on a pool of workers; each one streams a METRIC per iteration and ends with the
+ * encrypted theta. See train_protocol.h.
+ *
+ * The daemon never holds a secret key. Its contexts carry no keys; each client generates its own key
+ * pair for the context and uploads the public and evaluation keys. Keys uploaded with keep stay resident
+ * by key tag, so a client that saved its key pair (lr_train_client -K) skips key generation and upload on
+ * later jobs; other keys are dropped when the connection closes. Everything that needs the secret key goes
+ * back to the client: the re-encryptions of interactive jobs and the decryption of the encrypted loss.
+ */
+
+#include "openfhe.h"
+#include <getopt.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <csignal>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include "cheb_cache.h"
+#include "exec_config.h"
+#include "he_tracer.h"
+#include "lr_types.h"
+#include "nag_trainer.h"
+#include "socket_io.h"
+#include "thread_pool.h"
+#include "train_protocol.h"
+
+std::string SOCKET_PATH_DEF = "/tmp/lr_train.sock";
+std::string CHEB_TABLE_DEF = "../results/chebyshev_table.txt";
+uint32_t RING_DIM_DEF(1 << 17);
+uint32_t CHEBYSHEV_ESTIMATION_DEGREE(59);
+
+// Resident contexts, without keys; a context is never released, so the references handed out stay valid
+class ContextRegistry {
+ public:
+  // A resident context that serves spec, created first if there is none
+  uint32_t Acquire(const TrainingContextSpec &spec, bool &created, double &setupSeconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (uint32_t id = 0; id < contexts.size(); id++) {
+      if (contexts[id]->spec.Serves(spec)) {
+        created = false;
+        setupSeconds = 0;
+        return id;
+      }
+    }
+    // creation holds the lock: a second request for the same spec waits for this context instead of
+    // building its own
+    auto start = std::chrono::high_resolution_clock::now();
+    contexts.push_back(MakeTrainingContext(spec, false));
+    setupSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    created = true;
+    auto &ctx = *contexts.back();
+    std::cout << "Context " << contexts.size() - 1 << ": " << (spec.withBT ? "bootstrapping" : "interactive")
+              << ", ring dimension " << spec.ringDim << ", degrees " << spec.minDegree << " to " << spec.maxDegree
+              << ", row size " << ctx.rowSize << ", depth " << ctx.multDepth << ", created in " << setupSeconds
+              << " s" << std::endl;
+    return contexts.size() - 1;
+  }
+
+  std::shared_ptr<TrainingContext> Get(uint32_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id >= contexts.size()) return nullptr;
+    return contexts[id];
+  }
+
+ private:
+  std::mutex mutex;
+  std::vector<std::shared_ptr<TrainingContext>> contexts;
+};
+
+/* A resident context with one client's keys. The evaluation keys live in OpenFHE's global maps under the
+ * key tag; they are cleared once the last connection, job or KeyRegistry entry holding the context lets go.
+ */
+static std::shared_ptr<TrainingContext> MakeKeyedContext(const TrainingContext &resident) {
+  return std::shared_ptr<TrainingContext>(new TrainingContext(resident), [](TrainingContext *ctx) {
+    if (ctx->keys.publicKey) {
+      std::string keyTag = ctx->keys.publicKey->GetKeyTag();
+      lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>::ClearEvalMultKeys(keyTag);
+      lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>::ClearEvalAutomorphismKeys(keyTag);
+    }
+    delete ctx;
+  });
+}
+
+// Keys uploaded with keep, by key tag, until a RELEASE_KEYS
+class KeyRegistry {
+ public:
+  // The kept keys with keyTag, if they were uploaded for contextId
+  std::shared_ptr<TrainingContext> Find(const std::string &keyTag, uint32_t contextId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = keySets.find(keyTag);
+    if (found == keySets.end() || found->second.first != contextId) return nullptr;
+    return found->second.second;
+  }
+
+  void Keep(const std::string &keyTag, uint32_t contextId, const std::shared_ptr<TrainingContext> &ctx) {
+    std::lock_guard<std::mutex> lock(mutex);
+    keySets[keyTag] = {contextId, ctx};
+  }
+
+  bool Release(const std::string &keyTag) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return keySets.erase(keyTag) > 0;
+  }
+
+ private:
+  std::mutex mutex;
+  std::map<std::string, std::pair<uint32_t, std::shared_ptr<TrainingContext>>> keySets;
+};
+
+struct Daemon {
+  std::string socketPath;
+  ContextRegistry registry;
+  KeyRegistry keyRegistry;
+  std::unique_ptr<ThreadPool> pool;
+  int threadsPerJob;
+  std::atomic<uint32_t> nextJobId{0};
+  std::atomic<uint32_t> jobsInFlight{0};
+  std::atomic<bool> running{true};
+};
+
+static void HandleContext(Daemon &daemon, int fd, const std::string &payload) {
+  TrainingContextSpec spec;
+  if (!PodFromString(spec, payload)) {
+    SendFrame(fd, TRAIN_MSG_ERROR, "malformed CONTEXT message");
+    return;
+  }
+  if (spec.minDegree == 0 || spec.minDegree > spec.maxDegree) {
+    SendFrame(fd, TRAIN_MSG_ERROR, "the context's degree range is empty");
+    return;
+  }
+  TrainContextInfo info{};
+  bool created;
+  info.contextId = daemon.registry.Acquire(spec, created, info.setupSeconds);
+  info.created = created ? 1 : 0;
+  auto ctx = daemon.registry.Get(info.contextId);
+  info.rowSize = ctx->rowSize;
+  info.numSlots = ctx->numSlots;
+  info.numSlotsBoot = ctx->numSlotsBoot;
+  info.dataLevels = ctx->dataLevels;
+
+  std::string reply;
+  AppendBlob(reply, PodToString(info));
+  AppendBlob(reply, SerializeToString(ctx->cc));
+  SendFrame(fd, TRAIN_MSG_CONTEXT_READY, reply);
+}
+
+// A connection's view of the resident contexts it has keys for: the context with the client's keys
+using ClientContexts = std::map<uint32_t, std::shared_ptr<TrainingContext>>;
+
+static void HandleKeys(Daemon &daemon, int fd, const std::string &payload, ClientContexts &clientContexts) {
+  auto blobs = SplitBlobs(payload);
+  uint32_t contextId;
+  uint32_t keep;
+  if (blobs.size() != 7 || !PodFromString(contextId, blobs[0]) || !PodFromString(keep, blobs[1])) {
+    SendFrame(fd, TRAIN_MSG_ERROR, "malformed KEYS message");
+    return;
+  }
+  auto resident = daemon.registry.Get(contextId);
+  if (!resident) {
+    SendFrame(fd, TRAIN_MSG_ERROR, "unknown context " + std::to_string(contextId));
+    return;
+  }
+  lbcrypto::PublicKey<lbcrypto::DCRTPoly> publicKey;
+  DeserializeFromString(publicKey, blobs[2]);
+  std::string keyTag = publicKey->GetKeyTag();
+  // an upload of keys that are already kept (e.g. after a USE_KEYS the client did not try) changes nothing
+  auto ctx = daemon.keyRegistry.Find(keyTag, contextId);
+  if (!ctx) {
+    ctx = MakeKeyedContext(*resident);
+    ctx->keys.publicKey = publicKey;
+    LoadEvalKeys(blobs[3], blobs[4]);
+    ctx->rowKeys = std::make_shared<std::map<usint, lbcrypto::EvalKey<lbcrypto::DCRTPoly>>>();
+    ctx->colKeys = std::make_shared<std::map<usint, lbcrypto::EvalKey<lbcrypto::DCRTPoly>>>();
+    DeserializeFromString(*ctx->rowKeys, blobs[5]);
+    DeserializeFromString(*ctx->colKeys, blobs[6]);
+    if (keep) daemon.keyRegistry.Keep(keyTag, contextId, ctx);
+  }
+  clientContexts[contextId] = ctx;
+  SendFrame(fd, TRAIN_MSG_KEYS_READY, PodToString(uint32_t(1)));
+  std::cout << "Keys for context " << contextId << " received (" << payload.size() << " bytes"
+            << (keep ? ", kept" : "") << ")" << std::endl;
+}
+
+static void HandleUseKeys(Daemon &daemon, int fd, const std::string &payload, ClientContexts &clientContexts) {
+  auto blobs = SplitBlobs(payload);
+  uint32_t contextId;
+  if (blobs.size() != 2 || !PodFromString(contextId, blobs[0])) {
+    SendFrame(fd, TRAIN_MSG_ERROR, "malformed USE_KEYS message");
+    return;
+  }
+  auto ctx = daemon.keyRegistry.Find(blobs[1], contextId);
+  if (ctx) clientContexts[contextId] = ctx;
+  SendFrame(fd, TRAIN_MSG_KEYS_READY, PodToString(uint32_t(ctx ? 1 : 0)));
+}
+
+static void HandleReleaseKeys(Daemon &daemon, int fd, const std::string &keyTag, ClientContexts &clientContexts) {
+  bool released = daemon.keyRegistry.Release(keyTag);
+  for (auto it = clientContexts.begin(); it != clientContexts.end();) {
+    it = (it->second->keys.publicKey->GetKeyTag() == keyTag) ? clientContexts.erase(it) : std::next(it);
+  }
+  SendFrame(fd, TRAIN_MSG_KEYS_READY, PodToString(uint32_t(0)));
+  if (released) std::cout << "Kept keys released" << std::endl;
+}
+
+static void HandleJob(Daemon &daemon, int fd, const std::string &payload, const ClientContexts &clientContexts) {
+  auto blobs = SplitBlobs(payload);
+  TrainJobHeader header;
+  if (blobs.empty() || !PodFromString(header, blobs[0]) || blobs.size() != 1 + 4 * size_t(header.numShards) ||
+      header.numShards == 0) {
+    SendFrame(fd, TRAIN_MSG_ERROR, "malformed JOB message");
+    return;
+  }
+  auto found = clientContexts.find(header.contextId);
+  if (found == clientContexts.end()) {
+    SendFrame(fd, TRAIN_MSG_ERROR, "no keys for context " + std::to_string(header.contextId) + ", send KEYS first");
+    return;
+  }
+  auto ctx = found->second;
+  std::vector<DataShard> shards(header.numShards);
+  for (usint i = 0; i < header.numShards; i++) {
+    TrainShardRows rows;
+    if (!PodFromString(rows, blobs[1 + 4 * i])) {
+      SendFrame(fd, TRAIN_MSG_ERROR, "malformed JOB message");
+      return;
+    }
+    shards[i].firstRow = rows.firstRow;
+    shards[i].numRows = rows.numRows;
+    DeserializeFromString(shards[i].ctX, blobs[2 + 4 * i]);
+    DeserializeFromString(shards[i].ctNegXt, blobs[3 + 4 * i]);
+    DeserializeFromString(shards[i].ctLabels, blobs[4 + 4 * i]);
+  }
+  blobs.clear();
+
+  uint32_t jobId = daemon.nextJobId++;
+  uint32_t jobsAhead = daemon.jobsInFlight++;
+  SendFrame(fd, TRAIN_MSG_ACCEPTED, PodToString(TrainJobAccepted{jobId, jobsAhead}));
+  std::cout << "Job " << jobId << ": context " << header.contextId << ", " << header.job.numIters
+            << " iterations, degree " << header.job.chebDegree << ", " << shards.size() << " shard(s), "
+            << jobsAhead << " ahead" << std::endl;
+
+  // The connection's thread waits for the job, so the worker is the only one reading and writing fd meanwhile
+  auto queued = std::chrono::high_resolution_clock::now();
+  auto future = daemon.pool->Submit([&]() {
+    TrainJobSummary summary{jobId, 0, 0, 0};
+    summary.queueSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - queued).count();
+    try {
+      auto onIteration = [&](const NagIteration &iteration, const CT &) {
+        TrainMetric metric{jobId, uint32_t(iteration.iteration), iteration.refreshed ? 1U : 0U,
+                           iteration.levelsBefore, iteration.chebDegree, iteration.ms, iteration.ctLoss ? 1U : 0U};
+        std::string message;
+        AppendBlob(message, PodToString(metric));
+        if (iteration.ctLoss) AppendBlob(message, SerializeToString(iteration.ctLoss));
+        SendFrame(fd, TRAIN_MSG_METRIC, message);
+      };
+      // Interactive jobs: the client holds the secret key, so it re-encrypts the weights
+      auto refresh = [&](const CT &ctWeights) {
+        // ctWeights repeats theta/phi with this period, as in lr_nag
+        usint period = 2 * ctx->rowSize;
+        std::string request(reinterpret_cast<const char *>(&period), sizeof(period));
+        request.append(SerializeToString(ctWeights));
+        SendFrame(fd, TRAIN_MSG_REFRESH, request);
+        uint32_t type;
+        std::string reply;
+        if (!RecvFrame(fd, type, reply) || type != TRAIN_MSG_REFRESHED) {
+          OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+              std::to_string(__LINE__) +
+              std::string("Error: the client did not return the refreshed weights"));
+        }
+        CT refreshed;
+        DeserializeFromString(refreshed, reply);
+        return refreshed;
+      };
+      auto result = TrainNag(*ctx, shards, header.job, daemon.threadsPerJob, onIteration, refresh);
+      summary.numRefreshes = result.numRefreshes;
+      summary.trainSeconds = result.seconds;
+      std::string reply;
+      AppendBlob(reply, PodToString(summary));
+      AppendBlob(reply, SerializeToString(result.ctTheta));
+      SendFrame(fd, TRAIN_MSG_WEIGHTS, reply);
+      std::cout << "Job " << jobId << " done: " << summary.trainSeconds << " s training, " << summary.queueSeconds
+                << " s queued, " << summary.numRefreshes << " refreshes" << std::endl;
+    } catch (const std::exception &e) {
+      std::cerr << "Job " << jobId << " failed: " << e.what() << std::endl;
+      try {
+        SendFrame(fd, TRAIN_MSG_ERROR, e.what());
+      } catch (const std::exception &) {
+        // the client is gone
+      }
+    }
+    daemon.jobsInFlight--;
+  });
+  future.wait();
+}
+
+static void ServeConnection(Daemon &daemon, int fd) {
+  uint32_t type;
+  std::string payload;
+  ClientContexts clientContexts;
+  bool serving = true;
+  try {
+    while (serving && RecvFrame(fd, type, payload)) {
+      try {
+        switch (type) {
+          case TRAIN_MSG_CONTEXT:HandleContext(daemon, fd, payload);
+            break;
+          case TRAIN_MSG_KEYS:HandleKeys(daemon, fd, payload, clientContexts);
+            break;
+          case TRAIN_MSG_USE_KEYS:HandleUseKeys(daemon, fd, payload, clientContexts);
+            break;
+          case TRAIN_MSG_RELEASE_KEYS:HandleReleaseKeys(daemon, fd, payload, clientContexts);
+            break;
+          case TRAIN_MSG_JOB:HandleJob(daemon, fd, payload, clientContexts);
+            break;
+          case TRAIN_MSG_SHUTDOWN:
+            if (!PeerIsSameUser(fd)) {
+              SendFrame(fd, TRAIN_MSG_ERROR, "SHUTDOWN is only accepted from the daemon's user");
+              break;
+            }
+            daemon.running = false;
+            // wake the accept loop up so it sees the flag
+            CloseSocket(ConnectUnixSocket(daemon.socketPath, 0));
+            serving = false;
+            break;
+          default:SendFrame(fd, TRAIN_MSG_ERROR, "unknown message type " + std::to_string(type));
+        }
+      } catch (const std::exception &e) {
+        std::cerr << "Error handling message " << type << ": " << e.what() << std::endl;
+        SendFrame(fd, TRAIN_MSG_ERROR, e.what());
+      }
+    }
+  } catch (const std::exception &e) {
+    // the client went away in the middle of a frame
+    std::cerr << "Connection error: " << e.what() << std::endl;
+  }
+  CloseSocket(fd);
+}
+
+int main(int argc, char *argv[]) {
+  Daemon daemon;
+  daemon.socketPath = SOCKET_PATH_DEF;
+  usint numWorkers = 1;
+  std::string chebTableFile = CHEB_TABLE_DEF;
+  ExecOptions execOptions;
+  // contexts to create before the first client connects
+  TrainingContextSpec warmSpec{false, RING_DIM_DEF, CHEBYSHEV_ESTIMATION_DEGREE, CHEBYSHEV_ESTIMATION_DEGREE, 1, 0,
+                               0};
+
+  int opt;
+  while ((opt = getopt(argc, argv, "s:W:C:f:bd:g:m:i:l:H:J:N:B:O:h")) != -1) {
+    switch (opt) {
+      case 's':daemon.socketPath = optarg;
+        break;
+      case 'W':numWorkers = atoi(optarg);
+        break;
+      case 'C':chebTableFile = optarg;
+        break;
+      case 'f':warmSpec.numFeatures = atoi(optarg);
+        break;
+      case 'b':warmSpec.withBT = true;
+        break;
+      case 'd':warmSpec.ringDim = atoi(optarg);
+        break;
+      case 'g':warmSpec.maxDegree = atoi(optarg);
+        break;
+      case 'm':warmSpec.minDegree = atoi(optarg);
+        break;
+      case 'i':warmSpec.itersPerRefresh = atoi(optarg);
+        break;
+      case 'l':warmSpec.lossDegree = atoi(optarg);
+        break;
+      case 'H':execOptions.threads = atoi(optarg);
+        break;
+      case 'J':execOptions.phaseThreads = optarg;
+        break;
+      case 'N':execOptions.nested = atoi(optarg);
+        break;
+      case 'B':execOptions.pin = optarg;
+        break;
+      case 'O':execOptions.numaNode = atoi(optarg);
+        break;
+      case 'h':
+      default:
+        std::cerr << "Usage: " << std::endl
+                  << "arguments:" << std::endl
+                  << "  -s <Unix socket path> [" << SOCKET_PATH_DEF << "]" << std::endl
+                  << "  -W <jobs trained concurrently; the OpenMP threads are split among them> [1]" << std::endl
+                  << "  -C <Chebyshev coefficient table shared with lr_nag> [" << CHEB_TABLE_DEF << "]" << std::endl
+                  << "  -f <features; creates a context for them at startup> [none]" << std::endl
+                  << "  -b the startup context bootstraps [false]" << std::endl
+                  << "  -d <ring dimension of the startup context> [" << RING_DIM_DEF << "]" << std::endl
+                  << "  -g <largest sigmoid degree of the startup context> [" << CHEBYSHEV_ESTIMATION_DEGREE << "]"
+                  << std::endl
+                  << "  -m <smallest sigmoid degree of the startup context> [" << CHEBYSHEV_ESTIMATION_DEGREE << "]"
+                  << std::endl
+                  << "  -i <NAG iterations per refresh of the startup context> [1]" << std::endl
+                  << "  -l <softplus degree of the encrypted loss the startup context makes room for, 0 = none> [0]"
+                  << std::endl
+                  << "  -H <OpenMP threads> [OpenMP's default]" << std::endl
+                  << "  -J <threads per phase, e.g. gradient=16 (see exec_config.h)> [-H]" << std::endl
+                  << "  -N <nested OpenMP regions inside OpenFHE, 0|1> [OpenMP's default]" << std::endl
+                  << "  -B <thread pinning: none, compact or spread> [none]" << std::endl
+                  << "  -O <run on this NUMA node only> [all]" << std::endl
+                  << "  -h prints this message" << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+  }
+  numWorkers = std::max(usint(1), numWorkers);
+  warmSpec.minDegree = std::min(warmSpec.minDegree, warmSpec.maxDegree);
+
+  // a client that disconnects mid-job must not take the daemon down with it
+  std::signal(SIGPIPE, SIG_IGN);
+
+  auto execConfig = ExecConfig::FromOptions(execOptions);
+  execConfig.Apply();
+  execConfig.Report(std::cout);
+  daemon.threadsPerJob = std::max(1, execConfig.ThreadsFor("gradient") / int(numWorkers));
+  daemon.pool.reset(new ThreadPool(numWorkers, daemon.threadsPerJob));
+  if (!chebTableFile.empty()) ChebyshevCache::Get().UseTable(chebTableFile);
+
+  if (warmSpec.numFeatures > 0) {
+    bool created;
+    double setupSeconds;
+    daemon.registry.Acquire(warmSpec, created, setupSeconds);
+  }
+
+  int listenFd = ListenUnixSocket(daemon.socketPath, 16);
+  std::cout << "Training daemon listening on " << daemon.socketPath << ", " << numWorkers << " worker(s) x "
+            << daemon.threadsPerJob << " thread(s)" << std::endl;
+
+  while (daemon.running) {
+    int fd = AcceptUnixSocket(listenFd);
+    if (!daemon.running) {
+      CloseSocket(fd);
+      break;
+    }
+    std::thread(ServeConnection, std::ref(daemon), fd).detach();
+  }
+  CloseSocket(listenFd);
+  unlink(daemon.socketPath.c_str());
+  std::cout << "Shutting down after the running jobs" << std::endl;
+  while (daemon.jobsInFlight > 0) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::cout << "Trained " << daemon.nextJobId << " job(s)" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -34,6 +34,9 @@
 #include "pt_matrix.h"
 #include "utils/debug.h"
 #include "enc_matrix.h"
+#include "he_tracer.h"
+#include "data_io.h"
+#include "cheb_cache.h"
 #include "math.h"
 
 ////////////////////////////////////////////////////////////////////////////
@@ -91,7 +94,10 @@ void EncLogRegCalculateGradient(
     int chebRangeStart,
     int chebRangeEnd,
     int chebPolyDegree,
-    int debugPlaintextLength
+    int debugPlaintextLength,
+    CT *ctLogitsOut,
+    SigmoidApprox sigmoidApprox,
+    double logitScale
 ) {
   OPENFHE_DEBUG_FLAG(false);
   // We use the same notation as in
@@ -99,6 +105,8 @@ void EncLogRegCalculateGradient(
   //    It seems like their labels are {-1, 1} which we do not use. Change accordingly
   CT ctLogits;
   PT dbg;
+  auto &tracer = HETracer::Get();
+  tracer.RecordStage("theta", ctThetas);
 
   if (debug) {
     cc->Decrypt(keys.secretKey, ctThetas, &dbg);
@@ -111,6 +119,8 @@ void EncLogRegCalculateGradient(
 
   // Line 4
   MatrixVectorProductRow(cc, keys, colKeys, ctX, ctThetas, rowSize, ctLogits);
+  tracer.RecordStage("logits", ctLogits);
+  if (ctLogitsOut) *ctLogitsOut = ctLogits;
   if (debug) {
     cc->Decrypt(keys.secretKey, ctLogits, &dbg);
     dbg->SetLength(debugPlaintextLength);
@@ -119,7 +129,9 @@ void EncLogRegCalculateGradient(
   }
 
   // Line 5/6
-  auto preds = cc->EvalLogistic(ctLogits, chebRangeStart, chebRangeEnd, chebPolyDegree);
+  auto preds = TracedEvalLogistic(cc, ctLogits, chebRangeStart, chebRangeEnd, chebPolyDegree, sigmoidApprox,
+                                  logitScale);
+  tracer.RecordStage("preds", preds);
   if (debug) {
     cc->Decrypt(keys.secretKey, preds, &dbg);
     dbg->SetLength(debugPlaintextLength);
@@ -129,7 +141,11 @@ void EncLogRegCalculateGradient(
 
   // Line 8 - see Page 9 for their notation
   OPENFHE_DEBUG("\tPre-Residual");
-  auto residual = cc->EvalSub(ctLabels, preds);
+  // y - preds, written over preds: the labels ciphertext is shared across iterations
+  CT residual = preds;
+  TracedEvalNegateInPlace(cc, residual);
+  TracedEvalAddInPlace(cc, residual, ctLabels);
+  tracer.RecordStage("residual", residual);
 
   if (debug) {
     cc->Decrypt(keys.secretKey, residual, &dbg);
@@ -139,6 +155,7 @@ void EncLogRegCalculateGradient(
   }
 
   MatrixVectorProductCol(cc, rowKeys, ctNegXt, residual, rowSize, ctGradStoreInto);
+  tracer.RecordStage("gradient", ctGradStoreInto);
 
   if (debug) {
     cc->Decrypt(keys.secretKey, ctGradStoreInto, &dbg);
@@ -173,14 +190,14 @@ PT ReEncrypt(CC &cc, CT &ctx, const KeyPair &keys) {
   // reencrypt x
   PT xPT;
   OPENFHE_DEBUG("Decrypt");
-  cc->Decrypt(keys.secretKey, ctx, &xPT);
+  TracedDecrypt(cc, keys, ctx, &xPT);
 
   Vec x = xPT->GetRealPackedValue();
 
   xPT = cc->MakeCKKSPackedPlaintext(x);
 
   OPENFHE_DEBUG("Encrypt() ");
-  ctx = cc->Encrypt(keys.publicKey, xPT);
+  ctx = TracedEncrypt(cc, keys, xPT);
   return xPT; //return this for debug purposes...
 }
 
@@ -244,3 +261,74 @@ double ComputeLoss(const Mat &b, const Mat &X, const Mat &y) {
   MatrixMatrixSub(t1Mat, t2Mat, loglikelihood);
   return loglikelihood[0][0] / double(numSamp);
 }
+
+double ComputeLossStreamed(const Mat &b, const std::string &xFile, const std::string &yFile, int rowsToRead) {
+  CsvRowReader xReader(xFile, rowsToRead);
+  CsvRowReader yReader(yFile, rowsToRead);
+  Vec xRow, yRow;
+  double loss = 0.0;
+  usint numSamp = 0;
+  while (xReader.Next(xRow) && yReader.Next(yRow)) {
+    double z = 0.0;
+    for (size_t j = 0; j < xRow.size() && j < b.size(); j++) {
+      z += xRow[j] * b[j][0];
+    }
+    double yHat = 1.0 / (1.0 + std::exp(-z));
+    loss += -yRow[0] * std::log(yHat) - (1.0 - yRow[0]) * std::log(1.0 - yHat);
+    numSamp++;
+  }
+  if (numSamp == 0) {
+    std::cerr << "No rows read from " << xFile << " and " << yFile << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return loss / numSamp;
+}
+
+static CT FinishPrediction(CC &cc, const CT &ctProduct, usint rowSize, const MatKeys &colKeys,
+                           int chebRangeStart, int chebRangeEnd, int chebPolyDegree, SigmoidApprox sigmoidApprox) {
+  auto ctLogits = TracedEvalSumCols(cc, ctProduct, rowSize, colKeys);
+  return TracedEvalLogistic(cc, ctLogits, chebRangeStart, chebRangeEnd, chebPolyDegree, sigmoidApprox);
+}
+
+CT EncLogRegPredict(CC &cc, const CT &ctX, const CT &ctTheta, usint rowSize, const MatKeys &colKeys,
+                    int chebRangeStart, int chebRangeEnd, int chebPolyDegree, SigmoidApprox sigmoidApprox) {
+  return FinishPrediction(cc, TracedEvalMult(cc, ctX, ctTheta), rowSize, colKeys,
+                          chebRangeStart, chebRangeEnd, chebPolyDegree, sigmoidApprox);
+}
+
+CT EncLogRegPredict(CC &cc, const CT &ctX, const PT &ptTheta, usint rowSize, const MatKeys &colKeys,
+                    int chebRangeStart, int chebRangeEnd, int chebPolyDegree, SigmoidApprox sigmoidApprox) {
+  return FinishPrediction(cc, TracedEvalMult(cc, ctX, ptTheta), rowSize, colKeys,
+                          chebRangeStart, chebRangeEnd, chebPolyDegree, sigmoidApprox);
+}
+
+void WritePredictions(const Mat &b, const std::string &xFile, int rowsToRead, const std::string &outFile) {
+  std::ofstream ofs(outFile);
+  if (!ofs) {
+    std::cerr << "Error writing " << outFile << std::endl;
+    return;
+  }
+  CsvRowReader xReader(xFile, rowsToRead);
+  Vec xRow;
+  usint row = 0;
+  while (xReader.Next(xRow)) {
+    double z = 0.0;
+    for (size_t j = 0; j < xRow.size() && j < b.size(); j++) {
+      z += xRow[j] * b[j][0];
+    }
+    ofs << row++ << ", " << 1.0 / (1.0 + std::exp(-z)) << std::endl;
+  }
+}
+
+CT EncLogRegLoss(CC &cc, const CT &ctLogits, const CT &ctLabels, const PT &ptRowMask, usint numSlots,
+                 int chebRangeStart, int chebRangeEnd, int chebPolyDegree, double logitScale) {
+  // softplus(z) / logitScale - y * z / logitScale, scaled back by the mask
+  std::vector<double> coefficients =
+      ChebyshevCache::Get().Coefficients("softplus", chebRangeStart, chebRangeEnd, chebPolyDegree);
+  for (auto &c : coefficients) c /= logitScale;
+  auto ctSoftplus = TracedEvalChebyshevSeries(cc, ctLogits, coefficients, chebRangeStart / logitScale,
+                                              chebRangeEnd / logitScale);
+  auto ctLabelLogits = TracedEvalMult(cc, ctLabels, ctLogits);
+  TracedEvalSubInPlace(cc, ctSoftplus, ctLabelLogits);
+  return TracedEvalSum(cc, TracedEvalMult(cc, ctSoftplus, ptRowMask), numSlots);
+}
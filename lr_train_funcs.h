@@ -34,6 +34,7 @@
 
 #include "lr_types.h"
 #include "openfhe.h"
+#include "cheb_cache.h"
 
 ////////// Function declarations related to logistic regression training on encrypted data ///////////////////////////////
 
@@ -66,6 +67,9 @@ Mat InitializeLogReg(Mat &X, Mat &y, float scalingFactor = 1.0);
  * @param colKeys           keys for col operations
  * @param keys              keys for enc/dec
  * @param withBT            whether to run bootstrapping
+ * @param ctLogitsOut       if set, receives the logits (for EncLogRegLoss)
+ * @param sigmoidApprox     which polynomial of degree chebPolyDegree stands in for the sigmoid
+ * @param logitScale        ctX holds X / logitScale, so the logits come out divided by it (see UsesPowerSeries)
  */
 void EncLogRegCalculateGradient(
     CC &cc,
@@ -82,9 +86,43 @@ void EncLogRegCalculateGradient(
     int chebRangeStart = -64,
     int chebRangeEnd = 64,
     int chebPolyDegree = 128,
-    int debugPlaintextLength=32
+    int debugPlaintextLength=32,
+    CT *ctLogitsOut = nullptr,
+    SigmoidApprox sigmoidApprox = SIGMOID_CHEBYSHEV,
+    double logitScale = 1.0
     );
 
+/**
+ * Encrypted cross-entropy loss contribution of one block of rows, from the logits z that
+ * EncLogRegCalculateGradient computes (pass ctLogitsOut): sum_i mask_i * (softplus(z_i) - y_i * z_i),
+ * with softplus approximated by a Chebyshev series over the sigmoid's range. The mask selects one slot
+ * per real row (padding rows would add softplus(0) = log 2 each) and carries the 1 / n scaling.
+ * The sum ends up in every slot.
+ * @param ctLabels          labels, VEC_COL_CLONED like the logits
+ * @param ptRowMask         1 / n in slot i * rowSize of every real row i, 0 elsewhere
+ * @param numSlots          batch size, for the final EvalSum
+ * @param logitScale        the logits are divided by it (see EncLogRegCalculateGradient); the softplus is then
+ *                          divided by it too, and ptRowMask has to carry logitScale / n instead
+ */
+CT EncLogRegLoss(CC &cc, const CT &ctLogits, const CT &ctLabels, const PT &ptRowMask, usint numSlots,
+                 int chebRangeStart, int chebRangeEnd, int chebPolyDegree, double logitScale = 1.0);
+
+/**
+ * Scores the rows of an encrypted feature matrix: sigmoid(X * theta), via MatrixVectorProductRow and
+ * EvalLogistic. The score of row i lands in slot i * rowSize.
+ * @param cc                Cryptocontext
+ * @param ctX               features, MAT_ROW_MAJOR (see Mat2CtMRM)
+ * @param theta             weights, VEC_ROW_CLONED with period rowSize; encrypted or plaintext
+ * @param rowSize           length of row of the feature matrix
+ * @param colKeys           keys for col operations
+ */
+CT EncLogRegPredict(CC &cc, const CT &ctX, const CT &ctTheta, usint rowSize, const MatKeys &colKeys,
+                    int chebRangeStart, int chebRangeEnd, int chebPolyDegree,
+                    SigmoidApprox sigmoidApprox = SIGMOID_CHEBYSHEV);
+CT EncLogRegPredict(CC &cc, const CT &ctX, const PT &ptTheta, usint rowSize, const MatKeys &colKeys,
+                    int chebRangeStart, int chebRangeEnd, int chebPolyDegree,
+                    SigmoidApprox sigmoidApprox = SIGMOID_CHEBYSHEV);
+
 ///////////////////////////////////////////////////////////////////////////////////////
 
 ////////////////////////////////////////////////////////////
@@ -104,4 +142,14 @@ int ReturnDepth(const CT &ct);
 // Formulation based off of: https://stackoverflow.com/a/47798689/18031872
 double ComputeLoss(const Mat &betas, const Mat &X, const Mat &y);
 
+///////////////////////////////////////////////////////////////
+// Same loss as ComputeLoss, reading X and y from their CSV files one row at a time
+// (up to rowsToRead rows; all of them if negative) instead of holding them in memory
+double ComputeLossStreamed(const Mat &betas, const std::string &xFile, const std::string &yFile, int rowsToRead);
+
+///////////////////////////////////////////////////////////////
+// Writes sigmoid(x * betas) for every row of xFile (up to rowsToRead rows; all of them if negative) to
+// outFile as "row, score" lines
+void WritePredictions(const Mat &betas, const std::string &xFile, int rowsToRead, const std::string &outFile);
+
 #endif //DPRIVE_ML__LR_TRAIN_FUNCS_H_
@@ -0,0 +1,143 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "mem_stats.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+ProcessMemory ReadProcessMemory() {
+  ProcessMemory mem{0, 0};
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (getline(status, line)) {
+    std::stringstream ss(line);
+    std::string key;
+    size_t kb;
+    ss >> key >> kb;
+    if (key == "VmRSS:") mem.rssBytes = kb * 1024;
+    if (key == "VmHWM:") mem.peakRssBytes = kb * 1024;
+  }
+  return mem;
+}
+
+static size_t PolyBytes(const lbcrypto::DCRTPoly &poly) {
+  return size_t(poly.GetNumOfElements()) * poly.GetRingDimension() * sizeof(lbcrypto::NativeInteger);
+}
+
+size_t CiphertextBytes(const CT &ct) {
+  if (!ct) return 0;
+  size_t bytes = 0;
+  for (auto &element : ct->GetElements()) bytes += PolyBytes(element);
+  return bytes;
+}
+
+size_t EvalKeyBytes(const lbcrypto::EvalKey<lbcrypto::DCRTPoly> &key) {
+  if (!key) return 0;
+  size_t bytes = 0;
+  for (auto &poly : key->GetAVector()) bytes += PolyBytes(poly);
+  for (auto &poly : key->GetBVector()) bytes += PolyBytes(poly);
+  return bytes;
+}
+
+size_t KeyMapBytes(const MatKeys &keyMap) {
+  if (!keyMap) return 0;
+  size_t bytes = 0;
+  for (auto &entry : *keyMap) bytes += EvalKeyBytes(entry.second);
+  return bytes;
+}
+
+size_t MatBytes(const Mat &mat) {
+  size_t bytes = mat.capacity() * sizeof(Vec);
+  for (auto &row : mat) bytes += row.capacity() * sizeof(double);
+  return bytes;
+}
+
+size_t EvalMultKeyBytes() {
+  size_t bytes = 0;
+  for (auto &entry : lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>::GetAllEvalMultKeys()) {
+    for (auto &key : entry.second) bytes += EvalKeyBytes(key);
+  }
+  return bytes;
+}
+
+size_t AutomorphismKeyBytes() {
+  size_t bytes = 0;
+  for (auto &entry : lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>::GetAllEvalAutomorphismKeys()) {
+    bytes += KeyMapBytes(entry.second);
+  }
+  return bytes;
+}
+
+void MemoryLedger::Set(const std::string &component, size_t bytes) {
+  for (auto &entry : components) {
+    if (entry.first == component) {
+      entry.second = bytes;
+      return;
+    }
+  }
+  components.emplace_back(component, bytes);
+}
+
+static std::string FormatBytes(size_t bytes) {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(1);
+  if (bytes >= (size_t(1) << 30)) {
+    ss << double(bytes) / (size_t(1) << 30) << " GiB";
+  } else {
+    ss << double(bytes) / (size_t(1) << 20) << " MiB";
+  }
+  return ss.str();
+}
+
+void MemoryLedger::Report(std::ostream &os, const std::string &stage) const {
+  auto mem = ReadProcessMemory();
+  size_t accounted = 0;
+  os << "\tMemory after " << stage << ": RSS " << FormatBytes(mem.rssBytes) << ", peak "
+     << FormatBytes(mem.peakRssBytes) << std::endl;
+  for (auto &entry : components) {
+    if (entry.second == 0) continue;
+    os << "\t\t" << std::left << std::setw(24) << entry.first << std::right << FormatBytes(entry.second) << std::endl;
+    accounted += entry.second;
+  }
+  os << "\t\t" << std::left << std::setw(24) << "other" << std::right
+     << FormatBytes(mem.rssBytes > accounted ? mem.rssBytes - accounted : 0) << std::endl;
+}
+
+void MemoryLedger::ReportLine(std::ostream &os) const {
+  auto mem = ReadProcessMemory();
+  os << "\tMemory: RSS " << FormatBytes(mem.rssBytes) << ", peak " << FormatBytes(mem.peakRssBytes);
+  for (auto &entry : components) {
+    if (entry.second == 0) continue;
+    os << ", " << entry.first << " " << FormatBytes(entry.second);
+  }
+  os << std::endl;
+}
@@ -0,0 +1,82 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__MEM_STATS_H_
+#define DPRIVE_ML__MEM_STATS_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "openfhe.h"
+#include "lr_types.h"
+
+////////// Memory footprint accounting ///////////////////////////////
+
+struct ProcessMemory {
+  size_t rssBytes;      // VmRSS
+  size_t peakRssBytes;  // VmHWM
+};
+
+// Current and peak resident set size of this process, from /proc/self/status (zeros if unavailable)
+ProcessMemory ReadProcessMemory();
+
+/* Estimated sizes: the RNS coefficients only (towers x ring dimension words per polynomial), which is
+ * what dominates; object headers and OpenFHE's per-tower bookkeeping are not counted.
+ */
+size_t CiphertextBytes(const CT &ct);
+size_t EvalKeyBytes(const lbcrypto::EvalKey<lbcrypto::DCRTPoly> &key);
+size_t KeyMapBytes(const MatKeys &keyMap);
+size_t MatBytes(const Mat &mat);
+
+// Relinearization keys registered with OpenFHE, across all contexts
+size_t EvalMultKeyBytes();
+
+// Rotation, EvalSum and bootstrapping automorphism keys registered with OpenFHE, across all contexts
+size_t AutomorphismKeyBytes();
+
+/* Named component sizes, reported next to the process RSS. Whatever the RSS holds beyond the
+ * listed components (bootstrapping precomputations, NTT tables, allocator slack) is shown as "other".
+ */
+class MemoryLedger {
+ public:
+  void Set(const std::string &component, size_t bytes);
+
+  // Full breakdown, for the setup stages
+  void Report(std::ostream &os, const std::string &stage) const;
+
+  // One line, for every iteration
+  void ReportLine(std::ostream &os) const;
+
+ private:
+  std::vector<std::pair<std::string, size_t>> components;
+};
+
+#endif //DPRIVE_ML__MEM_STATS_H_
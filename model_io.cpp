@@ -0,0 +1,199 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "model_io.h"
+#include <cerrno>
+#include <fstream>
+#include <sys/stat.h>
+#include "refresh_protocol.h"
+
+static std::string Path(const std::string &dir, const std::string &name) {
+  return dir + "/" + name;
+}
+
+static void ThrowIoError(const std::string &what) {
+  OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+      std::to_string(__LINE__) + std::string("Error: ") + what);
+}
+
+template <class T>
+static void WriteObject(const std::string &file, const T &obj) {
+  if (!lbcrypto::Serial::SerializeToFile(file, obj, lbcrypto::SerType::BINARY)) {
+    ThrowIoError("cannot write " + file);
+  }
+}
+
+template <class T>
+static void ReadObject(const std::string &file, T &obj) {
+  if (!lbcrypto::Serial::DeserializeFromFile(file, obj, lbcrypto::SerType::BINARY)) {
+    ThrowIoError("cannot read " + file);
+  }
+}
+
+void SaveEncryptedModel(const std::string &dir, const CC &cc, const KeyPair &keys, const CT &ctTheta,
+                        usint rowSize, usint numFeatures) {
+  if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    ThrowIoError("cannot create model directory " + dir);
+  }
+  WriteObject(Path(dir, "context.bin"), cc);
+  WriteObject(Path(dir, "public_key.bin"), keys.publicKey);
+  WriteObject(Path(dir, "secret_key.bin"), keys.secretKey);
+  WriteObject(Path(dir, "theta.bin"), ctTheta);
+  std::ofstream meta(Path(dir, "model.txt"));
+  meta << rowSize << " " << numFeatures << std::endl;
+  if (!meta) ThrowIoError("cannot write " + Path(dir, "model.txt"));
+}
+
+EncryptedModel LoadEncryptedModel(const std::string &dir) {
+  EncryptedModel model;
+  ReadObject(Path(dir, "context.bin"), model.cc);
+  ReadObject(Path(dir, "public_key.bin"), model.keys.publicKey);
+  ReadObject(Path(dir, "secret_key.bin"), model.keys.secretKey);
+  ReadObject(Path(dir, "theta.bin"), model.ctTheta);
+  std::ifstream meta(Path(dir, "model.txt"));
+  if (!(meta >> model.rowSize >> model.numFeatures)) ThrowIoError("cannot read " + Path(dir, "model.txt"));
+  return model;
+}
+
+void SaveSigmoidPolynomial(const std::string &dir, const SigmoidPolynomial &poly) {
+  std::ofstream os(Path(dir, "sigmoid.txt"));
+  os.precision(17);
+  os << int(poly.approx) << " " << poly.rangeStart << " " << poly.rangeEnd << " " << poly.degree;
+  for (auto c : poly.coefficients) os << " " << c;
+  os << std::endl;
+  if (!os) ThrowIoError("cannot write " + Path(dir, "sigmoid.txt"));
+}
+
+bool LoadSigmoidPolynomial(const std::string &dir, SigmoidPolynomial &poly) {
+  std::ifstream is(Path(dir, "sigmoid.txt"));
+  if (!is) return false;
+  int approx;
+  if (!(is >> approx >> poly.rangeStart >> poly.rangeEnd >> poly.degree)) {
+    ThrowIoError("cannot read " + Path(dir, "sigmoid.txt"));
+  }
+  poly.approx = SigmoidApprox(approx);
+  poly.coefficients.clear();
+  double c;
+  while (is >> c) poly.coefficients.push_back(c);
+  if (poly.coefficients.empty()) ThrowIoError("no coefficients in " + Path(dir, "sigmoid.txt"));
+  return true;
+}
+
+void SaveClientKeys(const std::string &dir, const CC &cc, const ClientKeys &keys) {
+  if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+    ThrowIoError("cannot create key directory " + dir);
+  }
+  WriteObject(Path(dir, "context.bin"), cc);
+  WriteObject(Path(dir, "public_key.bin"), keys.keys.publicKey);
+  WriteObject(Path(dir, "secret_key.bin"), keys.keys.secretKey);
+  std::ofstream evalOs(Path(dir, "eval_keys.bin"), std::ios::binary | std::ios::trunc);
+  evalOs.write(keys.evalKeys.data(), std::streamsize(keys.evalKeys.size()));
+  if (!evalOs) ThrowIoError("cannot write " + Path(dir, "eval_keys.bin"));
+  std::ofstream meta(Path(dir, "keys.txt"));
+  meta << keys.rowSize << " " << keys.numSlotsBoot << " " << (keys.withBT ? 1 : 0) << std::endl;
+  if (!meta) ThrowIoError("cannot write " + Path(dir, "keys.txt"));
+}
+
+bool LoadClientKeys(const std::string &dir, const CC &cc, usint rowSize, uint32_t numSlotsBoot, bool withBT,
+                    ClientKeys &keys) {
+  std::ifstream meta(Path(dir, "keys.txt"));
+  int savedBT;
+  if (!meta || !(meta >> keys.rowSize >> keys.numSlotsBoot >> savedBT)) return false;
+  keys.withBT = (savedBT != 0);
+  if (keys.rowSize != rowSize || keys.withBT != withBT || (withBT && keys.numSlotsBoot != numSlotsBoot)) {
+    return false;
+  }
+  // keys only work with the parameters they were generated for
+  CC savedCc;
+  ReadObject(Path(dir, "context.bin"), savedCc);
+  if (!(*savedCc == *cc)) return false;
+
+  ReadObject(Path(dir, "public_key.bin"), keys.keys.publicKey);
+  ReadObject(Path(dir, "secret_key.bin"), keys.keys.secretKey);
+  std::ifstream evalIs(Path(dir, "eval_keys.bin"), std::ios::binary);
+  if (!evalIs) ThrowIoError("cannot read " + Path(dir, "eval_keys.bin"));
+  keys.evalKeys.assign(std::istreambuf_iterator<char>(evalIs), std::istreambuf_iterator<char>());
+  return true;
+}
+
+Mat LoadWeightsCsv(const std::string &file) {
+  std::ifstream is(file);
+  if (!is) ThrowIoError("cannot read " + file);
+  std::string line, last;
+  while (getline(is, line)) {
+    if (!line.empty()) last = line;
+  }
+  if (last.empty()) ThrowIoError("no weights in " + file);
+
+  Mat weights;
+  std::stringstream ss(last);
+  std::string tok;
+  getline(ss, tok, ',');  // iteration
+  while (getline(ss, tok, ',')) {
+    if (!tok.empty()) weights.push_back(Vec(1, std::stod(tok)));
+  }
+  if (weights.empty()) ThrowIoError("no weights in " + file);
+  return weights;
+}
+
+void SaveFeatureSet(const std::string &file, const EncryptedFeatureSet &set) {
+  std::ofstream os(file, std::ios::binary);
+  uint64_t header[4] = {set.rowSize, set.rowsPerCt, set.numRows, set.cts.size()};
+  os.write(reinterpret_cast<const char *>(header), sizeof(header));
+  for (auto &ct : set.cts) {
+    std::string bytes = SerializeToString(ct);
+    uint64_t len = bytes.size();
+    os.write(reinterpret_cast<const char *>(&len), sizeof(len));
+    os.write(bytes.data(), bytes.size());
+  }
+  if (!os) ThrowIoError("cannot write " + file);
+}
+
+EncryptedFeatureSet LoadFeatureSet(const std::string &file) {
+  std::ifstream is(file, std::ios::binary);
+  uint64_t header[4];
+  if (!is.read(reinterpret_cast<char *>(header), sizeof(header))) ThrowIoError("cannot read " + file);
+
+  EncryptedFeatureSet set;
+  set.rowSize = header[0];
+  set.rowsPerCt = header[1];
+  set.numRows = header[2];
+  set.cts.resize(header[3]);
+  for (auto &ct : set.cts) {
+    uint64_t len;
+    std::string bytes;
+    if (!is.read(reinterpret_cast<char *>(&len), sizeof(len))) ThrowIoError("truncated " + file);
+    bytes.resize(len);
+    if (!is.read(&bytes[0], len)) ThrowIoError("truncated " + file);
+    DeserializeFromString(ct, bytes);
+  }
+  return set;
+}
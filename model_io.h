@@ -0,0 +1,118 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__MODEL_IO_H_
+#define DPRIVE_ML__MODEL_IO_H_
+
+#include <string>
+#include <vector>
+#include "openfhe.h"
+#include "cheb_cache.h"
+#include "lr_types.h"
+
+////////// Trained model and encrypted data set files, shared by lr_nag and lr_infer ///////////////////////////////
+
+/* An encrypted model directory (written by lr_nag -M) holds:
+ *   context.bin              the crypto context
+ *   public_key.bin           the key pair; lr_infer decrypts the scores, so the secret key is needed
+ *   secret_key.bin
+ *   theta.bin                theta, VEC_ROW_CLONED with period rowSize
+ *   model.txt                rowSize and the number of features
+ *   sigmoid.txt              optional: the polynomial that stood in for the sigmoid (see SigmoidPolynomial)
+ * Evaluation keys are not stored; they are regenerated from the secret key on load.
+ */
+struct EncryptedModel {
+  CC cc;
+  KeyPair keys;
+  CT ctTheta;
+  usint rowSize;
+  usint numFeatures;
+};
+
+void SaveEncryptedModel(const std::string &dir, const CC &cc, const KeyPair &keys, const CT &ctTheta,
+                        usint rowSize, usint numFeatures);
+EncryptedModel LoadEncryptedModel(const std::string &dir);
+
+/* The sigmoid polynomial a model was trained with, as Chebyshev coefficients over [rangeStart, rangeEnd].
+ * A least-squares fit towards the training set's logits exists nowhere else, so lr_infer takes it from here.
+ */
+struct SigmoidPolynomial {
+  SigmoidApprox approx;
+  double rangeStart;
+  double rangeEnd;
+  uint32_t degree;
+  std::vector<double> coefficients;
+};
+
+void SaveSigmoidPolynomial(const std::string &dir, const SigmoidPolynomial &poly);
+// False if the model directory has no sigmoid.txt (models saved before it was written)
+bool LoadSigmoidPolynomial(const std::string &dir, SigmoidPolynomial &poly);
+
+/* A client key directory (lr_train_client -K) holds the key pair a client trains with on a daemon context and
+ * the evaluation keys it uploads, so later jobs on the same context skip key generation:
+ *   context.bin              the crypto context the keys belong to
+ *   public_key.bin           the key pair
+ *   secret_key.bin
+ *   eval_keys.bin            the keys part of a KEYS message (see SerializeTrainingKeys), uploaded as is
+ *   keys.txt                 rowSize, numSlotsBoot and 1 if the bootstrapping keys are included
+ * The directory holds a secret key, so it is created readable by its owner only.
+ */
+struct ClientKeys {
+  KeyPair keys;
+  std::string evalKeys;
+  usint rowSize;
+  uint32_t numSlotsBoot;
+  bool withBT;
+};
+
+void SaveClientKeys(const std::string &dir, const CC &cc, const ClientKeys &keys);
+// False if dir holds no keys, or keys for another context, row size or bootstrapping setup
+bool LoadClientKeys(const std::string &dir, const CC &cc, usint rowSize, uint32_t numSlotsBoot, bool withBT,
+                    ClientKeys &keys);
+
+/* Reads the weights from the last row of a weights CSV written by lr_nag (iteration, w_0, ..., w_n-1)
+ * as a numFeatures x 1 Mat.
+ */
+Mat LoadWeightsCsv(const std::string &file);
+
+/* A feature matrix encrypted in MAT_ROW_MAJOR (see Mat2CtMRM) in ciphertexts of rowsPerCt rows each.
+ */
+struct EncryptedFeatureSet {
+  std::vector<CT> cts;
+  usint rowSize;
+  usint rowsPerCt;
+  usint numRows;
+};
+
+void SaveFeatureSet(const std::string &file, const EncryptedFeatureSet &set);
+EncryptedFeatureSet LoadFeatureSet(const std::string &file);
+
+#endif //DPRIVE_ML__MODEL_IO_H_
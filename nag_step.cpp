@@ -0,0 +1,98 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "nag_step.h"
+#include "he_tracer.h"
+
+void AddNagWeightMasks(PlaintextCache &masks, usint numSlots, usint rowSize) {
+  Vec thetaMask(numSlots, 0);
+  Vec phiMask(numSlots, 0);
+  for (usint i = 0; i < numSlots; i++) {
+    if ((i / rowSize) % 2 == 0) {
+      thetaMask[i] = 1;
+    } else {
+      phiMask[i] = 1;
+    }
+  }
+  masks.Add("theta_mask", thetaMask);
+  masks.Add("phi_mask", phiMask);
+}
+
+NagWeights UnpackNagWeights(const CC &cc, const CT &ctWeights, PlaintextCache &masks, int rowSize) {
+  NagWeights weights;
+  CT _ctTheta = TracedEvalMult(cc, ctWeights, masks.For("theta_mask", ctWeights));
+  // _ctTheta
+  //      - numFeaturesEnc of 0s, numFeaturesEnc of thetas repeating to fill in the entire CT
+  // | 0, 0, ..., 0, theta_0, theta_1, ..., theta_15, 0,| (repeated)
+  weights.theta = TracedEvalRotate(cc, _ctTheta, rowSize);  // | 0, theta, 0, theta ...|
+  TracedEvalAddInPlace(cc, weights.theta, _ctTheta);
+  // theta
+  // | theta_0, theta_1, ..., theta_15, theta_0, theta_1, ..., theta_15|
+
+  CT _ctPhi = TracedEvalMult(cc, ctWeights, masks.For("phi_mask", ctWeights)); // | 0, phi, 0, phi, ...|
+  // _ctPhi
+  //      - numFeaturesEnc of phis, numFeaturesEnc of 0s repeating to fill in the entire CT
+  // | phi_0, phi_1, ..., phi_15, 0, 0, ..., 0|
+  weights.phi = TracedEvalRotate(cc, _ctPhi, -rowSize);
+  TracedEvalAddInPlace(cc, weights.phi, _ctPhi);
+  // phi
+  // | phi_0, phi_1, ..., phi_15, phi_0, phi_1, ..., phi_15|
+  return weights;
+}
+
+NagWeights NagUpdate(const CC &cc, const NagWeights &weights, const CT &ctGradient, double eta, bool firstIteration) {
+  NagWeights updated;
+  auto ctPhiPrime = TracedEvalSub(cc,
+      weights.theta,
+      ctGradient
+  );
+
+  if (firstIteration) {
+    updated.theta = ctPhiPrime;
+  } else {
+    // eta * (phi' - phi) + phi', accumulated in the one new ciphertext
+    updated.theta = TracedEvalSub(cc, ctPhiPrime, weights.phi);
+    TracedEvalMultInPlace(cc, updated.theta, eta);
+    TracedEvalAddInPlace(cc, updated.theta, ctPhiPrime);
+  }
+  // Step 11
+  updated.phi = ctPhiPrime;
+  return updated;
+}
+
+CT PackNagWeights(const CC &cc, const NagWeights &weights, PlaintextCache &masks) {
+  // theta and phi can sit at different levels (phi skips the momentum multiplication). The masked
+  // products are new ciphertexts, the caller keeps using theta and phi.
+  CT ctWeights = TracedEvalMult(cc, weights.theta, masks.For("theta_mask", weights.theta));  // | theta, 0, theta, 0|
+  TracedEvalAddInPlace(cc, ctWeights,
+      TracedEvalMult(cc, weights.phi, masks.For("phi_mask", weights.phi)));                  // | 0, phi, 0, phi|
+  return ctWeights;
+}
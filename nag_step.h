@@ -0,0 +1,66 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__NAG_STEP_H_
+#define DPRIVE_ML__NAG_STEP_H_
+
+#include "openfhe.h"
+#include "lr_types.h"
+#include "pt_cache.h"
+
+////////// The NAG update on the packed weights ciphertext ///////////////////////////////
+
+/* The weights travel between iterations packed into one ciphertext: theta in the even blocks of rowSize
+ * slots and phi (the previous look-ahead point) in the odd ones, see collateOneDMats2CtVRC. Within an
+ * iteration both are cloned into every block.
+ */
+struct NagWeights {
+  CT theta;
+  CT phi;
+};
+
+// The "theta_mask" and "phi_mask" operands the functions below take from a PlaintextCache.
+void AddNagWeightMasks(PlaintextCache &masks, usint numSlots, usint rowSize);
+
+// Splits ctWeights into theta and phi, each repeated in every block. Uses one level.
+NagWeights UnpackNagWeights(const CC &cc, const CT &ctWeights, PlaintextCache &masks, int rowSize);
+
+/* phi' = theta - gradient, theta' = phi' + eta * (phi' - phi); returns {theta', phi'}. The first iteration
+ * has no previous step and takes theta' = phi'. Uses one level (none on the first iteration).
+ * Formulation based on https://eprint.iacr.org/2018/462.pdf, Algorithm 1
+ * and https://jlmelville.github.io/mize/nesterov.html
+ */
+NagWeights NagUpdate(const CC &cc, const NagWeights &weights, const CT &ctGradient, double eta, bool firstIteration);
+
+// Inverse of UnpackNagWeights. Uses one level.
+CT PackNagWeights(const CC &cc, const NagWeights &weights, PlaintextCache &masks);
+
+#endif //DPRIVE_ML__NAG_STEP_H_
@@ -0,0 +1,222 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "nag_trainer.h"
+#include "depth_plan.h"
+#include "he_tracer.h"
+#include "level_scheduler.h"
+#include "lr_train_funcs.h"
+#include "nag_step.h"
+#include "sigmoid_schedule.h"
+#include "utils.h"
+
+bool TrainingContextSpec::Serves(const TrainingContextSpec &other) const {
+  return withBT == other.withBT && ringDim == other.ringDim && itersPerRefresh == other.itersPerRefresh &&
+      NextPow2(numFeatures) == NextPow2(other.numFeatures) &&
+      minDegree <= other.minDegree && maxDegree >= other.maxDegree &&
+      (other.lossDegree == 0 || (lossDegree > 0 &&
+          EncryptedLossLevels(lossDegree) >= EncryptedLossLevels(other.lossDegree)));
+}
+
+// linear transform using 1 level is good for CKKS bootstrapping as the number of features is small
+static const std::vector<uint32_t> BOOTSTRAP_LEVEL_BUDGET = {2, 2};
+static const std::vector<uint32_t> BOOTSTRAP_BSGS_DIM = {0, 0};
+
+std::shared_ptr<TrainingContext> MakeTrainingContext(const TrainingContextSpec &spec, bool generateKeys) {
+  auto ctx = std::make_shared<TrainingContext>();
+  ctx->spec = spec;
+  usint itersPerRefresh = std::max(usint(1), spec.itersPerRefresh);
+
+#if NATIVEINT == 128
+  uint32_t firstModSize = 89;
+  uint32_t dcrtBits = 78;
+#else
+  uint32_t firstModSize = 60;
+  uint32_t dcrtBits = 59;
+#endif
+  lbcrypto::SecretKeyDist skDist = lbcrypto::UNIFORM_TERNARY;
+  uint32_t approxBootstrapDepth = 8;
+
+  // same accounting as lr_nag: the cycle at maxDegree or the encrypted loss after a refresh, whichever is deeper
+  TrainingDepth trainingDepth = PlanTrainingDepth(
+      TrainingVariant{spec.maxDegree, spec.maxDegree, itersPerRefresh, spec.lossDegree});
+  if (!trainingDepth.supported) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: no depth plan for sigmoid degree ") + std::to_string(spec.maxDegree) +
+        " and softplus degree " + std::to_string(spec.lossDegree));
+  }
+  uint32_t levelsBeforeBootstrap = trainingDepth.requiredLevels + BOOTSTRAP_HEADROOM_LEVELS;
+  ctx->levelMargin = 0;
+#if NATIVEINT == 64
+  levelsBeforeBootstrap += NATIVE64_BOOTSTRAP_LEVELS;
+  ctx->levelMargin = spec.withBT ? 1 : 0;
+#endif
+  ctx->multDepth = spec.withBT ? levelsBeforeBootstrap + lbcrypto::FHECKKSRNS::GetBootstrapDepth(
+      approxBootstrapDepth, BOOTSTRAP_LEVEL_BUDGET, skDist) : trainingDepth.requiredLevels;
+  ctx->levelsAfterRefresh = spec.withBT ? levelsBeforeBootstrap : ctx->multDepth;
+  ctx->numSlotsBoot = NextPow2(spec.numFeatures) * 8;
+
+  CryptoParams parameters;
+  parameters.SetMultiplicativeDepth(ctx->multDepth);
+  parameters.SetScalingModSize(dcrtBits);
+  parameters.SetFirstModSize(firstModSize);
+  parameters.SetBatchSize(spec.ringDim / 2);
+  parameters.SetSecurityLevel(lbcrypto::HEStd_128_classic);
+  parameters.SetRingDim(spec.ringDim);
+  parameters.SetScalingTechnique(lbcrypto::FIXEDAUTO);
+  parameters.SetKeySwitchTechnique(lbcrypto::HYBRID);
+  if (spec.withBT) parameters.SetSecretKeyDist(skDist);
+
+  CC &cc = ctx->cc;
+  cc = GenCryptoContext(parameters);
+  cc->Enable(lbcrypto::PKE);
+  cc->Enable(lbcrypto::LEVELEDSHE);
+  cc->Enable(lbcrypto::ADVANCEDSHE);
+
+  ctx->numSlots = cc->GetEncodingParams()->GetBatchSize();
+  ctx->rowSize = NextPow2(spec.numFeatures);
+  ctx->masks = std::make_shared<PlaintextCache>(cc);
+  AddNagWeightMasks(*ctx->masks, ctx->numSlots, ctx->rowSize);
+  SetupTrainingBootstrap(*ctx);
+  if (generateKeys) GenerateTrainingKeys(*ctx);
+  ctx->dataLevels = GradientDataLevels(ctx->RefreshLevel(), spec.minDegree, spec.minDegree);
+  return ctx;
+}
+
+void SetupTrainingBootstrap(TrainingContext &ctx) {
+  if (!ctx.spec.withBT) return;
+  ctx.cc->Enable(lbcrypto::FHE);
+  ctx.cc->EvalBootstrapSetup(BOOTSTRAP_LEVEL_BUDGET, BOOTSTRAP_BSGS_DIM, ctx.numSlotsBoot);
+}
+
+void GenerateTrainingKeys(TrainingContext &ctx) {
+  CC &cc = ctx.cc;
+  ctx.keys = cc->KeyGen();
+  cc->EvalMultKeyGen(ctx.keys.secretKey);
+  cc->EvalSumKeyGen(ctx.keys.secretKey);
+  int signedRowSize = int(ctx.rowSize);
+  cc->EvalRotateKeyGen(ctx.keys.secretKey, {-signedRowSize, signedRowSize});
+  ctx.rowKeys = cc->EvalSumRowsKeyGen(ctx.keys.secretKey, nullptr, ctx.rowSize);
+  ctx.colKeys = cc->EvalSumColsKeyGen(ctx.keys.secretKey);
+  if (ctx.spec.withBT) cc->EvalBootstrapKeyGen(ctx.keys.secretKey, ctx.numSlotsBoot);
+}
+
+NagJobResult TrainNag(
+    const TrainingContext &ctx,
+    const std::vector<DataShard> &shards,
+    const NagJob &job,
+    int threads,
+    const std::function<void(const NagIteration &, const CT &)> &onIteration,
+    const std::function<CT(const CT &)> &refresh
+) {
+  if (job.chebDegree < ctx.spec.minDegree || job.chebDegree > ctx.spec.maxDegree) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: sigmoid degree ") + std::to_string(job.chebDegree) + " is outside the context's [" +
+        std::to_string(ctx.spec.minDegree) + ", " + std::to_string(ctx.spec.maxDegree) + "]");
+  }
+  if (!ctx.spec.withBT && !refresh && !ctx.keys.secretKey) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: interactive training without the secret key needs a refresh callback"));
+  }
+  if (job.encLossEvery > 0 && (ctx.spec.lossDegree == 0 ||
+      EncryptedLossLevels(job.lossDegree) > EncryptedLossLevels(ctx.spec.lossDegree))) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: the context has no room for a degree ") + std::to_string(job.lossDegree) +
+        " encrypted loss");
+  }
+  CC cc = ctx.cc;
+  auto sigmoidSchedule = SigmoidSchedule::Fixed(job.chebDegree, job.chebRangeStart, job.chebRangeEnd);
+  LevelScheduler scheduler(ctx.multDepth, ctx.levelsAfterRefresh, sigmoidSchedule, ctx.spec.maxDegree,
+                           ctx.levelMargin);
+  ShardedGradientEngine gradientEngine(cc, shards, ctx.rowSize, ctx.rowKeys, ctx.colKeys, ctx.keys,
+                                       SplitThreads(shards.size(), 0, threads));
+
+  Mat beta(ctx.rowSize, Vec(1, 0.0));
+  CT ctWeights = collateOneDMats2CtVRC(cc, beta, beta, ctx.rowSize, ctx.numSlots, ctx.keys, ctx.RefreshLevel());
+  NagWeights nagWeights;
+  CT ctGradient;
+  NagJobResult result{nullptr, 0, 0};
+  bool encLossPending = false;
+
+  TimeVar t;
+  for (usint epochI = 0; epochI < job.numIters; epochI++) {
+    TIC(t);
+    // the loss of the last iteration cannot be deferred, so its weights are refreshed if it would not fit
+    bool lastLoss = job.encLossEvery > 0 && epochI + 1 == job.numIters;
+    auto schedule = scheduler.Next(ctWeights, epochI, job.numIters,
+                                   lastLoss ? LogitsPipeline::levels + EncryptedLossLevels(job.lossDegree) : 0);
+    if (schedule.refresh && ctx.spec.withBT) {
+      ctWeights->SetSlots(ctx.numSlotsBoot);
+#if NATIVEINT == 128
+      ctWeights = TracedEvalBootstrap(cc, ctWeights);
+#else
+      ctWeights = (job.btPrecision > 0) ? TracedEvalBootstrap(cc, ctWeights, 2, job.btPrecision)
+                                        : TracedEvalBootstrap(cc, ctWeights);
+#endif
+    } else if (schedule.refresh && refresh) {
+      ctWeights = refresh(ctWeights);
+    } else if (schedule.refresh) {
+      ReEncrypt(cc, ctWeights, ctx.keys);
+    }
+
+    NagIteration info{epochI, schedule.refresh, schedule.levelsBefore, schedule.chebDegree, 0, nullptr};
+    nagWeights = UnpackNagWeights(cc, ctWeights, *ctx.masks, int(ctx.rowSize));
+    bool encLossDue = job.encLossEvery > 0 &&
+        (encLossPending || epochI % job.encLossEvery == 0 || epochI + 1 == job.numIters);
+    gradientEngine.CalculateGradient(nagWeights.theta, ctGradient, schedule.chebRangeStart, schedule.chebRangeEnd,
+                                     schedule.chebDegree, encLossDue);
+    if (encLossDue) {
+      // same deferral as lr_nag: the logits of a late iteration in a cycle may be too deep for the softplus
+      bool fits = scheduler.RemainingLevels(gradientEngine.Logits(0)) >= EncryptedLossLevels(job.lossDegree);
+      if (fits) {
+        info.ctLoss = gradientEngine.CalculateLoss(job.numSamples, job.chebRangeStart, job.chebRangeEnd,
+                                                   job.lossDegree);
+      } else if (lastLoss) {
+        std::cerr << "Encrypted loss of the last iteration skipped: " << EncryptedLossLevels(job.lossDegree)
+                  << " levels needed after the logits" << std::endl;
+      }
+      encLossPending = !fits && !lastLoss;
+    }
+    nagWeights = NagUpdate(cc, nagWeights, ctGradient, job.eta, epochI == 0);
+    ctWeights = PackNagWeights(cc, nagWeights, *ctx.masks);
+
+    info.ms = TOC(t);
+    result.seconds += info.ms / 1000.0;
+    if (onIteration) onIteration(info, nagWeights.theta);
+    result.ctTheta = nagWeights.theta;
+  }
+  result.numRefreshes = scheduler.NumRefreshes();
+  return result;
+}
@@ -0,0 +1,142 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__NAG_TRAINER_H_
+#define DPRIVE_ML__NAG_TRAINER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "openfhe.h"
+#include "lr_types.h"
+#include "param_planner.h"
+#include "pt_cache.h"
+#include "shard_engine.h"
+
+////////// NAG training on a context that outlives a single training run ///////////////////////////////
+
+/* What a training context is sized for. The depth covers a refresh cycle at maxDegree and, with lossDegree,
+ * the softplus of the encrypted loss after a refresh (see PlanTrainingDepth); the data is encrypted at the
+ * levels minDegree consumes it at (see GradientDataLevels), so jobs on the context may use any degree in
+ * [minDegree, maxDegree]. numFeatures fixes the row size and with it the rotation keys and the weight masks.
+ * Plain data only, so it can be sent as is over a local socket.
+ */
+struct TrainingContextSpec {
+  bool withBT;
+  uint32_t ringDim;
+  uint32_t maxDegree;
+  uint32_t minDegree;
+  usint itersPerRefresh;
+  usint numFeatures;
+  uint32_t lossDegree;  // softplus degree of the encrypted loss, 0: no encrypted loss
+
+  // True if jobs planned for other can run on a context made for this spec
+  bool Serves(const TrainingContextSpec &other) const;
+};
+
+/* A crypto context with every key a NAG training needs: relinearization, EvalSum, the +-rowSize
+ * rotations, EvalSumRows/Cols and, with withBT, the bootstrapping precomputations and keys. Trainings
+ * only read it, so several may run on it at once. A context made without keys (see MakeTrainingContext)
+ * gets the public and evaluation keys of whoever holds the secret key; keys.secretKey then stays empty.
+ */
+struct TrainingContext {
+  TrainingContextSpec spec;
+  CC cc;
+  KeyPair keys;
+  MatKeys rowKeys;
+  MatKeys colKeys;
+  std::shared_ptr<PlaintextCache> masks;  // the NAG weight masks, encoded per level as the trainings reach it
+  usint rowSize;
+  usint numSlots;
+  uint32_t multDepth;
+  uint32_t levelsAfterRefresh;
+  uint32_t levelMargin;
+  uint32_t numSlotsBoot;
+  DataLevels dataLevels;
+
+  uint32_t RefreshLevel() const { return multDepth - levelsAfterRefresh; }
+};
+
+/* Same parameters and depth accounting as lr_nag without -a: 128-bit classic security, FIXEDAUTO,
+ * HYBRID key switching, level budget {2, 2}, every iteration of a refresh cycle at maxDegree.
+ */
+std::shared_ptr<TrainingContext> MakeTrainingContext(const TrainingContextSpec &spec, bool generateKeys = true);
+
+// With spec.withBT: enables FHE and runs the bootstrapping precomputations for ctx.numSlotsBoot
+void SetupTrainingBootstrap(TrainingContext &ctx);
+
+/* Generates ctx.keys and every evaluation key a training on ctx needs. With spec.withBT, the bootstrapping
+ * keys as well, which needs SetupTrainingBootstrap first.
+ */
+void GenerateTrainingKeys(TrainingContext &ctx);
+
+struct NagJob {
+  float eta;
+  usint numIters;
+  uint32_t chebDegree;
+  int chebRangeStart;
+  int chebRangeEnd;
+  int btPrecision;       // 64-bit only: > 0 runs double bootstrapping at this precision
+  usint numSamples;      // real rows, for the 1 / n of the encrypted loss
+  usint encLossEvery;    // 0: no encrypted loss
+  uint32_t lossDegree;   // softplus degree of the encrypted loss
+};
+
+struct NagIteration {
+  usint iteration;
+  bool refreshed;
+  uint32_t levelsBefore;
+  uint32_t chebDegree;
+  double ms;
+  CT ctLoss;  // mean cross-entropy of the weights the iteration started from; only set when computed
+};
+
+struct NagJobResult {
+  CT ctTheta;
+  usint numRefreshes;
+  double seconds;
+};
+
+/* Runs job.numIters NAG iterations from theta = 0 on the encrypted shards (X, -gamma X' / n and y at
+ * ctx.dataLevels, see EncryptShards). The shard gradients are spread over threads OpenMP threads.
+ * onIteration, if set, is called after every iteration with the updated theta. Without spec.withBT, refresh
+ * re-encrypts the weights; if it is not set, they are re-encrypted with the context's secret key.
+ */
+NagJobResult TrainNag(
+    const TrainingContext &ctx,
+    const std::vector<DataShard> &shards,
+    const NagJob &job,
+    int threads,
+    const std::function<void(const NagIteration &, const CT &)> &onIteration = nullptr,
+    const std::function<CT(const CT &)> &refresh = nullptr
+);
+
+#endif //DPRIVE_ML__NAG_TRAINER_H_
@@ -0,0 +1,212 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "packing_planner.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include "data_io.h"
+#include "utils.h"
+
+OpCostModel::OpCostModel() {
+  // Rough relative costs at a fixed ring dimension and depth: a relinearized mult is a key switch plus the
+  // tensor product, plaintext mults and adds are a pass over the towers
+  relative.fill(0.0);
+  relative[OP_EVAL_ROTATE] = 1.0;
+  relative[OP_KEY_SWITCH] = 1.0;
+  relative[OP_EVAL_MULT] = 1.2;
+  relative[OP_EVAL_MULT_PT] = 0.1;
+  relative[OP_EVAL_MULT_CONST] = 0.05;
+  relative[OP_EVAL_ADD] = 0.02;
+  relative[OP_EVAL_SUB] = 0.02;
+  relative[OP_EVAL_NEGATE] = 0.01;
+}
+
+bool OpCostModel::Calibrate(const std::string &benchFile) {
+  static const std::map<std::string, HEOp> kernels = {
+      {"EvalRotate", OP_EVAL_ROTATE}, {"EvalMult", OP_EVAL_MULT}, {"EvalMultPlain", OP_EVAL_MULT_PT},
+      {"EvalAdd", OP_EVAL_ADD}};
+  std::ifstream ifs(benchFile);
+  if (!ifs.is_open()) {
+    std::cerr << "Could not open benchmark results " << benchFile << std::endl;
+    return false;
+  }
+  std::string line;
+  while (getline(ifs, line)) {
+    if (line.find("\"kernel\"") == std::string::npos || JsonField(line, "scaling") != "fixed") continue;
+    auto op = kernels.find(JsonField(line, "kernel"));
+    if (op == kernels.end()) continue;
+    uint32_t ringDim = std::stoul(JsonField(line, "ringDim"));
+    int threads = std::stoi(JsonField(line, "threads"));
+    timed[ringDim][op->second][threads] = std::stod(JsonField(line, "median_ms"));
+  }
+  return Calibrated();
+}
+
+double OpCostModel::Cost(HEOp op, int threads, uint32_t ringDim) const {
+  if (relative[op] == 0) return 0;
+  if (timed.empty()) return relative[op] / std::max(threads, 1);
+
+  // nearest timed ring dimension (in log scale), costs scale linearly with it
+  auto nearest = timed.begin();
+  for (auto it = timed.begin(); it != timed.end(); it++) {
+    if (std::abs(std::log2(double(it->first) / ringDim)) < std::abs(std::log2(double(nearest->first) / ringDim))) {
+      nearest = it;
+    }
+  }
+  double scale = double(ringDim) / nearest->first;
+  auto found = nearest->second.find(op);
+  if (found == nearest->second.end()) {
+    // not timed: relative to whatever op was
+    HEOp timedOp = HEOp(nearest->second.begin()->first);
+    return Cost(timedOp, threads, ringDim) * relative[op] / relative[timedOp];
+  }
+  // the most threads timed that do not exceed threads; below the fewest timed, assume linear scaling
+  auto &byThreads = found->second;
+  auto it = byThreads.upper_bound(threads);
+  if (it == byThreads.begin()) return it->second * scale * it->first / std::max(threads, 1);
+  return std::prev(it)->second * scale;
+}
+
+double OpCostModel::Cost(const OpCounts &counts, int threads, uint32_t ringDim) const {
+  double cost = 0;
+  for (int op = 0; op < NUM_HE_OPS; op++) {
+    if (counts[op] > 0) cost += counts[op] * Cost(HEOp(op), threads, ringDim);
+  }
+  return cost;
+}
+
+uint32_t ChebyshevMultCount(uint32_t degree) {
+  if (degree <= 5) return degree;
+  // baby steps T_1..T_k, giant steps T_k, T_2k, T_4k, ... and one mult per giant-step combination
+  uint32_t babySteps = uint32_t(std::ceil(std::sqrt(double(degree) / 2)));
+  uint32_t giantSteps = uint32_t(std::ceil(std::log2(double(degree) / babySteps)));
+  return babySteps + giantSteps + (degree / babySteps);
+}
+
+OpCounts GradientOpCounts(uint32_t batchSize, usint rowSize, uint32_t chebDegree) {
+  uint32_t logBatch = uint32_t(std::log2(double(batchSize)));
+  uint32_t logRow = uint32_t(std::log2(double(rowSize)));
+  OpCounts counts{};
+  // MatrixVectorProductRow
+  counts[OP_EVAL_MULT] += 1;
+  counts[OP_EVAL_ROTATE] += logBatch + logRow;
+  counts[OP_EVAL_ADD] += logBatch + logRow;
+  counts[OP_EVAL_MULT_PT] += 1;
+  // EvalLogistic, then the residual labels - preds (negation and addition in place)
+  counts[OP_EVAL_MULT] += ChebyshevMultCount(chebDegree);
+  counts[OP_EVAL_MULT_CONST] += chebDegree + 1;
+  counts[OP_EVAL_ADD] += chebDegree + 2;
+  counts[OP_EVAL_NEGATE] += 1;
+  // MatrixVectorProductCol
+  counts[OP_EVAL_MULT] += 1;
+  counts[OP_EVAL_ROTATE] += logBatch - logRow;
+  counts[OP_EVAL_ADD] += logBatch - logRow;
+  return counts;
+}
+
+PackingPlan PlanPacking(const PackingInput &input, const OpCostModel &costs) {
+  usint rowSize = NextPow2(input.numFeatures);
+  uint32_t fullBatch = input.ringDim / 2;
+  uint32_t minBatch = std::max(NextPow2(std::max(input.minBatchSize, 1u)), 2 * rowSize);
+  int threads = std::max(1, input.threads);
+  if (minBatch > fullBatch) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: ring dimension ") + std::to_string(input.ringDim) + " cannot hold " +
+        std::to_string(minBatch) + " slots");
+  }
+
+  // unpack, NAG update and repack of the weights, once per iteration whatever the layout
+  OpCounts nagStep{};
+  nagStep[OP_EVAL_ROTATE] = 2;
+  nagStep[OP_EVAL_MULT_PT] = 4;
+  nagStep[OP_EVAL_MULT_CONST] = 1;
+  nagStep[OP_EVAL_ADD] = 4;
+  nagStep[OP_EVAL_SUB] = 2;
+
+  PackingPlan best{};
+  std::vector<std::string> why;
+  for (uint32_t batchSize = minBatch; batchSize <= fullBatch; batchSize *= 2) {
+    usint capacity = batchSize / rowSize;
+    usint rowsPerShard = (input.maxRowsPerShard > 0) ? std::min(capacity, input.maxRowsPerShard) : capacity;
+    rowsPerShard = std::min(rowsPerShard, std::max(input.numSamples, usint(1)));
+    usint numShards = (input.numSamples + rowsPerShard - 1) / rowsPerShard;
+    numShards = std::max(numShards, usint(1));
+    usint workers = (input.maxShardWorkers > 0) ? input.maxShardWorkers : usint(threads);
+    workers = std::max(usint(1), std::min(workers, numShards));
+    int innerThreads = std::max(1, threads / int(workers));
+    usint rounds = (numShards + workers - 1) / workers;
+
+    OpCounts serial = nagStep;
+    serial[OP_EVAL_ADD] += numShards - 1;  // the shard gradients' tree sum
+    double cost = rounds * costs.Cost(GradientOpCounts(batchSize, rowSize, input.chebDegree), innerThreads,
+                                      input.ringDim)
+        + costs.Cost(serial, threads, input.ringDim);
+
+    std::ostringstream line;
+    line << "batch " << batchSize << ": " << numShards << " ciphertext(s) of " << rowsPerShard << " rows, "
+         << workers << " worker(s) x " << innerThreads << " thread(s), cost " << cost;
+    why.push_back(line.str());
+
+    if (best.batchSize == 0 || cost < best.iterationCost) {
+      uint32_t logBatch = uint32_t(std::log2(double(batchSize)));
+      uint32_t logRow = uint32_t(std::log2(double(rowSize)));
+      best.batchSize = batchSize;
+      best.rowSize = rowSize;
+      best.rowsPerShard = rowsPerShard;
+      best.numShards = numShards;
+      best.shardWorkers = workers;
+      best.replication = fullBatch / batchSize;
+      best.numRotationKeys = 2 * logBatch + (logBatch - logRow) + logRow + 2;
+      best.iterationCost = cost;
+      best.layout = (numShards > 1) ? "sharded" : "single";
+    }
+  }
+  best.calibrated = costs.Calibrated();
+  best.reasoning = why;
+  best.reasoning.push_back("chose batch " + std::to_string(best.batchSize) + " (" + best.layout + ")" +
+      (best.calibrated ? "" : ", uncalibrated relative costs"));
+  return best;
+}
+
+void PrintPackingPlan(std::ostream &os, const PackingPlan &plan) {
+  os << "Packing plan:" << std::endl;
+  for (auto &line : plan.reasoning) {
+    os << "\t" << line << std::endl;
+  }
+  os << "\tBatch size: " << plan.batchSize << " (" << plan.replication << "x replicated in the ring)" << std::endl;
+  os << "\tLayout: " << plan.layout << ", " << plan.numShards << " x " << plan.rowsPerShard << " rows of "
+     << plan.rowSize << " slots, " << plan.shardWorkers << " shard worker(s)" << std::endl;
+  os << "\tRotation keys: ~" << plan.numRotationKeys << std::endl;
+  os << "\tModelled iteration cost: " << plan.iterationCost << (plan.calibrated ? " ms" : " (relative)")
+     << std::endl;
+}
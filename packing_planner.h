@@ -0,0 +1,119 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__PACKING_PLANNER_H_
+#define DPRIVE_ML__PACKING_PLANNER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include "he_tracer.h"
+#include "lr_types.h"
+
+////////// Batch size and data layout planning from an operation-cost model ///////////////////////////////
+
+/* Cost of one homomorphic operation (of the basic HEOps; composite ones are expanded by the callers) per
+ * OpenMP thread count. Uncalibrated, the costs are relative to a rotation and scale linearly with the thread
+ * count. Calibrate reads the EvalRotate, EvalMult, EvalMultPlain and EvalAdd medians of a bench_lr result file
+ * (fixed scaling); they are scaled linearly to the ring dimension asked for from the nearest one timed, and
+ * the remaining basic ops are priced relative to them.
+ */
+class OpCostModel {
+ public:
+  OpCostModel();
+
+  // Returns false (and stays uncalibrated) if the file holds none of the four kernels
+  bool Calibrate(const std::string &benchFile);
+  bool Calibrated() const { return !timed.empty(); }
+
+  // ms of one op (relative units when uncalibrated) with that many threads at ringDim
+  double Cost(HEOp op, int threads, uint32_t ringDim) const;
+
+  // sum over the counted ops
+  double Cost(const OpCounts &counts, int threads, uint32_t ringDim) const;
+
+ private:
+  std::array<double, NUM_HE_OPS> relative;
+  // ring dimension -> op -> threads -> median ms
+  std::map<uint32_t, std::map<int, std::map<int, double>>> timed;
+};
+
+/* Operations of one shard's gradient (EncLogRegCalculateGradient) with the data packed row major into
+ * batchSize slots of rows of rowSize:
+ *   MatrixVectorProductRow   1 mult; EvalSumCols: log2(batchSize) rotations, 1 masking plaintext mult,
+ *                            log2(rowSize) rotations to clone the sums back
+ *   EvalLogistic             ChebyshevMultCount(degree) mults, a scalar mult and add per coefficient
+ *   MatrixVectorProductCol   1 mult; EvalSumRows: log2(batchSize / rowSize) rotations
+ * with an add per rotation, counted the way HETracer counts them. The EvalSum rotations are the part that
+ * grows with the batch size.
+ */
+OpCounts GradientOpCounts(uint32_t batchSize, usint rowSize, uint32_t chebDegree);
+
+// Ciphertext multiplications of the Paterson-Stockmeyer Chebyshev evaluation (estimate)
+uint32_t ChebyshevMultCount(uint32_t degree);
+
+struct PackingInput {
+  usint numSamples;
+  usint numFeatures;
+  uint32_t ringDim;
+  uint32_t chebDegree;
+  uint32_t minBatchSize;    // e.g. the sparse bootstrapping slot count
+  usint maxRowsPerShard;    // from -S, 0 = no limit
+  usint maxShardWorkers;    // from -W, 0 = one per shard
+  int threads;              // OpenMP threads for the gradient
+};
+
+/* The layouts the kernels implement: all rows in one ciphertext ("single"), or the rows split across
+ * several ciphertexts ("sharded") whose gradients run concurrently, see ShardedGradientEngine.
+ */
+struct PackingPlan {
+  uint32_t batchSize;
+  usint rowSize;
+  usint rowsPerShard;        // rows per data ciphertext
+  usint numShards;
+  usint shardWorkers;
+  uint32_t replication;      // copies of the batch in the ring's ringDim / 2 slots
+  uint32_t numRotationKeys;  // EvalSum, EvalSumRows/Cols and the +-rowSize rotations
+  double iterationCost;      // modelled gradient + NAG update time, ms (relative units uncalibrated)
+  bool calibrated;
+  std::string layout;
+  std::vector<std::string> reasoning;
+};
+
+/* Tries every power-of-two batch size from the smallest that holds two blocks of rowSize slots (and
+ * minBatchSize) up to ringDim / 2, with as many shards as the rows need at that size, and keeps the one
+ * with the lowest modelled iteration time. Ties go to the smaller batch size, which needs fewer keys.
+ */
+PackingPlan PlanPacking(const PackingInput &input, const OpCostModel &costs);
+
+void PrintPackingPlan(std::ostream &os, const PackingPlan &plan);
+
+#endif //DPRIVE_ML__PACKING_PLANNER_H_
@@ -0,0 +1,252 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "param_planner.h"
+#include "utils.h"
+
+// Size of the auxiliary (P) primes OpenFHE uses for hybrid key switching
+const uint32_t AUX_MOD_SIZE = 60;
+const uint32_t MIN_RING_DIM = 1 << 10;
+const uint32_t MAX_RING_DIM = 1 << 17;
+
+uint32_t ChebyshevDepth(uint32_t degree) {
+  uint32_t depth = ChebyshevDepthOf(degree);
+  if (depth == 0) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: Chebyshev degree above 2031 is not supported"));
+  }
+  return depth;
+}
+
+uint32_t ChebyshevMaxDegree(uint32_t depth) {
+  if (depth < CHEBYSHEV_MIN_DEPTH) return 0;
+  return CHEBYSHEV_MAX_DEGREES[std::min(depth - CHEBYSHEV_MIN_DEPTH, CHEBYSHEV_NUM_DEPTHS - 1)];
+}
+
+// Depth of the sigmoid with either evaluator; throws on unsupported degrees
+static uint32_t SigmoidDepth(uint32_t degree, bool powerSeries) {
+  if (!powerSeries) return ChebyshevDepth(degree);
+  uint32_t depth = PowerSeriesDepthOf(degree);
+  if (depth == 0) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: power-basis degree above ") + std::to_string(POWER_SERIES_MAX_DEGREE) +
+        std::string(" is not supported"));
+  }
+  return depth;
+}
+
+uint32_t NagIterationDepth(uint32_t chebDegree, bool powerSeries) {
+  SigmoidDepth(chebDegree, powerSeries);  // throws on unsupported degrees
+  return NagIterationLevels(chebDegree, powerSeries);
+}
+
+uint32_t NagCycleDepth(uint32_t chebDegree, uint32_t intermediateDegree, uint32_t itersPerRefresh, bool powerSeries) {
+  if (itersPerRefresh == 0) itersPerRefresh = 1;
+  return NagIterationDepth(chebDegree, powerSeries) +
+      (itersPerRefresh - 1) * NagIterationDepth(intermediateDegree, powerSeries);
+}
+
+DataLevels GradientDataLevels(uint32_t refreshLevel, uint32_t chebDegree, uint32_t intermediateDegree,
+                              bool powerSeries) {
+  uint32_t sigmoidDepth = std::min(SigmoidDepth(chebDegree, powerSeries),
+                                   SigmoidDepth(intermediateDegree, powerSeries));
+  uint32_t predsLevel = refreshLevel + LogitsPipeline::levels + sigmoidDepth - 1;
+  return DataLevels{refreshLevel, predsLevel, predsLevel};
+}
+
+uint32_t MaxLogQP(uint32_t ringDim, lbcrypto::SecurityLevel securityLevel) {
+  // HE standard bounds for ternary secrets, ring dimensions 2^10 .. 2^17
+  static const std::map<uint32_t, std::vector<uint32_t>> bounds = {
+      // ringDim   128   192   256 (classic)
+      {1 << 10, {27, 19, 14}},
+      {1 << 11, {54, 37, 29}},
+      {1 << 12, {109, 75, 58}},
+      {1 << 13, {218, 152, 118}},
+      {1 << 14, {438, 305, 237}},
+      {1 << 15, {881, 611, 476}},
+      {1 << 16, {1747, 1228, 956}},
+      {1 << 17, {3523, 2468, 1918}},
+  };
+  auto found = bounds.find(ringDim);
+  if (found == bounds.end()) return 0;
+  switch (securityLevel) {
+    case lbcrypto::HEStd_128_classic: return found->second[0];
+    case lbcrypto::HEStd_192_classic: return found->second[1];
+    case lbcrypto::HEStd_256_classic: return found->second[2];
+    default: return 0;
+  }
+}
+
+// log2(P) for hybrid key switching with numLargeDigits digits over multDepth + 1 towers
+static uint32_t EstimateLogP(uint32_t multDepth, uint32_t numLargeDigits, uint32_t dcrtBits, uint32_t firstModSize) {
+  uint32_t numTowers = multDepth + 1;
+  uint32_t towersPerDigit = (numTowers + numLargeDigits - 1) / numLargeDigits;
+  uint32_t maxDigitBits = std::max(firstModSize, dcrtBits) + (towersPerDigit - 1) * dcrtBits;
+  return AUX_MOD_SIZE * ((maxDigitBits + AUX_MOD_SIZE - 1) / AUX_MOD_SIZE);
+}
+
+// Relative hybrid key-switching cost: every digit is raised to (Q towers + P towers), then the
+// result is brought back down once. The ring dimension scales all of it linearly.
+static double KeySwitchCost(uint32_t multDepth, uint32_t numLargeDigits, uint32_t logP) {
+  double numTowersQP = (multDepth + 1) + double(logP) / AUX_MOD_SIZE;
+  return (numLargeDigits + 1) * numTowersQP;
+}
+
+CKKSPlan PlanCKKSParameters(const PlannerInput &input) {
+  CKKSPlan plan{};
+  auto &why = plan.reasoning;
+
+  /////////////////////////////////////////////////////////
+  // Depth
+  /////////////////////////////////////////////////////////
+  uint32_t iterationDepth = NagIterationDepth(input.chebDegree, input.powerSeries);
+  auto trainingDepth = PlanTrainingDepth(TrainingVariant{input.chebDegree, input.intermediateDegree,
+                                                         input.itersPerRefresh, input.lossDegree, input.powerSeries});
+  why.push_back((input.powerSeries ? "Power-basis degree " : "Chebyshev degree ") + std::to_string(input.chebDegree) +
+      " consumes " + std::to_string(SigmoidDepth(input.chebDegree, input.powerSeries)) +
+      " levels; one NAG iteration consumes " +
+      std::to_string(iterationDepth) + " (1 unpack + 2 MatrixVectorProductRow + EvalLogistic + 1 "
+                                       "MatrixVectorProductCol + 1 momentum + 1 repack)");
+  if (input.itersPerRefresh > 1) {
+    iterationDepth = NagCycleDepth(input.chebDegree, input.intermediateDegree, input.itersPerRefresh,
+                                   input.powerSeries);
+    why.push_back(std::to_string(input.itersPerRefresh) + " iterations per refresh, " +
+        std::to_string(input.itersPerRefresh - 1) + " of them at degree " + std::to_string(input.intermediateDegree) +
+        " (" + std::to_string(NagIterationDepth(input.intermediateDegree, input.powerSeries)) +
+        " levels each), consume " +
+        std::to_string(iterationDepth) + " levels");
+  }
+  if (trainingDepth.requiredLevels > iterationDepth) {
+    iterationDepth = trainingDepth.requiredLevels;
+    why.push_back("the encrypted loss (softplus degree " + std::to_string(input.lossDegree) + ") needs " +
+        std::to_string(trainingDepth.lossLevels) + " levels after a refresh");
+  }
+  if (input.extraLevels > 0) {
+    why.push_back("adding a margin of " + std::to_string(input.extraLevels) + " level(s)");
+  }
+
+  if (input.withBT) {
+    plan.levelsBeforeBootstrap = iterationDepth + input.extraLevels;
+    plan.bootstrapDepth = lbcrypto::FHECKKSRNS::GetBootstrapDepth(
+        input.approxBootstrapDepth, input.levelBudget, input.skDist);
+    plan.multDepth = plan.levelsBeforeBootstrap + plan.bootstrapDepth;
+    why.push_back("bootstrapping with level budget {" + std::to_string(input.levelBudget[0]) + ", " +
+        std::to_string(input.levelBudget[1]) + "} and approx depth " + std::to_string(input.approxBootstrapDepth) +
+        " consumes " + std::to_string(plan.bootstrapDepth) + " levels -> multDepth " +
+        std::to_string(plan.multDepth));
+  } else {
+    plan.levelsBeforeBootstrap = 0;
+    plan.bootstrapDepth = 0;
+    plan.multDepth = iterationDepth + input.extraLevels;
+    why.push_back("interactive refresh re-encrypts at the top level -> multDepth " + std::to_string(plan.multDepth));
+  }
+  plan.logQ = input.firstModSize + plan.multDepth * input.dcrtBits;
+  why.push_back("log2(Q) = " + std::to_string(input.firstModSize) + " + " + std::to_string(plan.multDepth) + " x " +
+      std::to_string(input.dcrtBits) + " = " + std::to_string(plan.logQ));
+
+  /////////////////////////////////////////////////////////
+  // Packing: X is packed row major with rows and columns padded to powers of two
+  /////////////////////////////////////////////////////////
+  usint slotsNeeded = NextPow2(input.numSamples) * NextPow2(input.numFeatures);
+  uint32_t minRingForData = std::max(MIN_RING_DIM, uint32_t(2 * slotsNeeded));
+  why.push_back("packing " + std::to_string(input.numSamples) + " x " + std::to_string(input.numFeatures) +
+      " needs " + std::to_string(slotsNeeded) + " slots -> ring dimension >= " + std::to_string(minRingForData));
+
+  /////////////////////////////////////////////////////////
+  // Ring dimension and dnum
+  /////////////////////////////////////////////////////////
+  uint32_t startRing = std::max(minRingForData, NextPow2(std::max(input.minRingDim, MIN_RING_DIM)));
+  for (uint32_t ringDim = startRing; ringDim <= MAX_RING_DIM; ringDim *= 2) {
+    uint32_t maxLogQP = MaxLogQP(ringDim, input.securityLevel);
+    // without a security level, log2(QP) has no upper bound
+    bool unbounded = (input.securityLevel == lbcrypto::HEStd_NotSet);
+
+    uint32_t bestDnum = 0;
+    uint32_t bestLogP = 0;
+    double bestCost = 0;
+    for (uint32_t dnum = 1; dnum <= plan.multDepth + 1; dnum++) {
+      uint32_t logP = EstimateLogP(plan.multDepth, dnum, input.dcrtBits, input.firstModSize);
+      if (!unbounded && plan.logQ + logP > maxLogQP) continue;
+      double cost = KeySwitchCost(plan.multDepth, dnum, logP);
+      if (bestDnum == 0 || cost < bestCost) {
+        bestDnum = dnum;
+        bestLogP = logP;
+        bestCost = cost;
+      }
+    }
+
+    if (bestDnum == 0) {
+      why.push_back("ring dimension " + std::to_string(ringDim) + " rejected: log2(Q) alone exceeds the secure " +
+          "bound of " + std::to_string(maxLogQP) + " bits for every dnum");
+      continue;
+    }
+
+    plan.ringDim = ringDim;
+    plan.batchSize = ringDim / 2;
+    plan.numLargeDigits = bestDnum;
+    plan.logP = bestLogP;
+    plan.maxLogQP = maxLogQP;
+    if (unbounded) {
+      why.push_back("security level not set: taking ring dimension " + std::to_string(ringDim));
+    } else {
+      why.push_back("ring dimension " + std::to_string(ringDim) + " accepted: log2(QP) = " +
+          std::to_string(plan.logQ + plan.logP) + " <= " + std::to_string(maxLogQP));
+    }
+    why.push_back("dnum " + std::to_string(bestDnum) + " minimizes the key-switching cost (log2(P) ~ " +
+        std::to_string(bestLogP) + ")");
+    return plan;
+  }
+
+  for (auto &line : why) std::cerr << "\t" << line << std::endl;
+  OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+      std::to_string(__LINE__) +
+      std::string("Error: no secure ring dimension up to 2^17 supports the required depth"));
+}
+
+void PrintPlan(std::ostream &os, const CKKSPlan &plan) {
+  os << "*********************************************" << std::endl;
+  os << "Planned CKKS Params" << std::endl;
+  for (auto &line : plan.reasoning) {
+    os << "\t- " << line << std::endl;
+  }
+  os << "\tRing dimension: " << plan.ringDim << std::endl;
+  os << "\tBatch size: " << plan.batchSize << std::endl;
+  os << "\tMult depth: " << plan.multDepth << std::endl;
+  if (plan.levelsBeforeBootstrap > 0) {
+    os << "\tLevels before bootstrap: " << plan.levelsBeforeBootstrap << std::endl;
+  }
+  os << "\tNum large digits (dnum): " << plan.numLargeDigits << std::endl;
+  os << "\tlog2(QP) estimate: " << plan.logQ + plan.logP;
+  if (plan.maxLogQP > 0) os << " (secure bound " << plan.maxLogQP << ")";
+  os << std::endl;
+}
@@ -0,0 +1,130 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__PARAM_PLANNER_H_
+#define DPRIVE_ML__PARAM_PLANNER_H_
+
+#include <string>
+#include <vector>
+#include "openfhe.h"
+#include "depth_plan.h"
+#include "lr_types.h"
+
+////////// CKKS parameter planning for the NAG training pipeline ///////////////////////////////
+
+/* Multiplicative depth consumed by EvalChebyshevFunction/EvalLogistic for a polynomial of the given degree
+ * (ChebyshevDepthOf in depth_plan.h). Throws for degrees above 2031.
+ */
+uint32_t ChebyshevDepth(uint32_t degree);
+
+// Highest degree ChebyshevDepth fits into the given depth (0 if none does)
+uint32_t ChebyshevMaxDegree(uint32_t depth);
+
+/* Depth of a single NAG iteration, from a freshly refreshed ctWeights to the repacked ctWeights, summed from
+ * the stage descriptors in depth_plan.h (NagIterationPipeline):
+ *   unpack theta/phi (mask mult)          1
+ *   MatrixVectorProductRow                2  (EvalMult + the masking mult inside EvalSumCols)
+ *   EvalLogistic                          ChebyshevDepth(degree), PowerSeriesDepthOf(degree) with powerSeries
+ *   MatrixVectorProductCol                1
+ *   NAG momentum (EvalMult by LR_ETA)     1
+ *   repack theta/phi (mask mult)          1
+ * Throws for degrees above 2031, or above 15 with powerSeries.
+ */
+uint32_t NagIterationDepth(uint32_t chebDegree, bool powerSeries = false);
+
+/* Levels needed to run itersPerRefresh NAG iterations between two refreshes, where all but the last
+ * iteration of the cycle evaluate the sigmoid at intermediateDegree.
+ */
+uint32_t NagCycleDepth(uint32_t chebDegree, uint32_t intermediateDegree, uint32_t itersPerRefresh,
+                       bool powerSeries = false);
+
+/* Levels at which the data ciphertexts can be encrypted so they never sit above the ciphertexts they
+ * are combined with, given the level of ctWeights right after a refresh:
+ *   X       meets theta after the unpack mask     refreshLevel
+ *   y, -X'  meet the predictions after EvalLogistic  refreshLevel + 1 + 2 + sigmoid depth - 1
+ * Each is one level below the partner's depth, since FIXEDAUTO leaves that product unrescaled. The
+ * shallowest degree used anywhere in the run decides the EvalLogistic depth.
+ */
+struct DataLevels {
+  uint32_t x;
+  uint32_t negXt;
+  uint32_t labels;
+};
+DataLevels GradientDataLevels(uint32_t refreshLevel, uint32_t chebDegree, uint32_t intermediateDegree,
+                              bool powerSeries = false);
+
+struct PlannerInput {
+  uint32_t chebDegree;
+  uint32_t intermediateDegree;  // degree on the intermediate iterations of a refresh cycle
+  uint32_t itersPerRefresh;     // NAG iterations between bootstraps (or re-encryptions)
+  uint32_t lossDegree;          // softplus degree of the encrypted loss, 0 without it
+  bool powerSeries;             // the sigmoids are evaluated in the power basis (UsesPowerSeries)
+  usint numSamples;
+  usint numFeatures;
+  bool withBT;
+  std::vector<uint32_t> levelBudget;
+  uint32_t approxBootstrapDepth;
+  lbcrypto::SecretKeyDist skDist;
+  lbcrypto::SecurityLevel securityLevel;
+  uint32_t dcrtBits;
+  uint32_t firstModSize;
+  uint32_t minRingDim;   // lower bound on the ring dimension, e.g. from the command line
+  uint32_t extraLevels;  // safety margin added on top of the computed depth
+};
+
+struct CKKSPlan {
+  uint32_t ringDim;
+  uint32_t batchSize;
+  uint32_t multDepth;
+  uint32_t levelsBeforeBootstrap;  // 0 when not bootstrapping
+  uint32_t bootstrapDepth;
+  uint32_t numLargeDigits;
+  uint32_t logQ;
+  uint32_t logP;
+  uint32_t maxLogQP;               // 0 when the security level is not set
+  std::vector<std::string> reasoning;
+};
+
+/* Largest log2(QP) that is secure for the ring dimension at the given security level
+ * (HE standard, ternary secrets). Returns 0 for HEStd_NotSet or if no ring dimension is large enough.
+ */
+uint32_t MaxLogQP(uint32_t ringDim, lbcrypto::SecurityLevel securityLevel);
+
+/* Computes the exact depth the pipeline needs, then picks the smallest ring dimension that holds the
+ * packed data and is secure for the resulting modulus, and the number of key-switching digits (dnum)
+ * that minimizes the hybrid key-switching cost at that ring dimension.
+ * Throws if no ring dimension up to 2^17 works.
+ */
+CKKSPlan PlanCKKSParameters(const PlannerInput &input);
+
+void PrintPlan(std::ostream &os, const CKKSPlan &plan);
+
+#endif //DPRIVE_ML__PARAM_PLANNER_H_
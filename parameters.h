@@ -38,6 +38,7 @@
 #include <getopt.h>
 #include <iostream>
 #include "data_io.h"
+#include "exec_config.h"
 #include "lr_train_funcs.h"
 #include "lr_types.h"
 
@@ -66,6 +67,8 @@ class Parameters {
   ) {
 
     std::string outFilePrefix_def = "../results/nag_";
+    std::string bootstrapCacheFile_def = "../results/bootstrap_tune_cache.txt";
+    std::string chebTableFile_def = "../results/chebyshev_table.txt";
     int outputPrecision_def = dbl::max_digits10;
 
     numIters = numIters_def;
@@ -84,9 +87,33 @@ class Parameters {
     withCS = withCompositeScaling;
     dbPrecisionCS = doublePrecisionCS;
     hPrecisionCS = highPrecisionCS;
+    traceOps = false;
+    autoPlan = false;
+    ringDimFromCLI = false;
+    autotuneBT = false;
+    sparseSecretBT = false;
+    bootstrapCacheFile = bootstrapCacheFile_def;
+    itersPerRefresh = 1;
+    intermediateDegree = 0;
+    refreshSocket = "";
+    shardRows = 0;
+    shardWorkers = 0;
+    leanMemory = false;
+    ctStoreDir = "";
+    modelDir = "";
+    encLossEvery = 0;
+    chebTableFile = chebTableFile_def;
+    lsqSigmoidDegree = 0;
+    sigmoidRefWeightsFile = "";
+    sigmoidSchedule = "";
+    btSwitchFraction = 0.75;
+    btTolerance = 1e-3;
+    opCostFile = "";
+    fullBatch = false;
+    execOptions = ExecOptions();
 
     int opt;
-    while ((opt = getopt(argc, argv, "bmn:r:x:y:j:k:d:w:p:e:cmn:fmn:tmn:h")) != -1) {
+    while ((opt = getopt(argc, argv, "bmn:r:x:y:j:k:d:w:p:e:E:D:P:Fcmn:fmn:tmn:oauU:i:g:s:S:W:LT:M:l:C:q:Q:G:ZH:J:N:B:O:h")) != -1) {
       switch (opt) {
         case 'b':withBT = true;
           std::cout << "bootstrapping enabled" << std::endl;
@@ -101,6 +128,18 @@ class Parameters {
         case 'e':btPrecision = atoi(optarg);
           std::cout << "Bootstrapping Precision (only valid in 64-bit setups): " << btPrecision << std::endl;
           break;
+        case 'E':btSwitchFraction = atof(optarg);
+          std::cout << "double bootstrapping from iteration fraction: " << btSwitchFraction << std::endl;
+          break;
+        case 'D':btTolerance = atof(optarg);
+          std::cout << "double bootstrapping loss tolerance: " << btTolerance << std::endl;
+          break;
+        case 'P':opCostFile = optarg;
+          std::cout << "operation costs for the packing plan: " << opCostFile << std::endl;
+          break;
+        case 'F':fullBatch = true;
+          std::cout << "packing the data into every slot of the ring" << std::endl;
+          break;
           /**
            * Train-Test files
            */
@@ -117,6 +156,7 @@ class Parameters {
           std::cout << "testYFile: " << testYFile << std::endl;
           break;
         case 'd': ringDimension = atoi(optarg);
+          ringDimFromCLI = true;
           std::cout << "ringDimension: " << ringDimension << std::endl;
           break;
         case 'w':outFilePrefix = optarg;
@@ -134,6 +174,75 @@ class Parameters {
         case 't':hPrecisionCS = true;
           std::cout << "using (non-secure) high precision composite scaling" << std::endl;
           break;
+        case 'o':traceOps = true;
+          std::cout << "tracing HE operation counts and levels" << std::endl;
+          break;
+        case 'a':autoPlan = true;
+          std::cout << "planning CKKS parameters automatically" << std::endl;
+          break;
+        case 'u':autotuneBT = true;
+          std::cout << "autotuning the bootstrapping configuration" << std::endl;
+          break;
+        case 'U':bootstrapCacheFile = optarg;
+          std::cout << "bootstrapping tuning cache: " << bootstrapCacheFile << std::endl;
+          break;
+        case 'Z':sparseSecretBT = true;
+          std::cout << "allowing sparse secret key distributions for bootstrapping" << std::endl;
+          break;
+        case 'i':itersPerRefresh = atoi(optarg);
+          std::cout << "NAG iterations per bootstrap/refresh: " << itersPerRefresh << std::endl;
+          break;
+        case 'g':intermediateDegree = atoi(optarg);
+          std::cout << "Chebyshev degree for intermediate iterations: " << intermediateDegree << std::endl;
+          break;
+        case 's':refreshSocket = optarg;
+          std::cout << "refresh server socket: " << refreshSocket << std::endl;
+          break;
+        case 'S':shardRows = atoi(optarg);
+          std::cout << "rows per data shard: " << shardRows << std::endl;
+          break;
+        case 'W':shardWorkers = atoi(optarg);
+          std::cout << "concurrent shard workers: " << shardWorkers << std::endl;
+          break;
+        case 'L':leanMemory = true;
+          std::cout << "lean memory mode" << std::endl;
+          break;
+        case 'T':ctStoreDir = optarg;
+          std::cout << "encrypted shard store: " << ctStoreDir << std::endl;
+          break;
+        case 'M':modelDir = optarg;
+          std::cout << "encrypted model directory: " << modelDir << std::endl;
+          break;
+        case 'l':encLossEvery = atoi(optarg);
+          std::cout << "encrypted loss every " << encLossEvery << " iterations" << std::endl;
+          break;
+        case 'C':chebTableFile = optarg;
+          std::cout << "Chebyshev coefficient table: " << chebTableFile << std::endl;
+          break;
+        case 'q':lsqSigmoidDegree = atoi(optarg);
+          std::cout << "least-squares sigmoid of degree " << lsqSigmoidDegree << std::endl;
+          break;
+        case 'Q':sigmoidRefWeightsFile = optarg;
+          std::cout << "reference weights for the sigmoid fit: " << sigmoidRefWeightsFile << std::endl;
+          break;
+        case 'G':sigmoidSchedule = optarg;
+          std::cout << "sigmoid schedule: " << sigmoidSchedule << std::endl;
+          break;
+        case 'H':execOptions.threads = atoi(optarg);
+          std::cout << "OpenMP threads: " << execOptions.threads << std::endl;
+          break;
+        case 'J':execOptions.phaseThreads = optarg;
+          std::cout << "threads per phase: " << execOptions.phaseThreads << std::endl;
+          break;
+        case 'N':execOptions.nested = atoi(optarg);
+          std::cout << "nested OpenMP regions: " << execOptions.nested << std::endl;
+          break;
+        case 'B':execOptions.pin = optarg;
+          std::cout << "thread pinning: " << execOptions.pin << std::endl;
+          break;
+        case 'O':execOptions.numaNode = atoi(optarg);
+          std::cout << "NUMA node: " << execOptions.numaNode << std::endl;
+          break;
         case 'h':
         default: /* '?' */
           std::cerr << "Usage: " << std::endl
@@ -141,6 +250,13 @@ class Parameters {
                     << "  -b do bootstraping (emulate otherwise) [" << (withBT_def ? "true" : "false") << "]"
                     << std::endl
                     << "  -e <bootstrapping precision in 64-bit scenario> [" << btPrecision_def << "]" << std::endl
+                    << "  -E <fraction of the iterations after which -e double-bootstraps, 0 = always> [0.75]"
+                    << std::endl
+                    << "  -D <relative loss change per iteration that switches -e to double bootstrapping earlier,"
+                    << " 0 = off> [0.001]" << std::endl
+                    << "  -P <bench_lr JSON results to calibrate the packing plan's operation costs> [relative costs]"
+                    << std::endl
+                    << "  -F use a batch of ringDim / 2 slots instead of the planned one [false]" << std::endl
                     << "  -n <number of iterations to perform> [" << numIters_def << "]" << std::endl
                     << "  -r <number of rows to read> [" << rowsToRead_def << "]" << std::endl
                     << "  -x <training X file name> [" << trainXFile_def << "]" << std::endl
@@ -153,12 +269,48 @@ class Parameters {
                     << "  -c enable and run with composite scaling technique [" << (withCompositeScaling ? "true" : "false") << std::endl
                     << "  -t use high precision composite scaling [" << (highPrecisionCS ? "true" : "false") << std::endl
                     << "  -f register word size for composite scaling" << (doublePrecisionCS ? 64 : 32) << std::endl
+                    << "  -o trace HE operation counts and ciphertext levels per iteration [false]" << std::endl
+                    << "  -a plan depth, ring dimension and dnum automatically (-d becomes a lower bound) [false]" << std::endl
+                    << "  -u autotune the bootstrapping configuration and cache the winner [false]" << std::endl
+                    << "  -U <bootstrapping tuning cache file> [" << bootstrapCacheFile_def << "]" << std::endl
+                    << "  -Z let -u pick, and runs use, sparse secret keys (weaker than the HE standard) [false]"
+                    << std::endl
+                    << "  -i <NAG iterations per bootstrap/refresh> [1]" << std::endl
+                    << "  -g <Chebyshev degree for intermediate iterations, 0 = same as the last one> [0]" << std::endl
+                    << "  -s <refresh server socket; interactive refreshes go to lr_refresh_server> [in-process]"
+                    << std::endl
+                    << "  -S <rows per data shard, 0 = as many as fit in a ciphertext> [0]" << std::endl
+                    << "  -W <concurrent shard workers, 0 = one per shard; OpenMP threads are split among them> [0]"
+                    << std::endl
+                    << "  -L lean memory: free the plaintext data once encrypted, stream the CSVs for the loss [false]"
+                    << std::endl
+                    << "  -T <directory to encrypt the training shards into and stream them from every iteration;"
+                    << " implies -L> [none]" << std::endl
+                    << "  -M <directory to save the encrypted model to, for lr_infer> [none]" << std::endl
+                    << "  -l <evaluate the loss homomorphically every k iterations instead of decrypting the weights"
+                    << " every iteration, 0 = off> [0]" << std::endl
+                    << "  -C <Chebyshev coefficient table, empty = keep in memory only> [" << chebTableFile_def << "]"
+                    << std::endl
+                    << "  -q <degree of a least-squares sigmoid fit (e.g. 3, 5, 7, 15) replacing the Chebyshev"
+                    << " interpolation, 0 = off> [0]" << std::endl
+                    << "  -Q <weights CSV of an earlier run; the -q fit is weighted towards its training logits> [none]"
+                    << std::endl
+                    << "  -G <sigmoid degree/interval schedule: 'auto' (from a bound on |X theta|) or"
+                    << " iteration:degree:bound,...> [fixed]" << std::endl
+                    << "  -H <OpenMP threads> [OpenMP's default]" << std::endl
+                    << "  -J <threads per phase, e.g. gradient=16,loss=8 (setup, refresh, unpack, gradient, loss,"
+                    << " nag_update, monitor, repack)> [-H]" << std::endl
+                    << "  -N <nested OpenMP regions inside OpenFHE, 0|1> [OpenMP's default]" << std::endl
+                    << "  -B <thread pinning: none, compact (fill one NUMA node first) or spread (alternate nodes)>"
+                    << " [none]" << std::endl
+                    << "  -O <run on this NUMA node only> [all]" << std::endl
                     << "  -h prints this message" << std::endl;
           std::exit(EXIT_FAILURE);
       }
     }
 
     rowsToRead = (rowsToRead == 0) ? -1 : rowsToRead;
+    itersPerRefresh = (itersPerRefresh == 0) ? 1 : itersPerRefresh;
     if (withBT) {
       outFilePrefix = outFilePrefix_def + "bootstrap_";
     } else {
@@ -169,6 +321,7 @@ class Parameters {
     trainOutFile = outFilePrefix + "train.csv";
     testLossOutFile = outFilePrefix + "test.csv";
     lossOutFile = outFilePrefix + "loss.csv";
+    encLossOutFile = outFilePrefix + "enc_loss.csv";
 
     std::cerr.precision(outputPrecision); //set output precision.
     if (verbose) {
@@ -180,6 +333,33 @@ class Parameters {
       std::cout << "\tUse Composite Scaling Tech? " << withCS << std::endl;
       std::cout << "\tUse High Precision Composite Scaling? " << hPrecisionCS << std::endl;
       std::cout << "\tComposite Scaling HW Precision: " << ((dbPrecisionCS) ? 64 : 32) << std::endl;
+      std::cout << "\tTrace HE operations? " << traceOps << std::endl;
+      std::cout << "\tPlan CKKS parameters automatically? " << autoPlan << std::endl;
+      std::cout << "\tAutotune bootstrapping? " << autotuneBT << std::endl;
+      std::cout << "\tBootstrapping tuning cache: " << bootstrapCacheFile << std::endl;
+      std::cout << "\tAllow sparse secret keys? " << sparseSecretBT << std::endl;
+      std::cout << "\tIterations per refresh: " << itersPerRefresh << std::endl;
+      std::cout << "\tIntermediate Chebyshev degree: " << intermediateDegree << std::endl;
+      std::cout << "\tRefresh server socket: " << refreshSocket << std::endl;
+      std::cout << "\tRows per data shard: " << shardRows << std::endl;
+      std::cout << "\tShard workers: " << shardWorkers << std::endl;
+      std::cout << "\tLean memory? " << leanMemory << std::endl;
+      std::cout << "\tEncrypted shard store: " << ctStoreDir << std::endl;
+      std::cout << "\tEncrypted model directory: " << modelDir << std::endl;
+      std::cout << "\tEncrypted loss every: " << encLossEvery << std::endl;
+      std::cout << "\tChebyshev coefficient table: " << chebTableFile << std::endl;
+      std::cout << "\tLeast-squares sigmoid degree: " << lsqSigmoidDegree << std::endl;
+      std::cout << "\tSigmoid fit reference weights: " << sigmoidRefWeightsFile << std::endl;
+      std::cout << "\tSigmoid schedule: " << sigmoidSchedule << std::endl;
+      std::cout << "\tDouble bootstrapping from iteration fraction: " << btSwitchFraction << std::endl;
+      std::cout << "\tDouble bootstrapping loss tolerance: " << btTolerance << std::endl;
+      std::cout << "\tPacking operation costs: " << opCostFile << std::endl;
+      std::cout << "\tFull-ring batch? " << fullBatch << std::endl;
+      std::cout << "\tOpenMP threads: " << execOptions.threads << std::endl;
+      std::cout << "\tThreads per phase: " << execOptions.phaseThreads << std::endl;
+      std::cout << "\tNested OpenMP regions: " << execOptions.nested << std::endl;
+      std::cout << "\tThread pinning: " << execOptions.pin << std::endl;
+      std::cout << "\tNUMA node: " << execOptions.numaNode << std::endl;
       std::cout << "\tTraining samples to read: " << rowsToRead << std::endl;
       std::cout << "\tTraining X CSV file: " << trainXFile << std::endl;
       std::cout << "\tTraining y CSV file: " << trainYFile << std::endl;
@@ -191,6 +371,7 @@ class Parameters {
       std::cout << "\tOutput train prediction CSV file: " << trainOutFile << std::endl;
       std::cout << "\tOutput test loss CSV file: " << testLossOutFile << std::endl;
       std::cout << "\tOutput train loss CSV file: " << lossOutFile << std::endl;
+      std::cout << "\tOutput encrypted train loss CSV file: " << encLossOutFile << std::endl;
       std::cout << std::endl;
     }
   }
@@ -212,10 +393,35 @@ class Parameters {
   std::string trainOutFile;
   std::string testLossOutFile;
   std::string lossOutFile;
+  std::string encLossOutFile;
   int btPrecision;
   bool withCS;
   bool dbPrecisionCS;
   bool hPrecisionCS;
+  bool traceOps;
+  bool autoPlan;
+  bool ringDimFromCLI;
+  bool autotuneBT;
+  bool sparseSecretBT;
+  std::string bootstrapCacheFile;
+  usint itersPerRefresh;
+  uint32_t intermediateDegree;
+  std::string refreshSocket;
+  usint shardRows;
+  usint shardWorkers;
+  bool leanMemory;
+  std::string ctStoreDir;
+  std::string modelDir;
+  usint encLossEvery;
+  std::string chebTableFile;
+  uint32_t lsqSigmoidDegree;
+  std::string sigmoidRefWeightsFile;
+  std::string sigmoidSchedule;
+  double btSwitchFraction;
+  double btTolerance;
+  std::string opCostFile;
+  bool fullBatch;
+  ExecOptions execOptions;
 };
 
 #endif //DPRIVE_ML__PARAMETERS_H_
@@ -0,0 +1,73 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "pt_cache.h"
+
+void PlaintextCache::Add(const std::string &name, const Vec &operand) {
+  std::lock_guard<std::mutex> lock(mutex);
+  values[name] = operand;
+  // a new value for the name makes its encodings stale
+  for (auto it = encoded.begin(); it != encoded.end();) {
+    it = (it->first.first == name) ? encoded.erase(it) : std::next(it);
+  }
+}
+
+PT PlaintextCache::At(const std::string &name, uint32_t level) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto key = std::make_pair(name, level);
+  auto found = encoded.find(key);
+  if (found != encoded.end()) return found->second;
+
+  auto operand = values.find(name);
+  if (operand == values.end()) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: no plaintext operand named ") + name);
+  }
+  PT pt = cc->MakeCKKSPackedPlaintext(operand->second, 1, level);
+  encoded[key] = pt;
+  return pt;
+}
+
+size_t PlaintextCache::NumEncoded() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return encoded.size();
+}
+
+size_t PlaintextCache::Bytes() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t bytes = 0;
+  for (auto &entry : encoded) {
+    auto &element = entry.second->GetElement<lbcrypto::DCRTPoly>();
+    bytes += element.GetNumOfElements() * element.GetRingDimension() * sizeof(uint64_t);
+  }
+  return bytes;
+}
@@ -0,0 +1,72 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__PT_CACHE_H_
+#define DPRIVE_ML__PT_CACHE_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include "openfhe.h"
+#include "lr_types.h"
+
+////////// Plaintext operands encoded at the level they are used at ///////////////////////////////
+
+/* A plaintext encoded at level 0 carries every RNS tower, so each EvalMult against a deeper ciphertext
+ * has OpenFHE copy it and drop the extra towers (and, with FLEXIBLEAUTO, adjust it to that level's scaling
+ * factor). The cache encodes each named operand once per level it is multiplied at, on first use, so the
+ * loop only pays for that in its first refresh cycle. Safe to share between threads.
+ */
+class PlaintextCache {
+ public:
+  explicit PlaintextCache(const CC &cc) : cc(cc) {}
+
+  void Add(const std::string &name, const Vec &values);
+
+  // name encoded at level
+  PT At(const std::string &name, uint32_t level);
+
+  /* name encoded for an EvalMult with ct. Under FIXEDAUTO a ciphertext that has not been rescaled yet
+   * (noise scale degree 2) is rescaled before the multiplication, one level below its current one.
+   */
+  PT For(const std::string &name, const CT &ct) { return At(name, ct->GetLevel() + ct->GetNoiseScaleDeg() - 1); }
+
+  size_t NumEncoded() const;
+  size_t Bytes() const;  // of the encoded plaintexts
+
+ private:
+  CC cc;
+  mutable std::mutex mutex;
+  std::map<std::string, Vec> values;
+  std::map<std::pair<std::string, uint32_t>, PT> encoded;
+};
+
+#endif //DPRIVE_ML__PT_CACHE_H_
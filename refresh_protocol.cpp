@@ -0,0 +1,209 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "refresh_protocol.h"
+#include <cstring>
+#include "socket_io.h"
+
+void AppendEvalKeys(std::string &payload, const std::string &keyTag) {
+  using Context = lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>;
+  std::stringstream multKeys, automorphismKeys;
+  if (!Context::SerializeEvalMultKey(multKeys, lbcrypto::SerType::BINARY, keyTag) ||
+      !Context::SerializeEvalAutomorphismKey(automorphismKeys, lbcrypto::SerType::BINARY, keyTag)) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: could not serialize the evaluation keys"));
+  }
+  AppendBlob(payload, multKeys.str());
+  AppendBlob(payload, automorphismKeys.str());
+}
+
+void LoadEvalKeys(const std::string &multKeys, const std::string &automorphismKeys) {
+  using Context = lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>;
+  std::stringstream multStream(multKeys), automorphismStream(automorphismKeys);
+  if (!Context::DeserializeEvalMultKey(multStream, lbcrypto::SerType::BINARY) ||
+      !Context::DeserializeEvalAutomorphismKey(automorphismStream, lbcrypto::SerType::BINARY)) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: could not deserialize the evaluation keys"));
+  }
+}
+
+CT RefreshCiphertext(CC &cc, const KeyPair &keys, const CT &ct, usint period) {
+  PT pt;
+  cc->Decrypt(keys.secretKey, ct, &pt);
+  usint batchSize = cc->GetEncodingParams()->GetBatchSize();
+  if (period == 0 || period > batchSize) period = batchSize;
+  pt->SetLength(period);
+  Vec values = pt->GetRealPackedValue();
+
+  Vec tiled(batchSize);
+  for (usint i = 0; i < batchSize; i++) {
+    tiled[i] = values[i % period];
+  }
+  return cc->Encrypt(keys.publicKey, cc->MakeCKKSPackedPlaintext(tiled));
+}
+
+RefreshClient::~RefreshClient() {
+  if (pending.valid()) pending.wait();
+  CloseSocket(fd);
+}
+
+void RefreshClient::Connect(const std::string &socketPath) {
+  fd = ConnectUnixSocket(socketPath);
+}
+
+static void ExpectReply(int fd, uint32_t expected, std::string &payload, size_t &received) {
+  uint32_t type;
+  if (!RecvFrame(fd, type, payload)) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: refresh server closed the connection"));
+  }
+  received += sizeof(uint32_t) + sizeof(uint64_t) + payload.size();
+  if (type == REFRESH_MSG_ERROR) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error from refresh server: ") + payload);
+  }
+  if (type != expected) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: unexpected message type ") + std::to_string(type));
+  }
+}
+
+ProvisionedKeys RefreshClient::Provision(const CC &cc, usint rowSize) {
+  std::string frame;
+  AppendBlob(frame, SerializeToString(cc));
+  AppendBlob(frame, std::string(reinterpret_cast<const char *>(&rowSize), sizeof(uint32_t)));
+  size_t sent = SendFrame(fd, REFRESH_MSG_PROVISION, frame);
+  size_t received = 0;
+  std::string reply;
+  ExpectReply(fd, REFRESH_MSG_KEYS, reply, received);
+  auto blobs = SplitBlobs(reply);
+  if (blobs.size() != 5) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: malformed KEYS message"));
+  }
+  ProvisionedKeys provisioned;
+  DeserializeFromString(provisioned.keys.publicKey, blobs[0]);
+  LoadEvalKeys(blobs[1], blobs[2]);
+  provisioned.sumRowKeys = std::make_shared<std::map<usint, lbcrypto::EvalKey<lbcrypto::DCRTPoly>>>();
+  provisioned.sumColKeys = std::make_shared<std::map<usint, lbcrypto::EvalKey<lbcrypto::DCRTPoly>>>();
+  DeserializeFromString(*provisioned.sumRowKeys, blobs[3]);
+  DeserializeFromString(*provisioned.sumColKeys, blobs[4]);
+  std::cout << "\tProvisioned refresh server (" << sent << " bytes), received its public and evaluation keys ("
+            << received << " bytes)" << std::endl;
+  return provisioned;
+}
+
+Vec RefreshClient::Decrypt(const CT &ct, usint length) {
+  // the refresh reply has to be read off the connection first
+  if (pending.valid()) pending.wait();
+  std::string payload(reinterpret_cast<const char *>(&length), sizeof(uint32_t));
+  payload.append(SerializeToString(ct));
+  SendFrame(fd, REFRESH_MSG_DECRYPT, payload);
+
+  std::string reply;
+  size_t received = 0;
+  ExpectReply(fd, REFRESH_MSG_DECRYPTED, reply, received);
+  Vec values(reply.size() / sizeof(double));
+  std::memcpy(values.data(), reply.data(), values.size() * sizeof(double));
+  return values;
+}
+
+void RefreshClient::Begin(const CC &cc, const CT &ct, usint period, uint32_t towersLeft) {
+  if (pending.valid()) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: a refresh is already in flight"));
+  }
+  TIC(beginTime);
+  // Compress runs on the calling thread: it uses the (OpenMP-parallel) RNS arithmetic of the context
+  CT compressed = cc->Compress(ct, towersLeft);
+  int sock = fd;
+  pending = std::async(std::launch::async, [this, sock, compressed, period]() {
+    std::string payload(reinterpret_cast<const char *>(&period), sizeof(uint32_t));
+    payload.append(SerializeToString(compressed));
+    lastSent = SendFrame(sock, REFRESH_MSG_REFRESH, payload);
+
+    std::string reply;
+    lastReceived = 0;
+    ExpectReply(sock, REFRESH_MSG_REFRESHED, reply, lastReceived);
+    CT refreshed;
+    DeserializeFromString(refreshed, reply);
+    return refreshed;
+  });
+}
+
+CT RefreshClient::Finish() {
+  TimeVar waitStart;
+  TIC(waitStart);
+  CT refreshed = pending.get();
+  double waitMs = TOC_US(waitStart) / 1000.0;
+  double roundTripMs = TOC_US(beginTime) / 1000.0;
+  stats.push_back({lastSent, lastReceived, roundTripMs, waitMs});
+  std::cout << "\tRefresh: sent " << lastSent << " bytes, received " << lastReceived << " bytes, round trip "
+            << roundTripMs << " ms, waited " << waitMs << " ms" << std::endl;
+  return refreshed;
+}
+
+CT RefreshClient::Refresh(const CC &cc, const CT &ct, usint period, uint32_t towersLeft) {
+  Begin(cc, ct, period, towersLeft);
+  return Finish();
+}
+
+void RefreshClient::Shutdown() {
+  if (fd < 0) return;
+  if (pending.valid()) pending.wait();
+  SendFrame(fd, REFRESH_MSG_SHUTDOWN, "");
+  CloseSocket(fd);
+  fd = -1;
+}
+
+void RefreshClient::Report(std::ostream &os) const {
+  if (stats.empty()) return;
+  size_t sent = 0, received = 0;
+  double roundTrip = 0, wait = 0;
+  for (auto &s : stats) {
+    sent += s.bytesSent;
+    received += s.bytesReceived;
+    roundTrip += s.roundTripMs;
+    wait += s.waitMs;
+  }
+  double n = stats.size();
+  os << "Remote refreshes: " << stats.size() << std::endl;
+  os << "\tmean bytes sent: " << sent / n << ", mean bytes received: " << received / n << std::endl;
+  os << "\tmean round trip: " << roundTrip / n << " ms, mean wait: " << wait / n << " ms ("
+     << ((roundTrip > 0) ? 100.0 * (1.0 - wait / roundTrip) : 0.0) << "% hidden)" << std::endl;
+}
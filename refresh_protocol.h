@@ -0,0 +1,149 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__REFRESH_PROTOCOL_H_
+#define DPRIVE_ML__REFRESH_PROTOCOL_H_
+
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "openfhe.h"
+#include "ciphertext-ser.h"
+#include "cryptocontext-ser.h"
+#include "key/key-ser.h"
+#include "scheme/ckksrns/ckksrns-ser.h"
+#include "lr_types.h"
+
+////////// Interactive refresh between the trainer and a key-holding refresh server ///////////////////////////////
+
+/* Messages exchanged with lr_refresh_server:
+ *   PROVISION  trainer -> server   crypto context, then the 4-byte row size of the packed data
+ *   KEYS       server -> trainer   public key, relinearization and automorphism keys, EvalSumRows/Cols key maps
+ *   REFRESH    trainer -> server   4-byte period (slots that hold distinct values), then the ciphertext
+ *   REFRESHED  server -> trainer   fresh encryption of the same values at the top level
+ *   DECRYPT    trainer -> server   4-byte number of values, then the ciphertext
+ *   DECRYPTED  server -> trainer   the leading values of the plaintext, as doubles
+ *   ERROR      server -> trainer   error message
+ *   SHUTDOWN   trainer -> server   stop serving
+ * The server generates the key pair when it is provisioned; the secret key never leaves it.
+ */
+enum RefreshMessage : uint32_t {
+  REFRESH_MSG_PROVISION = 1,
+  REFRESH_MSG_REFRESH = 2,
+  REFRESH_MSG_REFRESHED = 3,
+  REFRESH_MSG_ERROR = 4,
+  REFRESH_MSG_SHUTDOWN = 5,
+  REFRESH_MSG_KEYS = 6,
+  REFRESH_MSG_DECRYPT = 7,
+  REFRESH_MSG_DECRYPTED = 8,
+};
+
+template <class T>
+std::string SerializeToString(const T &obj) {
+  std::stringstream ss;
+  lbcrypto::Serial::Serialize(obj, ss, lbcrypto::SerType::BINARY);
+  return ss.str();
+}
+
+template <class T>
+void DeserializeFromString(T &obj, const std::string &bytes) {
+  std::stringstream ss(bytes);
+  lbcrypto::Serial::Deserialize(obj, ss, lbcrypto::SerType::BINARY);
+}
+
+/* The relinearization and automorphism keys registered under keyTag, as two blobs appended to payload, and
+ * the inverse, which registers them with the crypto context they were generated for.
+ */
+void AppendEvalKeys(std::string &payload, const std::string &keyTag);
+void LoadEvalKeys(const std::string &multKeys, const std::string &automorphismKeys);
+
+/* Server side of a refresh: decrypts ct, keeps the first period slots and re-encrypts them, tiled over
+ * the full batch, at the top level.
+ */
+CT RefreshCiphertext(CC &cc, const KeyPair &keys, const CT &ct, usint period);
+
+// What provisioning hands back to the trainer: everything it needs to train, but no secret key
+struct ProvisionedKeys {
+  KeyPair keys;  // publicKey only
+  MatKeys sumRowKeys;
+  MatKeys sumColKeys;
+};
+
+struct RefreshStats {
+  size_t bytesSent;
+  size_t bytesReceived;
+  double roundTripMs;  // from compressing the request to having the refreshed ciphertext
+  double waitMs;       // part of the round trip the training loop spent blocked
+};
+
+/* Trainer side. Before sending, ctWeights is compressed to towersLeft RNS towers, which cuts the
+ * request to a small fraction of a full ciphertext. Begin() starts a refresh in the background so the
+ * caller can keep working; Finish() blocks until the refreshed ciphertext is back.
+ */
+class RefreshClient {
+ public:
+  RefreshClient() = default;
+  ~RefreshClient();
+
+  void Connect(const std::string &socketPath);
+
+  /* Hands the crypto context to the server, which generates the key pair and the evaluation keys for data
+   * packed in rows of rowSize. The evaluation keys are registered with cc; the server is the only party
+   * that can decrypt.
+   */
+  ProvisionedKeys Provision(const CC &cc, usint rowSize);
+
+  // The first length values of ct, decrypted by the server. Waits for a refresh in flight first.
+  Vec Decrypt(const CT &ct, usint length);
+
+  void Begin(const CC &cc, const CT &ct, usint period, uint32_t towersLeft);
+  bool Pending() const { return pending.valid(); }
+  CT Finish();
+
+  // Begin() immediately followed by Finish()
+  CT Refresh(const CC &cc, const CT &ct, usint period, uint32_t towersLeft);
+
+  void Shutdown();
+
+  const std::vector<RefreshStats> &GetStats() const { return stats; }
+  void Report(std::ostream &os) const;
+
+ private:
+  int fd = -1;
+  std::future<CT> pending;
+  TimeVar beginTime;
+  size_t lastSent = 0;
+  size_t lastReceived = 0;
+  std::vector<RefreshStats> stats;
+};
+
+#endif //DPRIVE_ML__REFRESH_PROTOCOL_H_
@@ -0,0 +1,290 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "shard_engine.h"
+#include "ct_store.h"
+#include "exec_config.h"
+#include "he_tracer.h"
+#include "lr_train_funcs.h"
+#include "utils.h"
+
+std::vector<DataShard> EncryptShards(
+    CC &cc,
+    const Mat &X,
+    const Mat &NegXt,
+    const Mat &y,
+    usint rowSize,
+    usint numSlots,
+    usint rowsPerShard,
+    const KeyPair &keys,
+    const DataLevels &levels,
+    double logitScale
+) {
+  usint capacity = numSlots / rowSize;
+  if (rowsPerShard == 0 || rowsPerShard > capacity) rowsPerShard = capacity;
+
+  std::vector<DataShard> shards;
+  for (usint first = 0; first < X.size(); first += rowsPerShard) {
+    usint last = std::min(usint(X.size()), first + rowsPerShard);
+    Mat shardX(X.begin() + first, X.begin() + last);
+    Mat shardNegXt(NegXt.begin() + first, NegXt.begin() + last);
+    Mat shardY(y.begin() + first, y.begin() + last);
+    if (logitScale != 1.0) MatrixScalarMult(shardX, 1.0 / logitScale);
+
+    DataShard shard;
+    shard.ctX = Mat2CtMRM(cc, shardX, rowSize, numSlots, keys, levels.x);
+    // using mcm because NegXt is -X being transposed by packing.
+    shard.ctNegXt = Mat2CtMRM(cc, shardNegXt, rowSize, numSlots, keys, levels.negXt);
+    shard.ctLabels = OneDMat2CtVCC(cc, shardY, rowSize, numSlots, keys, levels.labels);
+    shard.firstRow = first;
+    shard.numRows = last - first;
+    shard.logitScale = logitScale;
+    shards.push_back(shard);
+  }
+  return shards;
+}
+
+ShardExecConfig SplitThreads(usint numShards, usint requestedWorkers, int totalThreads) {
+  if (totalThreads < 1) totalThreads = 1;
+  usint workers = (requestedWorkers > 0) ? requestedWorkers : std::min(numShards, usint(totalThreads));
+  workers = std::max(usint(1), std::min(workers, numShards));
+  int innerThreads = std::max(1, totalThreads / int(workers));
+  return ShardExecConfig{workers, innerThreads, {}};
+}
+
+ShardedGradientEngine::ShardedGradientEngine(
+    CC &cc,
+    std::vector<DataShard> shards,
+    usint rowSize,
+    const MatKeys &rowKeys,
+    const MatKeys &colKeys,
+    const KeyPair &keys,
+    const ShardExecConfig &config
+) : cc(cc), shards(std::move(shards)), rowSize(rowSize), rowKeys(rowKeys), colKeys(colKeys), keys(keys),
+    config(config) {
+  if (this->shards.empty()) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: no data shards"));
+  }
+  if (this->config.shardWorkers > 1) {
+    std::function<void(usint)> pinWorker;
+    if (!this->config.workerCpus.empty()) {
+      auto workerCpus = this->config.workerCpus;
+      int innerThreads = this->config.innerThreads;
+      pinWorker = [workerCpus, innerThreads](usint index) {
+        auto &cpus = workerCpus[index % workerCpus.size()];
+        PinCurrentThread(cpus);
+        PinOpenMPTeam(cpus, innerThreads);
+      };
+    }
+    pool.reset(new ThreadPool(this->config.shardWorkers, this->config.innerThreads, pinWorker));
+  }
+  if (pool && !this->config.workerCpus.empty()) {
+    // The shards were encrypted by the main thread team, so their pages sit where it ran. Each pinned worker
+    // copies the shards it owns (see ShardOwner) once, so first touch moves them to the worker's node.
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < this->shards.size(); i++) {
+      futures.push_back(pool->SubmitTo(ShardOwner(i), [this, i]() {
+        DataShard &shard = this->shards[i];
+        shard.ctX = shard.ctX->Clone();
+        shard.ctNegXt = shard.ctNegXt->Clone();
+        shard.ctLabels = shard.ctLabels->Clone();
+      }));
+    }
+    WaitAll(futures);
+  }
+}
+
+usint ShardedGradientEngine::ShardOwner(size_t shard) const {
+  return usint(shard % config.shardWorkers);
+}
+
+ShardedGradientEngine::ShardedGradientEngine(
+    CC &cc,
+    std::shared_ptr<ShardStream> stream,
+    usint rowSize,
+    const MatKeys &rowKeys,
+    const MatKeys &colKeys,
+    const KeyPair &keys,
+    const ShardExecConfig &config
+) : cc(cc), stream(std::move(stream)), rowSize(rowSize), rowKeys(rowKeys), colKeys(colKeys), keys(keys),
+    config(config) {
+  if (!this->stream || this->stream->NumShards() == 0) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: no data shards"));
+  }
+  // the shards come one at a time, so there is nothing to run side by side
+  this->config.shardWorkers = 1;
+  this->config.workerCpus.clear();
+}
+
+usint ShardedGradientEngine::NumShards() const {
+  return stream ? stream->NumShards() : shards.size();
+}
+
+void ShardedGradientEngine::CalculateGradient(
+    CT &ctThetas,
+    CT &ctGradStoreInto,
+    int chebRangeStart,
+    int chebRangeEnd,
+    int chebPolyDegree,
+    bool keepLogits,
+    SigmoidApprox sigmoidApprox
+) {
+  TimeVar t;
+  TIC(t);
+  if (stream) {
+    if (keepLogits) {
+      OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+          std::to_string(__LINE__) +
+          std::string("Error: the logits of streamed shards are not kept"));
+    }
+    lastStreamWaitMs = 0;
+    for (usint i = 0; i < stream->NumShards(); i++) {
+      DataShard shard = stream->Next();
+      lastStreamWaitMs += stream->LastWaitMs();
+      CT ctShardGradient;
+      EncLogRegCalculateGradient(cc, shard.ctX, shard.ctNegXt, shard.ctLabels, ctThetas,
+                                 ctShardGradient, rowSize, rowKeys, colKeys, keys, false,
+                                 chebRangeStart, chebRangeEnd, chebPolyDegree, 32, nullptr, sigmoidApprox,
+                                 shard.logitScale);
+      if (i == 0) {
+        ctGradStoreInto = ctShardGradient;
+      } else {
+        TracedEvalAddInPlace(cc, ctGradStoreInto, ctShardGradient);
+      }
+    }
+    lastShardMs = TOC(t);
+    lastReduceMs = 0;
+    return;
+  }
+  std::vector<CT> shardGradients(shards.size());
+  lastLogits.assign(keepLogits ? shards.size() : 0, nullptr);
+  if (!pool) {
+    for (size_t i = 0; i < shards.size(); i++) {
+      EncLogRegCalculateGradient(cc, shards[i].ctX, shards[i].ctNegXt, shards[i].ctLabels, ctThetas,
+                                 shardGradients[i], rowSize, rowKeys, colKeys, keys, false,
+                                 chebRangeStart, chebRangeEnd, chebPolyDegree, 32,
+                                 keepLogits ? &lastLogits[i] : nullptr, sigmoidApprox, shards[i].logitScale);
+    }
+  } else {
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < shards.size(); i++) {
+      auto task = [&, i]() {
+        CT ctThetasCopy = ctThetas;
+        EncLogRegCalculateGradient(cc, shards[i].ctX, shards[i].ctNegXt, shards[i].ctLabels, ctThetasCopy,
+                                   shardGradients[i], rowSize, rowKeys, colKeys, keys, false,
+                                   chebRangeStart, chebRangeEnd, chebPolyDegree, 32,
+                                   keepLogits ? &lastLogits[i] : nullptr, sigmoidApprox, shards[i].logitScale);
+      };
+      // pinned workers only run the shards they placed on their node
+      futures.push_back(config.workerCpus.empty() ? pool->Submit(task) : pool->SubmitTo(ShardOwner(i), task));
+    }
+    WaitAll(futures);
+  }
+  lastShardMs = TOC(t);
+
+  TIC(t);
+  ctGradStoreInto = TreeSum(shardGradients);
+  lastReduceMs = TOC(t);
+}
+
+CT ShardedGradientEngine::CalculateLoss(usint numSamples, int chebRangeStart, int chebRangeEnd,
+                                         int chebPolyDegree) {
+  if (lastLogits.empty()) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: CalculateGradient did not keep the logits"));
+  }
+  usint numSlots = cc->GetEncodingParams()->GetBatchSize();
+  if (lossMasks.empty()) {
+    for (auto &shard : shards) {
+      Vec mask(numSlots, 0.0);
+      for (usint r = 0; r < shard.numRows; r++) {
+        mask[r * rowSize] = shard.logitScale / numSamples;
+      }
+      lossMasks.push_back(cc->MakeCKKSPackedPlaintext(mask));
+    }
+  }
+
+  std::vector<CT> shardLosses(shards.size());
+  std::vector<std::future<void>> futures;
+  for (size_t i = 0; i < shards.size(); i++) {
+    auto shardLoss = [&, i]() {
+      shardLosses[i] = EncLogRegLoss(cc, lastLogits[i], shards[i].ctLabels, lossMasks[i], numSlots,
+                                     chebRangeStart, chebRangeEnd, chebPolyDegree, shards[i].logitScale);
+    };
+    if (pool) {
+      futures.push_back(config.workerCpus.empty() ? pool->Submit(shardLoss)
+                                                  : pool->SubmitTo(ShardOwner(i), shardLoss));
+    } else {
+      shardLoss();
+    }
+  }
+  WaitAll(futures);
+  lastLogits.clear();
+  return TreeSum(shardLosses);
+}
+
+CT ShardedGradientEngine::TreeSum(std::vector<CT> &terms) {
+  // pairwise sums: log2(#shards) rounds, the sums of a round are independent
+  for (size_t stride = 1; stride < terms.size(); stride *= 2) {
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i + stride < terms.size(); i += 2 * stride) {
+      auto addPair = [this, &terms, i, stride]() {
+        TracedEvalAddInPlace(cc, terms[i], terms[i + stride]);
+      };
+      if (pool) {
+        futures.push_back(pool->Submit(addPair));
+      } else {
+        addPair();
+      }
+    }
+    WaitAll(futures);
+  }
+  return terms[0];
+}
+
+void ShardedGradientEngine::PrintConfig(std::ostream &os) const {
+  if (stream) {
+    os << "Gradient shards: " << stream->NumShards() << " streamed from disk, one read ahead, "
+       << config.innerThreads << " OpenMP thread(s)" << std::endl;
+    return;
+  }
+  os << "Gradient shards: " << shards.size() << " (";
+  for (size_t i = 0; i < shards.size(); i++) {
+    os << shards[i].numRows << ((i + 1 < shards.size()) ? ", " : "");
+  }
+  os << " rows), " << config.shardWorkers << " shard worker(s) x " << config.innerThreads << " OpenMP thread(s)"
+     << (config.workerCpus.empty() ? "" : ", pinned") << std::endl;
+}
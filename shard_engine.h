@@ -0,0 +1,171 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__SHARD_ENGINE_H_
+#define DPRIVE_ML__SHARD_ENGINE_H_
+
+#include <memory>
+#include <vector>
+#include "openfhe.h"
+#include "cheb_cache.h"
+#include "lr_types.h"
+#include "param_planner.h"
+#include "thread_pool.h"
+
+////////// Data-parallel gradient computation over ciphertext shards ///////////////////////////////
+
+class ShardStream;
+
+/* A block of consecutive training rows, packed the same way as the single-ciphertext data:
+ * X and -X' (already scaled by the learning rate) row major, the labels column cloned.
+ */
+struct DataShard {
+  CT ctX;
+  CT ctNegXt;
+  CT ctLabels;
+  usint firstRow;
+  usint numRows;
+  double logitScale = 1.0;  // ctX holds X / logitScale (see UsesPowerSeries)
+};
+
+/* Splits the rows of X, NegXt and y into shards of at most rowsPerShard rows (0 or anything above
+ * the ciphertext capacity means the capacity, numSlots / rowSize) and encrypts each shard at the
+ * given levels (see GradientDataLevels). X is encrypted divided by logitScale, which the gradient and
+ * the loss then undo.
+ */
+std::vector<DataShard> EncryptShards(
+    CC &cc,
+    const Mat &X,
+    const Mat &NegXt,
+    const Mat &y,
+    usint rowSize,
+    usint numSlots,
+    usint rowsPerShard,
+    const KeyPair &keys,
+    const DataLevels &levels = DataLevels{0, 0, 0},
+    double logitScale = 1.0
+);
+
+/* How the cores are split: shardWorkers shard gradients run at once, each with innerThreads
+ * OpenMP threads for OpenFHE's internal parallelism.
+ */
+struct ShardExecConfig {
+  usint shardWorkers;
+  int innerThreads;
+  std::vector<std::vector<int>> workerCpus;  // CPUs per worker (ExecConfig::WorkerCpus); empty: no pinning
+};
+
+/* requestedWorkers == 0 picks one worker per shard, up to totalThreads. The OpenMP threads are split
+ * evenly among the workers.
+ */
+ShardExecConfig SplitThreads(usint numShards, usint requestedWorkers, int totalThreads);
+
+/* Runs EncLogRegCalculateGradient on every shard and sums the shard gradients with a pairwise tree.
+ * With one worker everything runs on the calling thread, exactly like the unsharded code. With pinned
+ * workers (config.workerCpus), each shard belongs to one worker, which copies it onto its node at
+ * construction and runs all of its gradients.
+ */
+class ShardedGradientEngine {
+ public:
+  ShardedGradientEngine(
+      CC &cc,
+      std::vector<DataShard> shards,
+      usint rowSize,
+      const MatKeys &rowKeys,
+      const MatKeys &colKeys,
+      const KeyPair &keys,
+      const ShardExecConfig &config
+  );
+
+  /* Reads the shards from an on-disk store (see ShardStream) instead of holding them. They run one after
+   * the other on the calling thread, and each gradient is added to the running sum as it finishes, so
+   * only two shards and the sum are in memory. Keeping the logits for CalculateLoss is not supported.
+   */
+  ShardedGradientEngine(
+      CC &cc,
+      std::shared_ptr<ShardStream> stream,
+      usint rowSize,
+      const MatKeys &rowKeys,
+      const MatKeys &colKeys,
+      const KeyPair &keys,
+      const ShardExecConfig &config
+  );
+
+  // keepLogits holds on to every shard's logits for a following CalculateLoss
+  void CalculateGradient(
+      CT &ctThetas,
+      CT &ctGradStoreInto,
+      int chebRangeStart,
+      int chebRangeEnd,
+      int chebPolyDegree,
+      bool keepLogits = false,
+      SigmoidApprox sigmoidApprox = SIGMOID_CHEBYSHEV
+  );
+
+  bool HasLogits() const { return !lastLogits.empty(); }
+  const CT &Logits(usint shard) const { return lastLogits[shard]; }
+
+  /* Encrypted mean cross-entropy loss over numSamples rows, from the logits kept by the last
+   * CalculateGradient (see EncLogRegLoss). The shard losses are summed with the same tree as the
+   * gradients. Releases the kept logits.
+   */
+  CT CalculateLoss(usint numSamples, int chebRangeStart, int chebRangeEnd, int chebPolyDegree);
+
+  usint NumShards() const;
+  const ShardExecConfig &Config() const { return config; }
+  double LastShardMs() const { return lastShardMs; }
+  double LastReduceMs() const { return lastReduceMs; }
+  // Time the last CalculateGradient waited for shards the stream had not read yet
+  double LastStreamWaitMs() const { return lastStreamWaitMs; }
+
+  void PrintConfig(std::ostream &os) const;
+
+ private:
+  CT TreeSum(std::vector<CT> &terms);
+  usint ShardOwner(size_t shard) const;
+
+  CC cc;
+  std::vector<DataShard> shards;
+  std::shared_ptr<ShardStream> stream;
+  usint rowSize;
+  MatKeys rowKeys;
+  MatKeys colKeys;
+  KeyPair keys;
+  ShardExecConfig config;
+  std::unique_ptr<ThreadPool> pool;
+  std::vector<CT> lastLogits;
+  std::vector<PT> lossMasks;  // per shard, built on the first CalculateLoss
+  double lastShardMs = 0;
+  double lastReduceMs = 0;
+  double lastStreamWaitMs = 0;
+};
+
+#endif //DPRIVE_ML__SHARD_ENGINE_H_
@@ -0,0 +1,147 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "sigmoid_schedule.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "openfhe.h"
+#include "param_planner.h"
+
+SigmoidSchedule SigmoidSchedule::Fixed(uint32_t degree, int rangeStart, int rangeEnd) {
+  SigmoidSchedule schedule;
+  schedule.Append(SigmoidStage{0, degree, rangeStart, rangeEnd});
+  return schedule;
+}
+
+SigmoidSchedule SigmoidSchedule::Parse(const std::string &spec) {
+  SigmoidSchedule schedule;
+  std::stringstream ss(spec);
+  std::string entry;
+  while (getline(ss, entry, ',')) {
+    usint firstIteration;
+    uint32_t degree;
+    int bound;
+    char sep1, sep2;
+    std::stringstream es(entry);
+    if (!(es >> firstIteration >> sep1 >> degree >> sep2 >> bound) || sep1 != ':' || sep2 != ':' || bound <= 0 ||
+        degree == 0 || (schedule.stages.empty() && firstIteration != 0) ||
+        (!schedule.stages.empty() && firstIteration <= schedule.stages.back().firstIteration)) {
+      OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+          std::to_string(__LINE__) +
+          std::string("Error: bad sigmoid schedule entry '") + entry +
+          "', expected ascending iteration:degree:bound entries starting at iteration 0");
+    }
+    schedule.Append(SigmoidStage{firstIteration, degree, -bound, bound});
+  }
+  if (schedule.stages.empty()) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: empty sigmoid schedule"));
+  }
+  return schedule;
+}
+
+SigmoidSchedule SigmoidSchedule::FromDataBound(const Mat &X, double gradientScale, double momentum, usint numIters,
+                                               uint32_t maxDegree, int maxBound) {
+  double maxRowNorm = 0;
+  double meanRowNorm = 0;
+  for (auto &row : X) {
+    double norm = 0;
+    for (auto v : row) norm += v * v;
+    norm = std::sqrt(norm);
+    maxRowNorm = std::max(maxRowNorm, norm);
+    meanRowNorm += norm / X.size();
+  }
+  double gradientBound = gradientScale * meanRowNorm;
+
+  SigmoidSchedule schedule;
+  // bounds on |phi_k| and on |theta_k - phi_k|; theta and phi start at 0
+  double phiBound = 0;
+  double leadBound = 0;
+  for (usint k = 0; k < numIters; k++) {
+    // the gradient of iteration k is taken at theta_k
+    double logitBound = maxRowNorm * (phiBound + leadBound);
+    int bound = int(std::max(1.0, std::min(double(maxBound), std::ceil(logitBound))));
+    uint32_t needed = uint32_t(std::ceil(double(maxDegree) * bound / maxBound));
+    uint32_t degree = maxDegree;
+    for (uint32_t depth = ChebyshevDepth(1); depth < ChebyshevDepth(maxDegree); depth++) {
+      if (ChebyshevMaxDegree(depth) >= needed) {
+        degree = ChebyshevMaxDegree(depth);
+        break;
+      }
+    }
+    bound = std::max(bound, std::min(maxBound, int(std::floor(double(maxBound) * degree / maxDegree))));
+    schedule.Append(SigmoidStage{k, degree, -bound, bound});
+
+    // phi' = theta - g;  theta' = phi' + momentum * (phi' - phi), momentum only from the second iteration on.
+    // The step phi' - phi = (theta - phi) - g stays below gradientBound / (1 - momentum), so the bound grows
+    // linearly
+    double stepBound = leadBound + gradientBound;
+    phiBound += stepBound;
+    leadBound = (k == 0) ? 0 : momentum * stepBound;
+  }
+  return schedule;
+}
+
+void SigmoidSchedule::Append(const SigmoidStage &stage) {
+  if (!stages.empty() && stages.back().degree == stage.degree && stages.back().rangeStart == stage.rangeStart &&
+      stages.back().rangeEnd == stage.rangeEnd) {
+    return;
+  }
+  stages.push_back(stage);
+}
+
+const SigmoidStage &SigmoidSchedule::At(usint iteration) const {
+  auto next = std::upper_bound(stages.begin(), stages.end(), iteration,
+                               [](usint i, const SigmoidStage &stage) { return i < stage.firstIteration; });
+  return *(next - 1);
+}
+
+uint32_t SigmoidSchedule::MaxDegree() const {
+  uint32_t degree = 0;
+  for (auto &stage : stages) degree = std::max(degree, stage.degree);
+  return degree;
+}
+
+uint32_t SigmoidSchedule::MinDegree() const {
+  uint32_t degree = stages.front().degree;
+  for (auto &stage : stages) degree = std::min(degree, stage.degree);
+  return degree;
+}
+
+void SigmoidSchedule::Print(std::ostream &os) const {
+  os << "Sigmoid schedule:" << std::endl;
+  for (auto &stage : stages) {
+    os << "\tfrom iteration " << stage.firstIteration << ": degree " << stage.degree << " over ["
+       << stage.rangeStart << ", " << stage.rangeEnd << "]" << std::endl;
+  }
+}
@@ -0,0 +1,89 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__SIGMOID_SCHEDULE_H_
+#define DPRIVE_ML__SIGMOID_SCHEDULE_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "lr_types.h"
+
+////////// Per-iteration degree and interval of the sigmoid approximation ///////////////////////////////
+
+// From iteration firstIteration on, the sigmoid is approximated at this degree over [rangeStart, rangeEnd]
+struct SigmoidStage {
+  usint firstIteration;
+  uint32_t degree;
+  int rangeStart;
+  int rangeEnd;
+};
+
+/* Early NAG iterations start from weights near zero, so their logits are small and a narrow interval with
+ * a low degree approximates the sigmoid just as well as the full one. The stages are ordered by
+ * firstIteration, and the first one starts at iteration 0.
+ */
+class SigmoidSchedule {
+ public:
+  SigmoidSchedule() = default;
+
+  // One stage for the whole run
+  static SigmoidSchedule Fixed(uint32_t degree, int rangeStart, int rangeEnd);
+
+  /* "iteration:degree:bound,...": from iteration on, the given degree over [-bound, bound].
+   * e.g. "0:13:4,10:27:8,30:59:16"
+   */
+  static SigmoidSchedule Parse(const std::string &spec);
+
+  /* Derived from a plaintext bound on the logits. |x_i . theta_k| <= max_i |x_i| * |theta_k|, and |theta_k|
+   * is bounded by running the NAG update on norms: the gradient norm is at most gradientScale * mean_i |x_i|,
+   * since |sigmoid(z) - y| <= 1 (gradientScale is the learning rate; -X' already carries the 1 / n). Each
+   * iteration gets the smallest depth-maximal degree (see ChebyshevMaxDegree) that keeps maxDegree's ratio of
+   * degree to interval width, which keeps the approximation error about the same. The interval is then widened
+   * to what that degree covers, so the stages only change with the degree. Bounds are capped at maxBound.
+   */
+  static SigmoidSchedule FromDataBound(const Mat &X, double gradientScale, double momentum, usint numIters,
+                                       uint32_t maxDegree, int maxBound);
+
+  const SigmoidStage &At(usint iteration) const;
+  const std::vector<SigmoidStage> &Stages() const { return stages; }
+  uint32_t MaxDegree() const;
+  uint32_t MinDegree() const;
+
+  void Print(std::ostream &os) const;
+
+ private:
+  void Append(const SigmoidStage &stage);
+
+  std::vector<SigmoidStage> stages;
+};
+
+#endif //DPRIVE_ML__SIGMOID_SCHEDULE_H_
@@ -0,0 +1,167 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "socket_io.h"
+#include "openfhe.h"
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static void ThrowSocketError(const std::string &where, const std::string &what) {
+  OPENFHE_THROW(__FILE__ + std::string(" ") + where + std::string(": ") + what + ": " + std::strerror(errno));
+}
+
+static sockaddr_un MakeAddress(const std::string &path) {
+  sockaddr_un addr{};
+  if (path.size() >= sizeof(addr.sun_path)) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: socket path is too long: ") + path);
+  }
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return addr;
+}
+
+int ListenUnixSocket(const std::string &path, int backlog) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) ThrowSocketError(__FUNCTION__, "socket");
+  auto addr = MakeAddress(path);
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) ThrowSocketError(__FUNCTION__, "bind " + path);
+  if (listen(fd, backlog) < 0) ThrowSocketError(__FUNCTION__, "listen " + path);
+  return fd;
+}
+
+int AcceptUnixSocket(int listenFd) {
+  int fd;
+  do {
+    fd = accept(listenFd, nullptr, nullptr);
+  } while (fd < 0 && errno == EINTR);
+  if (fd < 0) ThrowSocketError(__FUNCTION__, "accept");
+  return fd;
+}
+
+int ConnectUnixSocket(const std::string &path, usint retries) {
+  auto addr = MakeAddress(path);
+  for (usint attempt = 0; ; attempt++) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) ThrowSocketError(__FUNCTION__, "socket");
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0) return fd;
+    close(fd);
+    if (attempt >= retries) ThrowSocketError(__FUNCTION__, "connect " + path);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
+void CloseSocket(int fd) {
+  if (fd >= 0) close(fd);
+}
+
+bool PeerIsSameUser(int fd) {
+  ucred peer{};
+  socklen_t len = sizeof(peer);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &len) < 0) return false;
+  return peer.uid == getuid() || peer.uid == 0;
+}
+
+static void WriteAll(int fd, const char *data, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, data, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) ThrowSocketError("WriteAll", "write");
+    data += n;
+    len -= n;
+  }
+}
+
+// Returns false on end of stream before the first byte
+static bool ReadAll(int fd, char *data, size_t len) {
+  size_t got = 0;
+  while (got < len) {
+    ssize_t n = read(fd, data + got, len - got);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) ThrowSocketError("ReadAll", "read");
+    if (n == 0) {
+      if (got == 0) return false;
+      OPENFHE_THROW(__FILE__ + std::string(" ReadAll: connection closed in the middle of a frame"));
+    }
+    got += n;
+  }
+  return true;
+}
+
+size_t SendFrame(int fd, uint32_t type, const std::string &payload) {
+  uint64_t len = payload.size();
+  char header[sizeof(type) + sizeof(len)];
+  std::memcpy(header, &type, sizeof(type));
+  std::memcpy(header + sizeof(type), &len, sizeof(len));
+  WriteAll(fd, header, sizeof(header));
+  WriteAll(fd, payload.data(), payload.size());
+  return sizeof(header) + payload.size();
+}
+
+bool RecvFrame(int fd, uint32_t &type, std::string &payload) {
+  uint64_t len;
+  char header[sizeof(type) + sizeof(len)];
+  if (!ReadAll(fd, header, sizeof(header))) return false;
+  std::memcpy(&type, header, sizeof(type));
+  std::memcpy(&len, header + sizeof(type), sizeof(len));
+  payload.resize(len);
+  if (len > 0 && !ReadAll(fd, &payload[0], len)) {
+    OPENFHE_THROW(__FILE__ + std::string(" RecvFrame: connection closed in the middle of a frame"));
+  }
+  return true;
+}
+
+void AppendBlob(std::string &payload, const std::string &blob) {
+  uint64_t len = blob.size();
+  payload.append(reinterpret_cast<const char *>(&len), sizeof(len));
+  payload.append(blob);
+}
+
+std::vector<std::string> SplitBlobs(const std::string &payload) {
+  std::vector<std::string> blobs;
+  size_t pos = 0;
+  while (pos + sizeof(uint64_t) <= payload.size()) {
+    uint64_t len;
+    std::memcpy(&len, payload.data() + pos, sizeof(len));
+    pos += sizeof(len);
+    if (pos + len > payload.size()) break;
+    blobs.push_back(payload.substr(pos, len));
+    pos += len;
+  }
+  return blobs;
+}
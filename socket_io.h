@@ -0,0 +1,76 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__SOCKET_IO_H_
+#define DPRIVE_ML__SOCKET_IO_H_
+
+#include <string>
+#include <vector>
+#include "lr_types.h"
+
+////////// Framed messages over local (Unix domain) sockets ///////////////////////////////
+
+/* Creates, binds and listens on a Unix domain socket at path (an existing socket file is replaced).
+ * backlog is the number of connections that may wait for AcceptUnixSocket.
+ */
+int ListenUnixSocket(const std::string &path, int backlog = 1);
+
+/* Blocks until a peer connects to listenFd.
+ */
+int AcceptUnixSocket(int listenFd);
+
+/* Connects to the Unix domain socket at path, retrying every 100 ms up to retries times so a server
+ * started at the same time has a chance to come up.
+ */
+int ConnectUnixSocket(const std::string &path, usint retries = 50);
+
+void CloseSocket(int fd);
+
+/* True if the process at the other end of a connected Unix socket runs as the same user as this one, or as
+ * root (SO_PEERCRED).
+ */
+bool PeerIsSameUser(int fd);
+
+/* A frame is a 4-byte message type, an 8-byte payload length and the payload.
+ * Returns the number of bytes written to the socket.
+ */
+size_t SendFrame(int fd, uint32_t type, const std::string &payload);
+
+/* Reads one frame. Returns false if the peer closed the connection before a new frame started.
+ */
+bool RecvFrame(int fd, uint32_t &type, std::string &payload);
+
+/* Payloads made of several variable-length parts carry each one as an 8-byte length and the bytes.
+ */
+void AppendBlob(std::string &payload, const std::string &blob);
+std::vector<std::string> SplitBlobs(const std::string &payload);
+
+#endif //DPRIVE_ML__SOCKET_IO_H_
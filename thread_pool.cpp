@@ -0,0 +1,89 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "thread_pool.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+ThreadPool::ThreadPool(usint numWorkers, int innerThreads, std::function<void(usint)> workerInit)
+    : innerThreads(innerThreads), workerInit(std::move(workerInit)) {
+  if (numWorkers == 0) numWorkers = 1;
+  workerTasks.resize(numWorkers);
+  for (usint i = 0; i < numWorkers; i++) {
+    workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  cv.notify_all();
+  for (auto &worker : workers) worker.join();
+}
+
+void ThreadPool::WorkerLoop(usint index) {
+#ifdef _OPENMP
+  // the OpenMP thread count is a per-thread setting, so this only affects regions started by this worker
+  if (innerThreads > 0) omp_set_num_threads(innerThreads);
+#endif
+  if (workerInit) workerInit(index);
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      auto &ownTasks = workerTasks[index];
+      cv.wait(lock, [this, &ownTasks]() { return stopping || !ownTasks.empty() || !tasks.empty(); });
+      if (stopping && ownTasks.empty() && tasks.empty()) return;
+      // tasks bound to this worker first
+      auto &queue = ownTasks.empty() ? tasks : ownTasks;
+      task = std::move(queue.front());
+      queue.pop();
+    }
+    task();
+  }
+}
+
+void WaitAll(std::vector<std::future<void>> &futures) {
+  std::exception_ptr first;
+  for (auto &f : futures) {
+    try {
+      f.get();
+    } catch (...) {
+      if (!first) first = std::current_exception();
+    }
+  }
+  futures.clear();
+  if (first) std::rethrow_exception(first);
+}
@@ -0,0 +1,105 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__THREAD_POOL_H_
+#define DPRIVE_ML__THREAD_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "lr_types.h"
+
+////////// Fixed-size worker pool for coarse-grained HE tasks ///////////////////////////////
+
+/* Each worker sets its own OpenMP thread count to innerThreads before taking tasks, so the
+ * OpenMP regions OpenFHE opens inside a task (NTTs, per-tower loops) use innerThreads threads.
+ * numWorkers x innerThreads should not exceed the cores available. workerInit, if given, runs on
+ * every worker (with its index) before the first task, e.g. to pin the worker and its OpenMP team.
+ */
+class ThreadPool {
+ public:
+  ThreadPool(usint numWorkers, int innerThreads, std::function<void(usint)> workerInit = nullptr);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  template<typename F>
+  std::future<void> Submit(F &&task) {
+    auto packaged = std::make_shared<std::packaged_task<void()>>(std::forward<F>(task));
+    auto future = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.emplace([packaged]() { (*packaged)(); });
+    }
+    cv.notify_one();
+    return future;
+  }
+
+  // Like Submit, but only worker index (mod NumWorkers()) runs the task, e.g. to keep its data on its node
+  template<typename F>
+  std::future<void> SubmitTo(usint worker, F &&task) {
+    auto packaged = std::make_shared<std::packaged_task<void()>>(std::forward<F>(task));
+    auto future = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      workerTasks[worker % workerTasks.size()].emplace([packaged]() { (*packaged)(); });
+    }
+    // every worker waits on the same condition variable, so wake them all to reach the owner
+    cv.notify_all();
+    return future;
+  }
+
+  usint NumWorkers() const { return workers.size(); }
+  int InnerThreads() const { return innerThreads; }
+
+ private:
+  void WorkerLoop(usint index);
+
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::vector<std::queue<std::function<void()>>> workerTasks;  // tasks bound to one worker (SubmitTo)
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopping = false;
+  int innerThreads;
+  std::function<void(usint)> workerInit;
+};
+
+// Waits for all futures, rethrowing the first exception a task raised
+void WaitAll(std::vector<std::future<void>> &futures);
+
+#endif //DPRIVE_ML__THREAD_POOL_H_
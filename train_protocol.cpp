@@ -0,0 +1,183 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#include "train_protocol.h"
+#include "socket_io.h"
+
+TrainClient::~TrainClient() {
+  CloseSocket(fd);
+}
+
+void TrainClient::Connect(const std::string &socketPath) {
+  fd = ConnectUnixSocket(socketPath);
+}
+
+std::string TrainClient::Expect(uint32_t expected, const MetricHandler &onMetric, const RefreshHandler &onRefresh) {
+  uint32_t type;
+  std::string payload;
+  while (true) {
+    if (!RecvFrame(fd, type, payload)) {
+      OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+          std::to_string(__LINE__) +
+          std::string("Error: training daemon closed the connection"));
+    }
+    if (type == TRAIN_MSG_ERROR) {
+      OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+          std::to_string(__LINE__) +
+          std::string("Error from training daemon: ") + payload);
+    }
+    if (type == TRAIN_MSG_METRIC && expected != TRAIN_MSG_METRIC) {
+      auto blobs = SplitBlobs(payload);
+      TrainMetric metric;
+      if (!onMetric || blobs.empty() || !PodFromString(metric, blobs[0])) continue;
+      CT ctLoss;
+      if (metric.hasLoss && blobs.size() == 2) DeserializeFromString(ctLoss, blobs[1]);
+      onMetric(metric, ctLoss);
+      continue;
+    }
+    if (type == TRAIN_MSG_REFRESH && expected != TRAIN_MSG_REFRESH) {
+      if (!onRefresh || payload.size() < sizeof(uint32_t)) {
+        OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+            std::to_string(__LINE__) +
+            std::string("Error: unexpected REFRESH request"));
+      }
+      uint32_t period;
+      std::memcpy(&period, payload.data(), sizeof(period));
+      CT ct;
+      DeserializeFromString(ct, payload.substr(sizeof(period)));
+      SendFrame(fd, TRAIN_MSG_REFRESHED, SerializeToString(onRefresh(ct, period)));
+      continue;
+    }
+    if (type != expected) {
+      OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+          std::to_string(__LINE__) +
+          std::string("Error: unexpected message type ") + std::to_string(type));
+    }
+    return payload;
+  }
+}
+
+TrainContextInfo TrainClient::RequestContext(const TrainingContextSpec &spec, CC &cc) {
+  SendFrame(fd, TRAIN_MSG_CONTEXT, PodToString(spec));
+  auto blobs = SplitBlobs(Expect(TRAIN_MSG_CONTEXT_READY));
+  TrainContextInfo info;
+  if (blobs.size() != 2 || !PodFromString(info, blobs[0])) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: malformed CONTEXT_READY message"));
+  }
+  DeserializeFromString(cc, blobs[1]);
+  return info;
+}
+
+std::string SerializeTrainingKeys(const TrainingContext &keyCtx) {
+  std::string keys;
+  AppendBlob(keys, SerializeToString(keyCtx.keys.publicKey));
+  AppendEvalKeys(keys, keyCtx.keys.publicKey->GetKeyTag());
+  AppendBlob(keys, SerializeToString(*keyCtx.rowKeys));
+  AppendBlob(keys, SerializeToString(*keyCtx.colKeys));
+  return keys;
+}
+
+static bool KeysResident(const std::string &reply) {
+  uint32_t resident;
+  if (!PodFromString(resident, reply)) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: malformed KEYS_READY message"));
+  }
+  return resident != 0;
+}
+
+void TrainClient::SendKeys(uint32_t contextId, const std::string &keys, bool keep) {
+  std::string payload;
+  AppendBlob(payload, PodToString(contextId));
+  AppendBlob(payload, PodToString(uint32_t(keep ? 1 : 0)));
+  // keys is a sequence of blobs already
+  payload.append(keys);
+  size_t sent = SendFrame(fd, TRAIN_MSG_KEYS, payload);
+  KeysResident(Expect(TRAIN_MSG_KEYS_READY));
+  std::cout << "\tSent the public and evaluation keys (" << sent << " bytes)" << std::endl;
+}
+
+bool TrainClient::UseKeys(uint32_t contextId, const std::string &keyTag) {
+  std::string payload;
+  AppendBlob(payload, PodToString(contextId));
+  AppendBlob(payload, keyTag);
+  SendFrame(fd, TRAIN_MSG_USE_KEYS, payload);
+  return KeysResident(Expect(TRAIN_MSG_KEYS_READY));
+}
+
+void TrainClient::ReleaseKeys(const std::string &keyTag) {
+  SendFrame(fd, TRAIN_MSG_RELEASE_KEYS, keyTag);
+  KeysResident(Expect(TRAIN_MSG_KEYS_READY));
+}
+
+CT TrainClient::Train(uint32_t contextId, const NagJob &job, const std::vector<DataShard> &shards,
+                      const MetricHandler &onMetric, const RefreshHandler &onRefresh, TrainJobSummary &summary) {
+  std::string payload;
+  AppendBlob(payload, PodToString(TrainJobHeader{contextId, job, usint(shards.size())}));
+  for (auto &shard : shards) {
+    AppendBlob(payload, PodToString(TrainShardRows{shard.firstRow, shard.numRows}));
+    AppendBlob(payload, SerializeToString(shard.ctX));
+    AppendBlob(payload, SerializeToString(shard.ctNegXt));
+    AppendBlob(payload, SerializeToString(shard.ctLabels));
+  }
+  size_t sent = SendFrame(fd, TRAIN_MSG_JOB, payload);
+
+  TrainJobAccepted accepted;
+  PodFromString(accepted, Expect(TRAIN_MSG_ACCEPTED));
+  std::cout << "\tJob " << accepted.jobId << " accepted (" << sent << " bytes), " << accepted.jobsAhead
+            << " job(s) ahead" << std::endl;
+
+  auto blobs = SplitBlobs(Expect(TRAIN_MSG_WEIGHTS, onMetric, onRefresh));
+  if (blobs.size() != 2 || !PodFromString(summary, blobs[0])) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error: malformed WEIGHTS message"));
+  }
+  CT ctTheta;
+  DeserializeFromString(ctTheta, blobs[1]);
+  return ctTheta;
+}
+
+void TrainClient::ShutdownDaemon() {
+  if (fd < 0) return;
+  SendFrame(fd, TRAIN_MSG_SHUTDOWN, "");
+  // the daemon closes the connection once it accepted the request and answers with an ERROR otherwise
+  uint32_t type;
+  std::string payload;
+  if (RecvFrame(fd, type, payload) && type == TRAIN_MSG_ERROR) {
+    OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
+        std::to_string(__LINE__) +
+        std::string("Error from training daemon: ") + payload);
+  }
+}
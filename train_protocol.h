@@ -0,0 +1,187 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2023, Duality Technologies Inc.
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+#ifndef DPRIVE_ML__TRAIN_PROTOCOL_H_
+#define DPRIVE_ML__TRAIN_PROTOCOL_H_
+
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "openfhe.h"
+#include "lr_types.h"
+#include "nag_trainer.h"
+#include "refresh_protocol.h"
+#include "shard_engine.h"
+
+////////// Training jobs submitted to lr_train_daemon ///////////////////////////////
+
+/* Messages exchanged with lr_train_daemon:
+ *   CONTEXT        client -> daemon   TrainingContextSpec
+ *   CONTEXT_READY  daemon -> client   TrainContextInfo, then the crypto context
+ *   KEYS           client -> daemon   context id, a 4-byte keep flag, then the keys (see SerializeTrainingKeys);
+ *                                     they serve the connection's jobs on that context. With keep, the daemon
+ *                                     holds on to them after the connection closes, until a RELEASE_KEYS
+ *   USE_KEYS       client -> daemon   context id and key tag of keys kept from an earlier connection
+ *   RELEASE_KEYS   client -> daemon   key tag of kept keys to drop once no job uses them
+ *   KEYS_READY     daemon -> client   4 bytes: 1 if the keys are now resident for the connection, 0 otherwise
+ *   JOB            client -> daemon   TrainJobHeader, then per shard its TrainShardRows and the ciphertexts
+ *                                     X, -gamma X' / n and y
+ *   ACCEPTED       daemon -> client   TrainJobAccepted
+ *   METRIC         daemon -> client   TrainMetric after every iteration, then the encrypted loss if hasLoss
+ *   REFRESH        daemon -> client   4-byte period, then the weights to re-encrypt (interactive jobs)
+ *   REFRESHED      client -> daemon   the re-encrypted weights
+ *   WEIGHTS        daemon -> client   TrainJobSummary, then the encrypted theta
+ *   ERROR          daemon -> client   error message
+ *   SHUTDOWN       client -> daemon   stop accepting connections and exit once the running jobs are done;
+ *                                     only honored for a client running as the daemon's user
+ * The parts of a message are blobs (see AppendBlob). The fixed-size parts are plain structs copied byte for
+ * byte: client and daemon run on the same host. The client generates the key pair and keeps the secret key;
+ * the daemon only ever sees ciphertexts and evaluation keys.
+ */
+enum TrainMessage : uint32_t {
+  TRAIN_MSG_CONTEXT = 1,
+  TRAIN_MSG_CONTEXT_READY = 2,
+  TRAIN_MSG_JOB = 3,
+  TRAIN_MSG_ACCEPTED = 4,
+  TRAIN_MSG_METRIC = 5,
+  TRAIN_MSG_WEIGHTS = 6,
+  TRAIN_MSG_ERROR = 7,
+  TRAIN_MSG_SHUTDOWN = 8,
+  TRAIN_MSG_KEYS = 9,
+  TRAIN_MSG_KEYS_READY = 10,
+  TRAIN_MSG_REFRESH = 11,
+  TRAIN_MSG_REFRESHED = 12,
+  TRAIN_MSG_USE_KEYS = 13,
+  TRAIN_MSG_RELEASE_KEYS = 14,
+};
+
+struct TrainContextInfo {
+  uint32_t contextId;
+  usint rowSize;
+  usint numSlots;
+  uint32_t numSlotsBoot;  // slots of the bootstrapping keys, if the context bootstraps
+  DataLevels dataLevels;  // levels to encrypt the job's data at
+  uint32_t created;       // 1 if this request had to create the context
+  double setupSeconds;    // time it took to create the context
+};
+
+struct TrainJobHeader {
+  uint32_t contextId;
+  NagJob job;
+  usint numShards;
+};
+
+struct TrainShardRows {
+  usint firstRow;
+  usint numRows;
+};
+
+struct TrainJobAccepted {
+  uint32_t jobId;
+  uint32_t jobsAhead;  // jobs queued or running when this one was accepted
+};
+
+struct TrainMetric {
+  uint32_t jobId;
+  uint32_t iteration;
+  uint32_t refreshed;
+  uint32_t levelsBefore;
+  uint32_t chebDegree;
+  double ms;
+  uint32_t hasLoss;  // the encrypted loss follows, for the client to decrypt
+};
+
+struct TrainJobSummary {
+  uint32_t jobId;
+  usint numRefreshes;
+  double queueSeconds;
+  double trainSeconds;
+};
+
+template <class T>
+std::string PodToString(const T &pod) {
+  static_assert(std::is_trivially_copyable<T>::value, "only plain structs go over the wire as bytes");
+  return std::string(reinterpret_cast<const char *>(&pod), sizeof(T));
+}
+
+template <class T>
+bool PodFromString(T &pod, const std::string &bytes) {
+  static_assert(std::is_trivially_copyable<T>::value, "only plain structs go over the wire as bytes");
+  if (bytes.size() != sizeof(T)) return false;
+  std::memcpy(&pod, bytes.data(), sizeof(T));
+  return true;
+}
+
+// The public key, the relinearization and automorphism keys and the EvalSumRows/Cols key maps of keyCtx
+std::string SerializeTrainingKeys(const TrainingContext &keyCtx);
+
+/* Client side. One job at a time per connection: Train() blocks until the weights are back, passing
+ * every METRIC to onMetric and every REFRESH to onRefresh as they arrive.
+ */
+class TrainClient {
+ public:
+  using MetricHandler = std::function<void(const TrainMetric &, const CT &ctLoss)>;
+  using RefreshHandler = std::function<CT(const CT &ct, usint period)>;
+
+  TrainClient() = default;
+  ~TrainClient();
+
+  void Connect(const std::string &socketPath);
+
+  // The daemon's context for spec (created if no resident one serves it); it holds no keys
+  TrainContextInfo RequestContext(const TrainingContextSpec &spec, CC &cc);
+
+  /* Uploads keys (see SerializeTrainingKeys) for the jobs on contextId. With keep, they stay resident in the
+   * daemon for later connections (see UseKeys) until ReleaseKeys.
+   */
+  void SendKeys(uint32_t contextId, const std::string &keys, bool keep);
+
+  // True if the daemon still holds the kept keys with keyTag for contextId; they then serve this connection
+  bool UseKeys(uint32_t contextId, const std::string &keyTag);
+
+  void ReleaseKeys(const std::string &keyTag);
+
+  CT Train(uint32_t contextId, const NagJob &job, const std::vector<DataShard> &shards,
+           const MetricHandler &onMetric, const RefreshHandler &onRefresh, TrainJobSummary &summary);
+
+  // Throws if the daemon refuses
+  void ShutdownDaemon();
+
+ private:
+  std::string Expect(uint32_t expected, const MetricHandler &onMetric = nullptr,
+                     const RefreshHandler &onRefresh = nullptr);
+
+  int fd = -1;
+};
+
+#endif //DPRIVE_ML__TRAIN_PROTOCOL_H_
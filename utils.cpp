@@ -33,6 +33,7 @@
 // support functions added by DBC
 #include "utils.h"
 #include "utils/debug.h"
+#include "data_io.h"
 #include "parameters.h"
 
 //////////////////////////////////////////////////
@@ -112,7 +113,7 @@ Vec OneDMat2Vec(const Mat &inMat) {
 }
 
 ///////////////////////////////////////////////////////////
-CT OneDMat2CtVCC(CC &cc, const Mat &inMat, const int rowSize, const int numSlots, const KeyPair &keys) {
+CT OneDMat2CtVCC(CC &cc, const Mat &inMat, const int rowSize, const int numSlots, const KeyPair &keys, uint32_t level) {
   //verifired
   OPENFHE_DEBUG_FLAG(false);
   OPENFHE_DEBUG("in OneDMat2CtVCC");
@@ -149,7 +150,7 @@ CT OneDMat2CtVCC(CC &cc, const Mat &inMat, const int rowSize, const int numSlots
 //    PrintVecColCloned(inVecCC, colSize);
 //  }
   // make plaintext
-  PT inVecCCPT = cc->MakeCKKSPackedPlaintext(inVecCC); // encode cloned vector
+  PT inVecCCPT = cc->MakeCKKSPackedPlaintext(inVecCC, 1, level); // encode cloned vector
   //encrypt
   CT ctin = cc->Encrypt(keys.publicKey, inVecCCPT);
   return ctin;
@@ -197,7 +198,8 @@ Vec cloneVecRc(const Mat &inMat, const int rowSize, const int numSlots){
   return inVecRC;
 }
 
-CT collateOneDMats2CtVRC(CC &cc, const Mat &inMat, const Mat &inMat2, const int rowSize, const int numSlots, const KeyPair &keys) {
+CT collateOneDMats2CtVRC(CC &cc, const Mat &inMat, const Mat &inMat2, const int rowSize, const int numSlots, const KeyPair &keys,
+                         uint32_t level) {
   if (inMat2.size() != inMat.size() || inMat2[0].size() != inMat[0].size()){
     OPENFHE_THROW(__FILE__ + std::string(" ") + __FUNCTION__ + std::string(":") +
         std::to_string(__LINE__) +
@@ -215,14 +217,14 @@ CT collateOneDMats2CtVRC(CC &cc, const Mat &inMat, const Mat &inMat2, const int
     }
   }
   // make plaintext
-  PT inVecRCPT = cc->MakeCKKSPackedPlaintext(collated);
+  PT inVecRCPT = cc->MakeCKKSPackedPlaintext(collated, 1, level);
   //encrypt
   CT ctin = cc->Encrypt(keys.publicKey, inVecRCPT);
   return ctin;
 }
 
 ///////////////////////////////////////////////////////////
-CT Mat2CtMRM(CC &cc, const Mat &inMat, const int rowSize, const int numSlots, const KeyPair &keys) {
+CT Mat2CtMRM(CC &cc, const Mat &inMat, const int rowSize, const int numSlots, const KeyPair &keys, uint32_t level) {
   // inMat is to be used in a MatrixVectorProductRow so needs to be encrypted as MAT_ROW_MAJOR nfp x nsp
   // inMat is currently a Mat: vector nrows long of vectors (ncol long)
   // so this storage requirement is differnt, instead of rowSize as a limit this packed with colSize as the width limit.
@@ -281,7 +283,7 @@ CT Mat2CtMRM(CC &cc, const Mat &inMat, const int rowSize, const int numSlots, co
 //  if (dbg_flag) {
 //    PrintMatRowMajor(inRMZP, numCols);  //need to verify
 //  }
-  PT inPT = cc->MakeCKKSPackedPlaintext(inRMZP); // encode inPT plaintext matrix
+  PT inPT = cc->MakeCKKSPackedPlaintext(inRMZP, 1, level); // encode inPT plaintext matrix
   auto ctin = cc->Encrypt(keys.publicKey, inPT); //ciphertext in
   return ctin;
 }
@@ -315,20 +317,28 @@ void populateData(
   std::vector<std::string> featureNames;
   std::vector<std::string> labelNames;
 
-  bool normalizeFlag(false); //should this be a command line parameter?
-  LoadDataFile(params.trainXFile, X, featureNames, params.rowsToRead, normalizeFlag);
-  LoadDataFile(params.testXFile, testX, featureNames, params.rowsToRead, normalizeFlag);
-  // We never normalize the labels.
-  LoadDataFile(params.trainYFile, y, labelNames, params.rowsToRead, false);
-  LoadDataFile(params.testYFile, testY, labelNames, params.rowsToRead, false);
-
   //determine dimensions for matrix encryptions
-  usint originalNumSamp = X.size();     //n_samp
-  usint originalNumFeat = X[0].size();  //n_feat (including the intecept column
-
-  if (X.size() != y.size() || testX.size() != testY.size()) {
-    std::cerr << " X and y dimension mismatch!" << std::endl;
-    exit(EXIT_FAILURE);
+  usint originalNumSamp;  //n_samp
+  usint originalNumFeat;  //n_feat (including the intecept column
+  if (params.ctStoreDir.empty()) {
+    bool normalizeFlag(false); //should this be a command line parameter?
+    LoadDataFile(params.trainXFile, X, featureNames, params.rowsToRead, normalizeFlag);
+    LoadDataFile(params.testXFile, testX, featureNames, params.rowsToRead, normalizeFlag);
+    // We never normalize the labels.
+    LoadDataFile(params.trainYFile, y, labelNames, params.rowsToRead, false);
+    LoadDataFile(params.testYFile, testY, labelNames, params.rowsToRead, false);
+
+    originalNumSamp = X.size();
+    originalNumFeat = X[0].size();
+
+    if (X.size() != y.size() || testX.size() != testY.size()) {
+      std::cerr << " X and y dimension mismatch!" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  } else {
+    // With a shard store (-T) the training set is read a shard at a time by BuildShardStore and
+    // the losses stream the CSV files, so nothing is loaded here
+    ReadDataShape(params.trainXFile, params.rowsToRead, originalNumSamp, originalNumFeat);
   }
 
 #ifdef ENABLE_DEBUG
@@ -365,9 +375,12 @@ void populateData(
   usint rowSize = dims.second;
   int signedRowSize = (int) rowSize;
 
-  std::vector<int> rotationIndices = {-signedRowSize, signedRowSize};
-  std::cout << "\tEvalRotate keys" << std::endl;
-  cc->EvalRotateKeyGen(keys.secretKey, rotationIndices);
+  // A refresh server (-s) holds the secret key and has generated these along with the other evaluation keys
+  if (keys.secretKey) {
+    std::vector<int> rotationIndices = {-signedRowSize, signedRowSize};
+    std::cout << "\tEvalRotate keys" << std::endl;
+    cc->EvalRotateKeyGen(keys.secretKey, rotationIndices);
+  }
 
   std::cout << "colSize x rowSize = " << colSize << " * " << rowSize << " = " << colSize * rowSize << std::endl;
 
@@ -420,7 +433,7 @@ void populateData(
     ptExtractThetaMask = cc->MakeCKKSPackedPlaintext(thetaMask);
     ptExtractPhiMask = cc->MakeCKKSPackedPlaintext(phiMask);
   }
-  NegXt = InitializeLogReg(X, y, lrGamma / y.size());
+  if (!X.empty()) NegXt = InitializeLogReg(X, y, lrGamma / y.size());
 
 }
 
@@ -76,17 +76,21 @@ Vec OneDMat2Vec(const Mat &inMat);
 ///////////////////////////////////////////////////////////
 // encode and encrypt a Mat into Ciphertext in MAT_ROW_MAJOR format with zero padding
 // note these functions DO apply zero padding
-CT Mat2CtMRM(CC &cc, const Mat &inMat, const int rowSize, const int numSlots, const KeyPair &keys);
+// level: encrypt with that many towers already dropped, i.e. at the level where the ciphertext is consumed
+CT Mat2CtMRM(CC &cc, const Mat &inMat, const int rowSize, const int numSlots, const KeyPair &keys,
+             uint32_t level = 0);
 
 ///////////////////////////////////////////////////////////
 //  encode and encrypt a One Dimensional Mat into Ciphertext in VEC_COL_CLONED format
 // zero padded out to rowSize, the power of 2 dimension, then cloned to
 // fill out numSlots
-CT OneDMat2CtVCC(CC &cc, const Mat &inMat, const int rowSize, const int numSlots, const KeyPair &keys);
+CT OneDMat2CtVCC(CC &cc, const Mat &inMat, const int rowSize, const int numSlots, const KeyPair &keys,
+                 uint32_t level = 0);
 
 ///////////////////////////////////////////////////////////
 
-CT collateOneDMats2CtVRC(CC &cc, const Mat &inMat, const Mat &inMat2, const int colSize, const int numSlots, const KeyPair &keys);
+CT collateOneDMats2CtVRC(CC &cc, const Mat &inMat, const Mat &inMat2, const int colSize, const int numSlots, const KeyPair &keys,
+                         uint32_t level = 0);
 
 ///////////////////////////////////////////////////////////////
 // Prints out Vector VectorRowCloned